@@ -1,4 +1,3 @@
-
 /*
  * Copyright (c) 2017, EPFL/Blue Brain Project
  *                     Stefan.Eilemann@epfl.ch
@@ -6,12 +5,253 @@
 
 #include <brion/constants.h>
 #include <brion/morphology.h>
+#include <brion/morphologyBinary.h>
 #include <keyv/Map.h>
 #include <lunchbox/daemon.h>
 #include <lunchbox/log.h>
+#include <lunchbox/threadPool.h>
 #include <zeroeq/server.h>
 #include <zeroeq/uri.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <list>
+#include <unordered_map>
+
+namespace
+{
+using brion::Strings;
+using brion::size_ts;
+using Data = servus::Serializable::Data;
+using Datas = std::vector<Data>;
+
+/** In-memory cache size in MB, overridden by $BRION_MORPHOLOGY_CACHE_MB */
+const size_t DEFAULT_CACHE_SIZE = 1024;
+
+/** Least-recently used cache of serialized morphologies. */
+class LRUCache
+{
+public:
+    explicit LRUCache(const size_t maxSize)
+        : _maxSize(maxSize)
+    {
+    }
+
+    bool get(const std::string& key, Data& value)
+    {
+        const auto i = _lookup.find(key);
+        if (i == _lookup.end())
+            return false;
+
+        _entries.splice(_entries.begin(), _entries, i->second);
+        value = i->second->second;
+        return true;
+    }
+
+    void insert(const std::string& key, const Data& value)
+    {
+        if (value.size > _maxSize || _lookup.count(key))
+            return;
+
+        _entries.emplace_front(key, value);
+        _lookup[key] = _entries.begin();
+        _size += value.size;
+        while (_size > _maxSize)
+        {
+            _size -= _entries.back().second.size;
+            _lookup.erase(_entries.back().first);
+            _entries.pop_back();
+        }
+    }
+
+private:
+    using Entry = std::pair<std::string, Data>;
+    std::list<Entry> _entries; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> _lookup;
+    size_t _size = 0;
+    const size_t _maxSize;
+};
+
+/** @return the serialized morphology, or empty data if it can't be loaded */
+Data load(const std::string& path)
+{
+    try
+    {
+        const brion::Morphology morphology{brion::URI(path)};
+        return morphology.toBinary();
+    }
+    catch (const std::exception& e)
+    {
+        LBWARN << "Failed to load " << path << ": " << e.what() << std::endl;
+        return Data();
+    }
+}
+
+/**
+ * @return true if the data is a serialized morphology in the current format.
+ *         Stale or corrupt cache entries are reloaded and overwritten.
+ */
+bool isValid(const Data& data)
+{
+    return data.ptr && brion::binary::getHeader(data.ptr.get(), data.size);
+}
+
+/** @return the null-terminated paths of a batch request */
+Strings splitPaths(const char* data, const size_t size)
+{
+    Strings paths;
+    const char* const end = data + size;
+    while (data < end)
+    {
+        const char* const next = std::find(data, end, '\0');
+        paths.emplace_back(data, next);
+        data = next + 1;
+    }
+    return paths;
+}
+
+/** Serves serialized morphologies from memory, keyv cache or disk. */
+class MorphologyStore
+{
+public:
+    MorphologyStore()
+        : _lru(_getCacheSize())
+        , _cache(keyv::Map::createCache())
+    {
+    }
+
+    Data get(const std::string& path)
+    {
+        Data value;
+        if (_lru.get(path, value))
+        {
+            std::cout << 'm' << std::flush;
+            return value;
+        }
+
+        if (_cache)
+        {
+            _cache->takeValues({path},
+                               [&](const std::string&, char* d, size_t s) {
+                                   value.ptr.reset(d, std::free);
+                                   value.size = s;
+                               });
+            if (isValid(value))
+            {
+                std::cout << 'c' << std::flush;
+                _lru.insert(path, value);
+                return value;
+            }
+        }
+
+        value = load(path);
+        _store(path, value);
+        return value;
+    }
+
+    Datas get(const Strings& paths)
+    {
+        Datas values(paths.size());
+
+        // request indices of all paths not in memory
+        std::unordered_map<std::string, size_ts> pending;
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            if (_lru.get(paths[i], values[i]))
+                std::cout << 'm' << std::flush;
+            else
+                pending[paths[i]].push_back(i);
+        }
+
+        if (_cache && !pending.empty())
+        {
+            Strings keys;
+            keys.reserve(pending.size());
+            for (const auto& i : pending)
+                keys.push_back(i.first);
+
+            _cache->takeValues(keys, [&](const std::string& key, char* d,
+                                         const size_t s) {
+                Data value;
+                value.ptr.reset(d, std::free);
+                value.size = s;
+                if (!isValid(value))
+                    return;
+
+                std::cout << 'c' << std::flush;
+                _lru.insert(key, value);
+                const auto i = pending.find(key);
+                if (i == pending.end())
+                    return;
+                for (const size_t index : i->second)
+                    values[index] = value;
+                pending.erase(i);
+            });
+        }
+
+        // Load and serialize the remaining morphologies in parallel. The
+        // serialized data is shared by the caches and the reply.
+        std::vector<std::pair<std::string, std::future<Data>>> loads;
+        loads.reserve(pending.size());
+        for (const auto& i : pending)
+        {
+            const std::string& path = i.first;
+            loads.emplace_back(path, _workers.post([path] {
+                return load(path);
+            }));
+        }
+        for (auto& i : loads)
+        {
+            const Data value = i.second.get();
+            _store(i.first, value);
+            for (const size_t index : pending[i.first])
+                values[index] = value;
+        }
+        return values;
+    }
+
+private:
+    LRUCache _lru;
+    keyv::MapPtr _cache;
+    lunchbox::ThreadPool _workers;
+
+    static size_t _getCacheSize()
+    {
+        const char* size = getenv("BRION_MORPHOLOGY_CACHE_MB");
+        if (size)
+        {
+            try
+            {
+                return size_t(std::stoull(size)) << 20;
+            }
+            catch (const std::exception& exc)
+            {
+                LBWARN << "Could not set BRION_MORPHOLOGY_CACHE_MB to " << size
+                       << ": " << exc.what() << std::endl;
+            }
+        }
+        return DEFAULT_CACHE_SIZE << 20;
+    }
+
+    void _store(const std::string& path, const Data& value)
+    {
+        if (!value.ptr)
+        {
+            std::cout << 'l' << std::flush;
+            return;
+        }
+
+        _lru.insert(path, value);
+        if (!_cache)
+            std::cout << 'u' << std::flush;
+        else if (_cache->insert(path, value.ptr.get(), value.size))
+            std::cout << 'd' << std::flush;
+        else
+            std::cout << 'e' << std::flush;
+    }
+};
+}
+
 int main(const int argc, char* argv[])
 {
     zeroeq::Server server(argc == 2 ? zeroeq::URI(argv[1]) : zeroeq::URI());
@@ -23,12 +263,13 @@ int main(const int argc, char* argv[])
         << std::endl
         << "  zeroeq://" << address << "/path/to/morphology" << std::endl
         << std::endl
-        << "  [c]ache read, [d]isk read with cache update, disk read "
-           "with cache [e]rror, [u]ncached disk read, morphology [l]oad error: "
+        << "  [m]emory read, [c]ache read, [d]isk read with cache update, "
+           "disk read with cache [e]rror, [u]ncached disk read, morphology "
+           "[l]oad error: "
         << std::flush;
     lunchbox::Log::setOutput(std::string(argv[0]) + ".log");
 
-    auto cache = keyv::Map::createCache();
+    MorphologyStore morphologies;
 
     server.handle(brion::ZEROEQ_GET_MORPHOLOGY, [&](const void* data,
                                                     const size_t size) {
@@ -36,45 +277,21 @@ int main(const int argc, char* argv[])
             return zeroeq::ReplyData();
 
         const std::string path((const char*)data, size);
-        if (cache)
-        {
-            servus::Serializable::Data value;
-            cache->takeValues({path},
-                              [&](const std::string&, char* d, const size_t s) {
-                                  value.ptr.reset(d);
-                                  value.size = s;
-                              });
-
-            if (value.ptr && value.size)
-            {
-                std::cout << 'c' << std::flush;
-                return zeroeq::ReplyData(brion::ZEROEQ_GET_MORPHOLOGY, value);
-            }
-        }
-        try
-        {
-            const brion::Morphology morphology{brion::URI(path)};
-            servus::Serializable::Data bin = morphology.toBinary();
-            if (cache)
-            {
-                if (cache->insert(path, bin.ptr.get(), bin.size))
-                    std::cout << 'd' << std::flush;
-                else
-                    std::cout << 'e' << std::flush;
-            }
-            else
-                std::cout << 'u' << std::flush;
+        const Data value = morphologies.get(path);
+        if (!value.ptr)
+            return zeroeq::ReplyData();
+        return zeroeq::ReplyData(brion::ZEROEQ_GET_MORPHOLOGY, value);
+    });
 
-            return zeroeq::ReplyData(brion::ZEROEQ_GET_MORPHOLOGY,
-                                     morphology.toBinary().clone());
-        }
-        catch (const std::exception& e)
-        {
-            std::cout << 'l' << std::flush;
-            LBWARN << "Failed to load " << path << ": " << e.what()
-                   << std::endl;
+    server.handle(brion::ZEROEQ_GET_MORPHOLOGIES, [&](const void* data,
+                                                      const size_t size) {
+        if (!data || !size)
             return zeroeq::ReplyData();
-        }
+
+        const Strings paths = splitPaths((const char*)data, size);
+        return zeroeq::ReplyData(brion::ZEROEQ_GET_MORPHOLOGIES,
+                                 brion::binary::packBatch(
+                                     morphologies.get(paths)));
     });
 
     while (true)
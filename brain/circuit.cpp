@@ -22,6 +22,7 @@
 
 #include "circuit.h"
 #include "detail/circuit.h"
+#include "detail/transforms.h"
 
 #include "synapsesStream.h"
 #include <boost/algorithm/string.hpp>
@@ -40,8 +41,19 @@ Circuit::Impl* newImpl(const brion::BlueConfig& config)
 #endif
 }
 
+Circuit::Impl* newImpl(const URI& source)
+{
+    lunchbox::Clock clock;
+    const brion::BlueConfig config(source.getPath());
+    const double time = clock.getTimed();
+
+    Circuit::Impl* impl = newImpl(config);
+    impl->_stats->configParse = time;
+    return impl;
+}
+
 Circuit::Circuit(const URI& source)
-    : _impl(newImpl(brion::BlueConfig(source.getPath())))
+    : _impl(newImpl(source))
 {
 }
 
@@ -52,6 +64,23 @@ Circuit::Circuit(const brion::BlueConfig& config)
 
 Circuit::~Circuit()
 {
+    LBDEBUG << "Closing circuit " << _impl->getCircuitSource() << ": "
+            << getStats() << std::endl;
+}
+
+Circuit::Stats Circuit::getStats() const
+{
+    return _impl->getStats();
+}
+
+std::ostream& operator<<(std::ostream& os, const Circuit::Stats& stats)
+{
+    const size_t requests = stats.cacheHits + stats.cacheMisses;
+    return os << "config parse " << stats.configParse << " ms, circuit open "
+              << stats.circuitOpen << " ms, target parse " << stats.targetParse
+              << " ms, synapse open " << stats.synapseOpen
+              << " ms, cache open " << stats.cacheOpen << " ms, cache hits "
+              << stats.cacheHits << "/" << requests;
 }
 
 GIDSet Circuit::getGIDs() const
@@ -64,6 +93,16 @@ GIDSet Circuit::getGIDs(const std::string& target) const
     return _impl->getGIDs(target);
 }
 
+CompactGIDSet Circuit::getCompactGIDs() const
+{
+    return _impl->getCompactGIDs();
+}
+
+CompactGIDSet Circuit::getCompactGIDs(const std::string& target) const
+{
+    return _impl->getCompactGIDs(target);
+}
+
 GIDSet Circuit::getRandomGIDs(const float fraction) const
 {
     return _impl->getRandomGIDs(fraction, "");
@@ -75,9 +114,22 @@ GIDSet Circuit::getRandomGIDs(const float fraction,
     return _impl->getRandomGIDs(fraction, target);
 }
 
+GIDSet Circuit::getStratifiedRandomGIDs(const float fraction,
+                                        const Stratification stratification,
+                                        const std::string& target) const
+{
+    return _impl->getStratifiedRandomGIDs(fraction, stratification, target);
+}
+
+GIDSet Circuit::getStratifiedRandomGIDs(const float fraction,
+                                        const Strings& targets) const
+{
+    return _impl->getStratifiedRandomGIDs(fraction, targets);
+}
+
 URIs Circuit::getMorphologyURIs(const GIDSet& gids) const
 {
-    const Strings& names = _impl->getMorphologyNames(gids);
+    const Strings& names = _impl->queryMorphologyNames(gids);
 
     URIs uris;
     uris.reserve(names.size());
@@ -88,6 +140,20 @@ URIs Circuit::getMorphologyURIs(const GIDSet& gids) const
 
 neuron::Morphologies Circuit::loadMorphologies(const GIDSet& gids,
                                                const Coordinates coords) const
+{
+    return _loadMorphologies(gids, coords, nullptr);
+}
+
+neuron::Morphologies Circuit::loadMorphologies(const GIDSet& gids,
+                                               const Coordinates coords,
+                                               const MorphologyLOD& lod) const
+{
+    return _loadMorphologies(gids, coords, &lod);
+}
+
+neuron::Morphologies Circuit::_loadMorphologies(
+    const GIDSet& gids, const Coordinates coords,
+    const MorphologyLOD* lod) const
 {
     URIs uris = getMorphologyURIs(gids);
     const auto circuitPath =
@@ -110,43 +176,48 @@ neuron::Morphologies Circuit::loadMorphologies(const GIDSet& gids,
         if (transform)
             // store circuit + GID for transformed morphology
             hash += circuitPath + std::to_string(*gid);
+        if (lod)
+            hash += lod->getKey();
 
-        hash = servus::make_uint128(hash + "v2").getString();
+        hash = servus::make_uint128(hash).getString();
         hashes.push_back(hash);
         hashSet.insert(hash);
         ++gid;
     }
 
     CachedMorphologies cached = _impl->loadMorphologiesFromCache(hashSet);
-    using MorphologyUse = std::pair<size_t, brion::MorphologyPtr>;
-    std::unordered_map<std::string, MorphologyUse> loading;
 
-    // resolve missing morphologies
+    // resolve missing morphologies, identical URIs are loaded only once
+    URIs missing;
     for (size_t i = 0; i < uris.size(); ++i)
     {
-        const URI& uri = uris[i];
         const std::string& hash = hashes[i];
-
         if (cached.find(hash) == cached.end())
         {
-            const auto& key = std::to_string(uri);
-            auto load = loading.find(key);
-            if (load == loading.end())
-            { // delay data access to next loop to allow async loading
-                loading.insert(std::make_pair(
-                    key, std::make_pair(1, std::make_shared<brion::Morphology>(
-                                               uri))));
-            }
-            else
-                ++load->second.first;
+            missing.push_back(uris[i]);
             cached.insert(std::make_pair(hash, nullptr));
         }
     }
+    brion::Morphologies loaded = brion::loadMorphologies(missing);
+    if (lod)
+    {
+        // simplify each loaded morphology once, before sharing it
+        std::unordered_map<const brion::Morphology*, brion::MorphologyPtr>
+            simplified;
+        for (auto& morphology : loaded)
+        {
+            auto& lodMorphology = simplified[morphology.get()];
+            if (!lodMorphology)
+                lodMorphology = brion::simplify(*morphology, *lod);
+            morphology = lodMorphology;
+        }
+    }
 
-    // load and transform missing and put them in GID-order into result
+    // wrap missing and put them in GID-order into result
     neuron::Morphologies result;
     result.reserve(uris.size());
     const Matrix4fs transforms = transform ? getTransforms(gids) : Matrix4fs();
+    auto next = loaded.begin();
 
     for (size_t i = 0; i < uris.size(); ++i)
     {
@@ -158,24 +229,12 @@ neuron::Morphologies Circuit::loadMorphologies(const GIDSet& gids,
             result.push_back(it->second);
         else
         {
-            const auto& key = std::to_string(uri);
-            auto& load = loading.find(key)->second;
-            --load.first;
-
-            neuron::MorphologyPtr morphology;
-            if (transform)
-            {
-                if (load.first == 0) // last usage, take existing instance
-                    morphology.reset(
-                        new neuron::Morphology(load.second, transforms[i]));
-                else // make a copy
-                    morphology.reset(new neuron::Morphology(
-                        std::make_shared<brion::Morphology>(*load.second),
-                        transforms[i]));
-            }
-            else
-                // share unmodified brion data
-                morphology.reset(new neuron::Morphology(load.second));
+            // share the unmodified brion data, also between GIDs using the
+            // same morphology with different transformations
+            const brion::ConstMorphologyPtr source = *next++;
+            neuron::MorphologyPtr morphology(
+                transform ? new neuron::Morphology(source, transforms[i])
+                          : new neuron::Morphology(source));
 
             _impl->saveMorphologyToCache(uri.getPath(), hash, morphology);
             it->second = morphology;
@@ -188,12 +247,22 @@ neuron::Morphologies Circuit::loadMorphologies(const GIDSet& gids,
 
 Vector3fs Circuit::getPositions(const GIDSet& gids) const
 {
-    return _impl->getPositions(gids);
+    return _impl->queryPositions(gids);
+}
+
+Vector3fs Circuit::getPositions(const CompactGIDSet& gids) const
+{
+    return _impl->queryPositions(gids);
 }
 
 size_ts Circuit::getMorphologyTypes(const GIDSet& gids) const
 {
-    return _impl->getMTypes(gids);
+    return _impl->queryMTypes(gids);
+}
+
+size_ts Circuit::getMorphologyTypes(const CompactGIDSet& gids) const
+{
+    return _impl->queryMTypes(gids);
 }
 
 Strings Circuit::getMorphologyTypeNames() const
@@ -203,7 +272,12 @@ Strings Circuit::getMorphologyTypeNames() const
 
 size_ts Circuit::getElectrophysiologyTypes(const GIDSet& gids) const
 {
-    return _impl->getETypes(gids);
+    return _impl->queryETypes(gids);
+}
+
+size_ts Circuit::getElectrophysiologyTypes(const CompactGIDSet& gids) const
+{
+    return _impl->queryETypes(gids);
 }
 
 Strings Circuit::getElectrophysiologyTypeNames() const
@@ -211,25 +285,65 @@ Strings Circuit::getElectrophysiologyTypeNames() const
     return _impl->getElectrophysiologyNames();
 }
 
+namespace
+{
+template <typename Matrix, typename GIDs>
+std::vector<Matrix> _getTransforms(const Circuit::Impl& impl, const GIDs& gids)
+{
+    return detail::computeTransforms<Matrix>(impl.queryPositions(gids),
+                                             impl.queryRotations(gids));
+}
+}
+
 Matrix4fs Circuit::getTransforms(const GIDSet& gids) const
 {
-    const Vector3fs& positions = _impl->getPositions(gids);
-    const Quaternionfs& rotations = _impl->getRotations(gids);
-    if (positions.size() != rotations.size())
-        throw std::runtime_error(
-            "Positions not equal rotations for given GIDs");
+    return _getTransforms<Matrix4f>(*_impl, gids);
+}
+
+Matrix4fs Circuit::getTransforms(const CompactGIDSet& gids) const
+{
+    return _getTransforms<Matrix4f>(*_impl, gids);
+}
 
-    Matrix4fs transforms(positions.size());
+Matrix3x4fs Circuit::getAffineTransforms(const GIDSet& gids) const
+{
+    return _getTransforms<Matrix3x4f>(*_impl, gids);
+}
 
-#pragma omp parallel for
-    for (size_t i = 0; i < positions.size(); ++i)
-        transforms[i] = Matrix4f(rotations[i], positions[i]);
-    return transforms;
+Matrix3x4fs Circuit::getAffineTransforms(const CompactGIDSet& gids) const
+{
+    return _getTransforms<Matrix3x4f>(*_impl, gids);
 }
 
 Quaternionfs Circuit::getRotations(const GIDSet& gids) const
 {
-    return _impl->getRotations(gids);
+    return _impl->queryRotations(gids);
+}
+
+Quaternionfs Circuit::getRotations(const CompactGIDSet& gids) const
+{
+    return _impl->queryRotations(gids);
+}
+
+void Circuit::enableAttributeCache(const bool preload)
+{
+    _impl->enableAttributeCache(preload);
+}
+
+GIDSet Circuit::getGIDsInBox(const AABBf& box) const
+{
+    return _impl->getSomaIndex()->findInBox(box);
+}
+
+GIDSet Circuit::getGIDsInSphere(const Vector3f& center,
+                                const float radius) const
+{
+    return _impl->getSomaIndex()->findInSphere(center, radius);
+}
+
+GIDSet Circuit::getNearestGIDs(const Vector3f& point, const size_t count) const
+{
+    return _impl->getSomaIndex()->findNearest(point, count);
 }
 
 size_t Circuit::getNumNeurons() const
@@ -243,6 +357,12 @@ SynapsesStream Circuit::getAfferentSynapses(
     return SynapsesStream(*this, gids, true, prefetch);
 }
 
+SynapsesStream Circuit::getAfferentSynapses(
+    const CompactGIDSet& gids, const SynapsePrefetch prefetch) const
+{
+    return SynapsesStream(*this, gids, true, prefetch);
+}
+
 SynapsesStream Circuit::getExternalAfferentSynapses(
     const GIDSet& gids, const std::string& source,
     const SynapsePrefetch prefetch) const
@@ -250,16 +370,36 @@ SynapsesStream Circuit::getExternalAfferentSynapses(
     return SynapsesStream(*this, gids, source, prefetch);
 }
 
+SynapsesStream Circuit::getExternalAfferentSynapses(
+    const CompactGIDSet& gids, const std::string& source,
+    const SynapsePrefetch prefetch) const
+{
+    return SynapsesStream(*this, gids, source, prefetch);
+}
+
 SynapsesStream Circuit::getEfferentSynapses(
     const GIDSet& gids, const SynapsePrefetch prefetch) const
 {
     return SynapsesStream(*this, gids, false, prefetch);
 }
 
+SynapsesStream Circuit::getEfferentSynapses(
+    const CompactGIDSet& gids, const SynapsePrefetch prefetch) const
+{
+    return SynapsesStream(*this, gids, false, prefetch);
+}
+
 SynapsesStream Circuit::getProjectedSynapses(
     const GIDSet& preGIDs, const GIDSet& postGIDs,
     const SynapsePrefetch prefetch) const
 {
     return SynapsesStream(*this, preGIDs, postGIDs, prefetch);
 }
+
+SynapsesStream Circuit::getProjectedSynapses(
+    const CompactGIDSet& preGIDs, const CompactGIDSet& postGIDs,
+    const SynapsePrefetch prefetch) const
+{
+    return SynapsesStream(*this, preGIDs, postGIDs, prefetch);
+}
 }
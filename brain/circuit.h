@@ -45,6 +45,32 @@ public:
         local
     };
 
+    /** Cell property used to stratify random GID samples. @version 3.0 */
+    enum class Stratification
+    {
+        morphologyType,
+        electrophysiologyType
+    };
+
+    /**
+     * Time spent opening the resources of the circuit and usage of the
+     * morphology and synapse position cache.
+     *
+     * Except for the BlueConfig, all resources are opened on first use. Times
+     * are in milliseconds and zero for resources which were not opened yet.
+     * @version 3.0
+     */
+    struct Stats
+    {
+        double configParse = 0; //!< 0 if constructed from a BlueConfig
+        double circuitOpen = 0; //!< opening the MVD2 or MVD3 file
+        double targetParse = 0; //!< parsing all target files
+        double synapseOpen = 0; //!< opening all synapse files
+        double cacheOpen = 0;   //!< connecting to the keyv cache
+        size_t cacheHits = 0;   //!< items loaded from the cache
+        size_t cacheMisses = 0; //!< items not found in the cache
+    };
+
     /**
      * Opens a circuit for read access.
      *
@@ -58,8 +84,12 @@ public:
      */
     BRAIN_API explicit Circuit(const brion::BlueConfig& blueConfig);
 
+    /** Logs the Stats of the circuit at the debug level. */
     BRAIN_API ~Circuit();
 
+    /** @return the statistics accumulated so far. @version 3.0 */
+    BRAIN_API Stats getStats() const;
+
     /**
      * @return The \if pybind array \else set \endif of GIDs for the given
      *         target name.
@@ -72,6 +102,16 @@ public:
      */
     BRAIN_API GIDSet getGIDs() const;
 
+    /**
+     * @return The compact set of GIDs for the given target name.
+     * @throw std::runtime_error if the target cannot be found.
+     * @version 3.0
+     */
+    BRAIN_API CompactGIDSet getCompactGIDs(const std::string& target) const;
+
+    /** @return The compact set of all GIDs held by the circuit. @version 3.0 */
+    BRAIN_API CompactGIDSet getCompactGIDs() const;
+
     /**
      * @return A random fraction of GIDs from the given target name.
      * @env BRAIN_CIRCUIT_SEED set the seed for deterministic randomness
@@ -88,6 +128,31 @@ public:
      */
     BRAIN_API GIDSet getRandomGIDs(float fraction) const;
 
+    /**
+     * @return A random fraction of GIDs from the given target name, sampled
+     *         separately from the cells of each morphology or
+     *         electrophysiology type. The whole circuit is sampled if the
+     *         target name is empty.
+     * @env BRAIN_CIRCUIT_SEED set the seed for deterministic randomness
+     * @throw std::runtime_error if the fraction is not in the range [0,1].
+     * @throw std::runtime_error if the target cannot be found.
+     * @version 3.0
+     */
+    BRAIN_API GIDSet getStratifiedRandomGIDs(
+        float fraction, Stratification stratification,
+        const std::string& target = std::string()) const;
+
+    /**
+     * @return The union of a random fraction of GIDs sampled separately from
+     *         each given target.
+     * @env BRAIN_CIRCUIT_SEED set the seed for deterministic randomness
+     * @throw std::runtime_error if the fraction is not in the range [0,1].
+     * @throw std::runtime_error if a target cannot be found.
+     * @version 3.0
+     */
+    BRAIN_API GIDSet getStratifiedRandomGIDs(float fraction,
+                                             const Strings& targets) const;
+
     /** @return The set of URIs to access the morphologies of the given cells */
     BRAIN_API URIs getMorphologyURIs(const GIDSet& gids) const;
 
@@ -100,15 +165,30 @@ public:
     BRAIN_API neuron::Morphologies loadMorphologies(const GIDSet& gids,
                                                     Coordinates coords) const;
 
+    /**
+     * @return The list of morphologies for the GID set, simplified to the
+     *         given level of detail using brion::simplify(). Simplified
+     *         morphologies are cached separately for each level of detail.
+     * @sa loadMorphologies(const GIDSet&, Coordinates)
+     * @version 3.0
+     */
+    BRAIN_API neuron::Morphologies loadMorphologies(
+        const GIDSet& gids, Coordinates coords,
+        const MorphologyLOD& lod) const;
+
     /** @return The positions of the given cells in the iteration order of the
      *          input gids.
      */
     BRAIN_API Vector3fs getPositions(const GIDSet& gids) const;
+    /** @copydoc getPositions(const GIDSet&) const @version 3.0 */
+    BRAIN_API Vector3fs getPositions(const CompactGIDSet& gids) const;
 
     /** @return The morphology type indices of the given cells in the iteration
      *          order of the input gids.
      */
     BRAIN_API size_ts getMorphologyTypes(const GIDSet& gids) const;
+    /** @copydoc getMorphologyTypes(const GIDSet&) const @version 3.0 */
+    BRAIN_API size_ts getMorphologyTypes(const CompactGIDSet& gids) const;
 
     /**
      * @return The morphology type names of the circuit, indexed by
@@ -120,6 +200,10 @@ public:
      *          iteration order of the input gids.
      */
     BRAIN_API size_ts getElectrophysiologyTypes(const GIDSet& gids) const;
+    /** @copydoc getElectrophysiologyTypes(const GIDSet&) const
+     *  @version 3.0 */
+    BRAIN_API size_ts getElectrophysiologyTypes(
+        const CompactGIDSet& gids) const;
 
     /**
      * @return The electrophysiology type names of the circuit, indexed by
@@ -132,11 +216,70 @@ public:
      *          iteration order.
      */
     BRAIN_API Matrix4fs getTransforms(const GIDSet& gids) const;
+    /** @copydoc getTransforms(const GIDSet&) const @version 3.0 */
+    BRAIN_API Matrix4fs getTransforms(const CompactGIDSet& gids) const;
+
+    /**
+     * @return \if pybind A Nx3x4 numpy array with the \else The \endif
+     *         local to world transformations of the given cells in their
+     *         iteration order, without the constant last row of
+     *         getTransforms().
+     * @version 3.0
+     */
+    BRAIN_API Matrix3x4fs getAffineTransforms(const GIDSet& gids) const;
+    /** @copydoc getAffineTransforms(const GIDSet&) const @version 3.0 */
+    BRAIN_API Matrix3x4fs getAffineTransforms(const CompactGIDSet& gids) const;
 
     /** @return \if pybind A Nx4 numpy array with the \else The \endif
      *          local to world rotation of the given cells.
      */
     BRAIN_API Quaternionfs getRotations(const GIDSet& gids) const;
+    /** @copydoc getRotations(const GIDSet&) const @version 3.0 */
+    BRAIN_API Quaternionfs getRotations(const CompactGIDSet& gids) const;
+
+    /**
+     * Keep the neuron attributes of the whole circuit in memory.
+     *
+     * Once enabled, the first query of positions, rotations, morphology or
+     * electrophysiology types or morphology names reads that attribute for all
+     * neurons of the circuit. Subsequent queries, including getTransforms()
+     * and getMorphologyURIs(), gather from memory instead of reading the
+     * circuit file again.
+     *
+     * @param preload read all attributes now instead of on first query.
+     * @version 3.0
+     */
+    BRAIN_API void enableAttributeCache(bool preload = false);
+
+    /**
+     * @return The GIDs of the cells whose soma position lies inside the
+     *         given box, boundaries included.
+     *
+     * The first spatial query builds an index over the soma positions of
+     * all cells, which is kept for subsequent queries.
+     * @version 3.0
+     */
+    BRAIN_API GIDSet getGIDsInBox(const AABBf& box) const;
+
+    /**
+     * @return The GIDs of the cells whose soma position lies inside the
+     *         given sphere, boundaries included.
+     * @sa getGIDsInBox()
+     * @version 3.0
+     */
+    BRAIN_API GIDSet getGIDsInSphere(const Vector3f& center,
+                                     float radius) const;
+
+    /**
+     * @return The GIDs of the count cells with the soma position nearest to
+     *         the given point, or all cells if the circuit has fewer. Cells
+     *         at the same distance as the farthest one returned may be
+     *         returned instead of each other.
+     * @sa getGIDsInBox()
+     * @version 3.0
+     */
+    BRAIN_API GIDSet getNearestGIDs(const Vector3f& point,
+                                    size_t count) const;
 
     /** @return The number of neurons in the circuit. */
     BRAIN_API size_t getNumNeurons() const;
@@ -156,6 +299,11 @@ public:
         const GIDSet& gids,
         SynapsePrefetch prefetch = SynapsePrefetch::none) const;
 
+    /** @copydoc getAfferentSynapses @version 3.0 */
+    BRAIN_API SynapsesStream getAfferentSynapses(
+        const CompactGIDSet& gids,
+        SynapsePrefetch prefetch = SynapsePrefetch::none) const;
+
     /**
      * Access all afferent synapses projected from another circuit into the
      * given GIDs.
@@ -177,6 +325,11 @@ public:
         const GIDSet& gids, const std::string& source,
         SynapsePrefetch prefetch = SynapsePrefetch::none) const;
 
+    /** @copydoc getExternalAfferentSynapses @version 3.0 */
+    BRAIN_API SynapsesStream getExternalAfferentSynapses(
+        const CompactGIDSet& gids, const std::string& source,
+        SynapsePrefetch prefetch = SynapsePrefetch::none) const;
+
     /**
      * Access all efferent synapses of the given GIDs.
      *
@@ -192,6 +345,11 @@ public:
         const GIDSet& gids,
         SynapsePrefetch prefetch = SynapsePrefetch::none) const;
 
+    /** @copydoc getEfferentSynapses @version 3.0 */
+    BRAIN_API SynapsesStream getEfferentSynapses(
+        const CompactGIDSet& gids,
+        SynapsePrefetch prefetch = SynapsePrefetch::none) const;
+
     /**
      * Access all synapses along the projection from the pre- to the postGIDs.
      *
@@ -208,6 +366,11 @@ public:
         const GIDSet& preGIDs, const GIDSet& postGIDs,
         SynapsePrefetch prefetch = SynapsePrefetch::none) const;
 
+    /** @copydoc getProjectedSynapses @version 3.0 */
+    BRAIN_API SynapsesStream getProjectedSynapses(
+        const CompactGIDSet& preGIDs, const CompactGIDSet& postGIDs,
+        SynapsePrefetch prefetch = SynapsePrefetch::none) const;
+
     class Impl; //!< @internal, public for inheritance MVD2/3 impls
 
 private:
@@ -216,6 +379,14 @@ private:
 
     friend class Synapses;
     std::unique_ptr<const Impl> _impl;
+
+    neuron::Morphologies _loadMorphologies(const GIDSet& gids,
+                                           Coordinates coords,
+                                           const MorphologyLOD* lod) const;
 };
+
+/** Output the given statistics in a human-readable form. @version 3.0 */
+BRAIN_API std::ostream& operator<<(std::ostream& os,
+                                   const Circuit::Stats& stats);
 }
 #endif
@@ -21,6 +21,8 @@
 #include "compartmentReport.h"
 #include "detail/compartmentReport.h"
 
+#include <brion/compactGIDSet.h>
+
 namespace brain
 {
 CompartmentReport::CompartmentReport(const brion::URI& uri)
@@ -47,6 +49,12 @@ CompartmentReportView CompartmentReport::createView(const brion::GIDSet& cells)
     return CompartmentReportView(_impl, cells);
 }
 
+CompartmentReportView CompartmentReport::createView(
+    const CompactGIDSet& cells)
+{
+    return CompartmentReportView(_impl, cells.toGIDSet());
+}
+
 CompartmentReportView CompartmentReport::createView()
 {
     return CompartmentReportView(_impl, {});
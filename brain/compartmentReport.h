@@ -117,6 +117,9 @@ public:
      */
     BRAIN_API CompartmentReportView createView(const GIDSet& gids);
 
+    /** @copydoc createView(const GIDSet&) @version 3.0 */
+    BRAIN_API CompartmentReportView createView(const CompactGIDSet& gids);
+
     /**
      * Create a view with all the neurons in the report.
      *
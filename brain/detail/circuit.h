@@ -20,17 +20,23 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "randomSample.h"
+#include "somaIndex.h"
+
 #include <brain/neuron/morphology.h>
 #include <brion/blueConfig.h>
 #include <brion/circuit.h>
+#include <brion/compactGIDSet.h>
 #include <brion/detail/lockHDF5.h>
 #include <brion/detail/silenceHDF5.h>
 #include <brion/morphology.h>
+#include <brion/morphologyLOD.h>
 #include <brion/synapse.h>
 #include <brion/synapseSummary.h>
 #include <brion/target.h>
 
 #include <keyv/Map.h>
+#include <lunchbox/clock.h>
 #include <lunchbox/lockable.h>
 #include <lunchbox/log.h>
 #include <lunchbox/scopedMutex.h>
@@ -42,8 +48,9 @@
 
 #include <boost/filesystem.hpp>
 
+#include <atomic>
 #include <future>
-#include <random>
+#include <numeric>
 #include <unordered_map>
 
 namespace fs = boost::filesystem;
@@ -62,35 +69,58 @@ const std::string extraFilename("/nrn_extra.h5");
 namespace
 {
 #ifdef BRAIN_USE_MVD3
-bool isSequence(const GIDSet& gids)
-{
-    return (*gids.rbegin() - *gids.begin() + 1) == gids.size();
-}
+/**
+ * Unused GIDs between two requested ones up to which both are read in one
+ * range. Larger gaps start a new range, so sparse sets read in proportion to
+ * their size instead of their GID span.
+ */
+const size_t MVD3_MAX_GAP = 256;
 
-::MVD3::Range getRange(const GIDSet& gids)
+/** A contiguous range read from an MVD3 file for the next count GIDs. */
+struct ReadRun
 {
-    const size_t offset = (*gids.begin());
-    const size_t count = *gids.rbegin() - offset + 1;
-    return ::MVD3::Range(offset - 1, count);
-}
+    ::MVD3::Range range;
+    size_t count;
+};
+typedef std::vector<ReadRun> ReadPlan;
 
-template <typename SrcArray, typename DstArray, typename AssignOp>
-void assign(const ::MVD3::Range& range, const GIDSet& gids, SrcArray& src,
-            DstArray& dst, const AssignOp& assignOp)
+/** @return the coalesced ranges to read for the given GIDs, in GID order. */
+ReadPlan planReads(const GIDSet& gids)
 {
-    if (isSequence(gids)) // OPT: no holes, no translation needed
-    {
-        std::transform(src.begin(), src.end(), dst.begin(), assignOp);
-        return;
+    ReadPlan plan;
+    GIDSet::const_iterator i = gids.begin();
+    while (i != gids.end())
+    {
+        const size_t first = *i;
+        size_t last = first;
+        size_t count = 0;
+        for (; i != gids.end() && *i - last <= MVD3_MAX_GAP + 1; ++i)
+        {
+            last = *i;
+            ++count;
+        }
+        plan.push_back({::MVD3::Range(first - 1, last - first + 1), count});
     }
+    return plan;
+}
 
+/**
+ * Read the given GIDs run by run and scatter them to dst.
+ *
+ * @param read returns the source array for a range
+ * @param assignOp converts a source element to a dst element
+ */
+template <typename ReadOp, typename DstArray, typename AssignOp>
+void readSparse(const GIDSet& gids, const ReadOp& read, DstArray& dst,
+                const AssignOp& assignOp)
+{
+    GIDSet::const_iterator gid = gids.begin();
     typename DstArray::iterator dst_it = dst.begin();
-    for (GIDSet::const_iterator i = gids.begin(); i != gids.end(); ++i)
+    for (const ReadRun& run : planReads(gids))
     {
-        typename SrcArray::const_iterator src_it = src.begin();
-        std::advance(src_it, *i - range.offset - 1);
-        *dst_it = assignOp(*src_it);
-        ++dst_it;
+        const auto& src = read(run.range);
+        for (size_t i = 0; i < run.count; ++i, ++gid, ++dst_it)
+            *dst_it = assignOp(src[*gid - run.range.offset - 1]);
     }
 }
 
@@ -109,37 +139,12 @@ size_t nop(const size_t& in)
 {
     return in;
 }
-#endif
 
 std::string toString(const std::string& in)
 {
     return in;
 }
-size_t toSize_t(const std::string& in)
-{
-    return std::stoul(in);
-}
-
-template <typename T>
-void _shuffle(T& container)
-{
-    std::random_device randomDevice;
-    std::mt19937_64 randomEngine(randomDevice());
-    const char* seedEnv = getenv("BRAIN_CIRCUIT_SEED");
-    if (seedEnv)
-    {
-        try
-        {
-            randomEngine.seed(std::stoul(seedEnv));
-        }
-        catch (const std::exception& exc)
-        {
-            LBWARN << "Could not set BRAIN_CIRCUIT_SEED to " << seedEnv << ": "
-                   << exc.what() << std::endl;
-        }
-    }
-    std::shuffle(container.begin(), container.end(), randomEngine);
-}
+#endif
 
 using CachedMorphologies =
     std::unordered_map<std::string, neuron::MorphologyPtr>;
@@ -154,7 +159,6 @@ public:
         , _morphologySource(config.getMorphologySource())
         , _synapseSource(config.getSynapseSource())
         , _targetSources(config.getTargetSources())
-        , _cache(keyv::Map::createCache())
         , _synapsePositionColumns(0)
     {
         for (auto&& projection :
@@ -169,47 +173,95 @@ public:
     virtual size_t getNumNeurons() const = 0;
 
     const brion::URI& getCircuitSource() const { return _circuitSource; }
+    Circuit::Stats getStats() const
+    {
+        lunchbox::ScopedWrite mutex(_stats);
+        return *_stats;
+    }
+
     GIDSet getGIDs() const
     {
         brain::GIDSet gids;
         brain::GIDSet::const_iterator hint = gids.begin();
-        for (uint32_t i = 0; i < getNumNeurons(); ++i)
+        const size_t size = getNumNeurons();
+        for (uint32_t i = 0; i < size; ++i)
             hint = gids.insert(hint, i + 1);
         return gids;
     }
 
+    CompactGIDSet getCompactGIDs() const
+    {
+        uint32_ts gids(getNumNeurons());
+        std::iota(gids.begin(), gids.end(), 1);
+        return CompactGIDSet(std::move(gids));
+    }
+
     GIDSet getGIDs(const std::string& target) const
     {
-        if (_targetParsers.empty())
+        return brion::Target::parse(_getTargetParsers(), target);
+    }
+
+    CompactGIDSet getCompactGIDs(const std::string& target) const
+    {
+        return brion::Target::parseCompact(_getTargetParsers(), target);
+    }
+
+    GIDSet getRandomGIDs(const float fraction, const std::string& target) const
+    {
+        _checkFraction(fraction);
+        detail::RandomEngine engine = detail::createRandomEngine();
+        if (!target.empty())
         {
-            for (const URI& uri : _targetSources)
-            {
-                try
-                {
-                    _targetParsers.push_back(brion::Target(uri.getPath()));
-                }
-                catch (const std::runtime_error& exc)
-                {
-                    LBWARN << "Failed to load targets from " << uri.getPath()
-                           << ": " << exc.what() << std::endl;
-                }
-            }
+            const uint32_ts& sample =
+                detail::sampleGIDs(getCompactGIDs(target).getGIDs(), fraction,
+                                   engine);
+            return GIDSet(sample.begin(), sample.end());
         }
-        return brion::Target::parse(_targetParsers, target);
+
+        // GIDs of the circuit are the indices plus one
+        const size_t size = getNumNeurons();
+        const uint32_ts& indices = detail::sampleIndices(
+            size, detail::getSampleSize(size, fraction), engine);
+        GIDSet gids;
+        for (const uint32_t index : indices)
+            gids.emplace_hint(gids.end(), index + 1);
+        return gids;
     }
 
-    GIDSet getRandomGIDs(const float fraction, const std::string& target) const
+    GIDSet getStratifiedRandomGIDs(const float fraction,
+                                   const Circuit::Stratification by,
+                                   const std::string& target) const
     {
-        if (fraction < 0.f || fraction > 1.f)
-            LBTHROW(
-                std::runtime_error("Fraction for getRandomGIDs() must be "
-                                   "in the range [0,1]"));
+        _checkFraction(fraction);
+        const CompactGIDSet gids =
+            target.empty() ? getCompactGIDs() : getCompactGIDs(target);
+        const size_ts types =
+            by == Circuit::Stratification::morphologyType
+                ? queryMTypes(gids)
+                : queryETypes(gids);
 
-        const GIDSet& gids = target.empty() ? getGIDs() : getGIDs(target);
-        uint32_ts randomGids(gids.begin(), gids.end());
-        _shuffle(randomGids);
-        randomGids.resize(size_t(std::ceil(randomGids.size() * fraction)));
-        return GIDSet(randomGids.begin(), randomGids.end());
+        std::vector<uint32_ts> strata;
+        for (size_t i = 0; i < types.size(); ++i)
+        {
+            if (types[i] >= strata.size())
+                strata.resize(types[i] + 1);
+            strata[types[i]].push_back(gids[i]);
+        }
+        detail::RandomEngine engine = detail::createRandomEngine();
+        return detail::sampleStrata(strata, fraction, engine);
+    }
+
+    GIDSet getStratifiedRandomGIDs(const float fraction,
+                                   const Strings& targets) const
+    {
+        _checkFraction(fraction);
+        std::vector<uint32_ts> strata;
+        strata.reserve(targets.size());
+        for (const std::string& target : targets)
+            strata.push_back(getCompactGIDs(target).getGIDs());
+
+        detail::RandomEngine engine = detail::createRandomEngine();
+        return detail::sampleStrata(strata, fraction, engine);
     }
 
     virtual Vector3fs getPositions(const GIDSet& gids) const = 0;
@@ -220,6 +272,58 @@ public:
     virtual Quaternionfs getRotations(const GIDSet& gids) const = 0;
     virtual Strings getMorphologyNames(const GIDSet& gids) const = 0;
 
+    /** @name Attribute queries, gathered from memory if cached */
+    //@{
+    template <typename GIDs>
+    Vector3fs queryPositions(const GIDs& gids) const
+    {
+        return _query(_positions, gids, &Impl::getPositions);
+    }
+    template <typename GIDs>
+    size_ts queryMTypes(const GIDs& gids) const
+    {
+        return _query(_mtypes, gids, &Impl::getMTypes);
+    }
+    template <typename GIDs>
+    size_ts queryETypes(const GIDs& gids) const
+    {
+        return _query(_etypes, gids, &Impl::getETypes);
+    }
+    template <typename GIDs>
+    Quaternionfs queryRotations(const GIDs& gids) const
+    {
+        return _query(_rotations, gids, &Impl::getRotations);
+    }
+    template <typename GIDs>
+    Strings queryMorphologyNames(const GIDs& gids) const
+    {
+        return _query(_morphologyNames, gids, &Impl::getMorphologyNames);
+    }
+    //@}
+
+    /** @return the soma index over all cells, built on first use. */
+    std::shared_ptr<const detail::SomaIndex> getSomaIndex() const
+    {
+        lunchbox::ScopedWrite mutex(_somaIndex);
+        if (!*_somaIndex)
+            _somaIndex->reset(
+                new detail::SomaIndex(queryPositions(getCompactGIDs())));
+        return *_somaIndex;
+    }
+
+    void enableAttributeCache(const bool preload) const
+    {
+        _cacheAttributes = true;
+        if (!preload)
+            return;
+
+        _getColumn(_positions, &Impl::getPositions);
+        _getColumn(_mtypes, &Impl::getMTypes);
+        _getColumn(_etypes, &Impl::getETypes);
+        _getColumn(_rotations, &Impl::getRotations);
+        _getColumn(_morphologyNames, &Impl::getMorphologyNames);
+    }
+
     URI getMorphologyURI(const std::string& name) const
     {
         URI uri(_morphologySource);
@@ -229,24 +333,20 @@ public:
 
     const brion::SynapseSummary& getSynapseSummary() const
     {
-        lunchbox::ScopedWrite mutex(_synapseSummary);
-
-        if (!(*_synapseSummary))
-            _synapseSummary->reset(new brion::SynapseSummary(
-                _synapseSource.getPath() + summaryFilename));
-        return **_synapseSummary;
+        return _open(_synapseSummary, &Circuit::Stats::synapseOpen, [&] {
+            return new brion::SynapseSummary(_synapseSource.getPath() +
+                                             summaryFilename);
+        });
     }
 
     const brion::Synapse& getSynapseAttributes(const bool afferent) const
     {
         const size_t i = afferent ? 0 : 1;
-        lunchbox::ScopedWrite mutex(_synapseAttributes[i]);
-
-        if (!(*_synapseAttributes[i]))
-            _synapseAttributes[i]->reset(new brion::Synapse(
+        return _open(_synapseAttributes[i], &Circuit::Stats::synapseOpen, [&] {
+            return new brion::Synapse(
                 _synapseSource.getPath() +
-                (afferent ? afferentFilename : efferentFilename)));
-        return **_synapseAttributes[i];
+                (afferent ? afferentFilename : efferentFilename));
+        });
     }
 
     const brion::Synapse& getAfferentProjectionAttributes(
@@ -265,12 +365,12 @@ public:
                     "Afferent synaptic projection not found: " + name));
             }
             fs::path path(source->second.getPath() + externalAfferentFilename);
-            if (fs::exists(path) && fs::is_regular_file(fs::canonical(path)))
-                synapses.reset(new brion::Synapse(path.string()));
-            else
+            if (!fs::exists(path) || !fs::is_regular_file(fs::canonical(path)))
                 // Trying with the afferent synapses filename as a fallback
-                synapses.reset(new brion::Synapse(source->second.getPath() +
-                                                  afferentFilename));
+                path = source->second.getPath() + afferentFilename;
+            synapses.reset(_timed(&Circuit::Stats::synapseOpen, [&] {
+                return new brion::Synapse(path.string());
+            }));
         }
         return *synapses;
     }
@@ -283,8 +383,11 @@ public:
         {
             try
             {
-                _synapseExtra->reset(new brion::Synapse(
-                    _synapseSource.getPath() + extraFilename));
+                _synapseExtra->reset(
+                    _timed(&Circuit::Stats::synapseOpen, [&] {
+                        return new brion::Synapse(_synapseSource.getPath() +
+                                                  extraFilename);
+                    }));
             }
             catch (...)
             {
@@ -301,10 +404,13 @@ public:
 
         auto& positions = *_synapsePositions[i];
         if (!positions)
-            positions.reset(
-                new brion::Synapse(_synapseSource.getPath() +
-                                   (afferent ? afferentPositionsFilename
-                                             : efferentPositionsFilename)));
+        {
+            const std::string& filename = afferent ? afferentPositionsFilename
+                                                   : efferentPositionsFilename;
+            positions.reset(_timed(&Circuit::Stats::synapseOpen, [&] {
+                return new brion::Synapse(_synapseSource.getPath() + filename);
+            }));
+        }
 
         if (_synapsePositionColumns == 0)
             _synapsePositionColumns = positions->getNumAttributes();
@@ -316,11 +422,12 @@ public:
     void saveMorphologyToCache(const std::string& uri, const std::string& hash,
                                neuron::MorphologyPtr morphology) const
     {
-        if (!_cache)
+        keyv::Map* cache = _getCache();
+        if (!cache)
             return;
 
         servus::Serializable::Data data = morphology->toBinary();
-        if (!_cache->insert(hash, data.ptr.get(), data.size))
+        if (!cache->insert(hash, data.ptr.get(), data.size))
         {
             LBWARN << "Failed to insert morphology " << uri
                    << " into cache; item size is " << float(data.size) / LB_1MB
@@ -332,7 +439,8 @@ public:
         const std::set<std::string>& hashes) const
     {
         CachedMorphologies loaded;
-        if (!_cache)
+        keyv::Map* cache = _getCache();
+        if (!cache)
             return loaded;
 
         LBDEBUG << "Using cache for morphology loading" << std::endl;
@@ -343,18 +451,32 @@ public:
         Strings keys(hashes.begin(), hashes.end());
         futures.reserve(keys.size());
 
-        _cache->takeValues(keys, [&futures](const std::string& key, char* data,
-                                            const size_t size) {
+        cache->takeValues(keys, [&futures](const std::string& key, char* data,
+                                           const size_t size) {
             futures.push_back(std::async([key, data, size] {
-                neuron::MorphologyPtr morphology(
-                    new neuron::Morphology(data, size));
+                neuron::MorphologyPtr morphology;
+                try
+                {
+                    morphology.reset(new neuron::Morphology(data, size));
+                }
+                catch (const std::runtime_error&)
+                {
+                    // stale or corrupt entry, reload and overwrite it
+                    LBDEBUG << "Ignoring invalid cached morphology " << key
+                            << std::endl;
+                }
                 std::free(data);
                 return std::make_pair(key, morphology);
             }));
         });
 
         for (auto& future : futures)
-            loaded.insert(future.get());
+        {
+            auto entry = future.get();
+            if (entry.second)
+                loaded.insert(entry);
+        }
+        _countCacheHits(loaded.size(), hashes.size());
 
         LBINFO << "Loaded " << loaded.size() << " morphologies from cache, "
                << "loading " << hashes.size() - loaded.size()
@@ -366,11 +488,12 @@ public:
                                      const std::string& hash,
                                      const brion::SynapseMatrix& value) const
     {
-        if (!_cache)
+        keyv::Map* cache = _getCache();
+        if (!cache)
             return;
 
         const size_t size = value.num_elements() * sizeof(float);
-        if (!_cache->insert(hash, value.data(), size))
+        if (!cache->insert(hash, value.data(), size))
         {
             LBWARN << "Failed to insert synapse positions for GID " << gid
                    << " into cache; item size is " << float(size) / LB_1MB
@@ -381,7 +504,8 @@ public:
     CachedSynapses loadSynapsePositionsFromCache(const Strings& keys) const
     {
         CachedSynapses loaded;
-        if (!_cache)
+        keyv::Map* cache = _getCache();
+        if (!cache)
             return loaded;
 
         LBDEBUG << "Using cache for synapses position loading" << std::endl;
@@ -393,9 +517,9 @@ public:
 
         _findSynapsePositionsColumns();
 
-        _cache->takeValues(keys, [this, &futures](const std::string& key,
-                                                  char* data,
-                                                  const size_t size) {
+        cache->takeValues(keys, [this, &futures](const std::string& key,
+                                                 char* data,
+                                                 const size_t size) {
             futures.push_back(std::async([this, key, data, size] {
                 // there is no constructor in multi_array which just accepts the
                 // size in bytes (although there's a getter for it used in
@@ -413,6 +537,7 @@ public:
 
         for (auto& future : futures)
             loaded.insert(future.get());
+        _countCacheHits(loaded.size(), keys.size());
 
         LBDEBUG << "Loaded synapse positions for " << loaded.size()
                 << " out of " << keys.size() << " neurons from cache"
@@ -424,8 +549,11 @@ public:
     {
         lunchbox::ScopedWrite mutex(_synapsePositions[0]);
         if (!(*_synapsePositions[0]))
-            _synapsePositions[0]->reset(new brion::Synapse(
-                _synapseSource.getPath() + afferentPositionsFilename));
+            _synapsePositions[0]->reset(
+                _timed(&Circuit::Stats::synapseOpen, [&] {
+                    return new brion::Synapse(_synapseSource.getPath() +
+                                              afferentPositionsFilename);
+                }));
         _synapsePositionColumns = (*_synapsePositions[0])->getNumAttributes();
     }
 
@@ -434,12 +562,99 @@ public:
     const brion::URI _synapseSource;
     std::unordered_map<std::string, brion::URI> _afferentProjectionSources;
     const brion::URIs _targetSources;
-    mutable brion::Targets _targetParsers;
-    mutable keyv::MapPtr _cache;
+    mutable lunchbox::Lockable<brion::Targets> _targetParsers;
+    mutable lunchbox::Lockable<keyv::MapPtr> _cache;
+    mutable bool _cacheCreated = false;
+    mutable lunchbox::Lockable<Circuit::Stats> _stats;
+
+    /** @return open(), adding its run time to the given time of _stats. */
+    template <typename Func>
+    auto _timed(double Circuit::Stats::*time, const Func& open) const
+        -> decltype(open())
+    {
+        lunchbox::Clock clock;
+        auto result = open();
+        const double elapsed = clock.getTimed();
+        lunchbox::ScopedWrite mutex(_stats);
+        (*_stats).*time += elapsed;
+        return result;
+    }
+
+    void _countCacheHits(const size_t hits, const size_t requests) const
+    {
+        lunchbox::ScopedWrite mutex(_stats);
+        _stats->cacheHits += hits;
+        _stats->cacheMisses += requests - hits;
+    }
+
+    /** @return the cache, connected on first use, or nullptr if disabled. */
+    keyv::Map* _getCache() const
+    {
+        lunchbox::ScopedWrite mutex(_cache);
+        if (!_cacheCreated)
+        {
+            *_cache = _timed(&Circuit::Stats::cacheOpen,
+                             [] { return keyv::Map::createCache(); });
+            _cacheCreated = true;
+        }
+        return _cache->get();
+    }
+
+    /** Fail early on missing circuit files, which are opened on first use. */
+    void _checkCircuitSource() const
+    {
+        if (!fs::exists(_circuitSource.getPath()))
+            LBTHROW(std::runtime_error("Circuit file not found: " +
+                                       _circuitSource.getPath()));
+    }
+
+    static void _checkFraction(const float fraction)
+    {
+        if (fraction < 0.f || fraction > 1.f)
+            LBTHROW(
+                std::runtime_error("Fraction for getRandomGIDs() must be "
+                                   "in the range [0,1]"));
+    }
+
+    const brion::Targets& _getTargetParsers() const
+    {
+        lunchbox::ScopedWrite mutex(_targetParsers);
+        if (_targetParsers->empty())
+        {
+            lunchbox::Clock clock;
+            for (const URI& uri : _targetSources)
+            {
+                try
+                {
+                    _targetParsers->push_back(brion::Target(uri.getPath()));
+                }
+                catch (const std::runtime_error& exc)
+                {
+                    LBWARN << "Failed to load targets from " << uri.getPath()
+                           << ": " << exc.what() << std::endl;
+                }
+            }
+            const double elapsed = clock.getTimed();
+            lunchbox::ScopedWrite statsMutex(_stats);
+            _stats->targetParse += elapsed;
+        }
+        return *_targetParsers;
+    }
 
     template <typename T>
     using LockPtr = lunchbox::Lockable<std::unique_ptr<T>>;
 
+    /** @return the resource, created by the timed open() on first use. */
+    template <typename T, typename Func>
+    const T& _open(LockPtr<T>& resource, double Circuit::Stats::*time,
+                   const Func& open) const
+    {
+        lunchbox::ScopedWrite mutex(resource);
+        if (!*resource)
+            resource->reset(_timed(time, open));
+        return **resource;
+    }
+
     mutable LockPtr<brion::SynapseSummary> _synapseSummary;
     mutable LockPtr<brion::Synapse> _synapseAttributes[2];
     mutable LockPtr<brion::Synapse> _synapseExtra;
@@ -448,6 +663,69 @@ public:
 
     mutable std::unordered_map<std::string, LockPtr<brion::Synapse>>
         _externalAfferents;
+
+    // Attributes of all neurons in GID order, loaded on first query
+    template <typename T>
+    using Column = lunchbox::Lockable<std::shared_ptr<const std::vector<T>>>;
+    template <typename T>
+    using ReadFunc = std::vector<T> (Impl::*)(const GIDSet&) const;
+
+    mutable std::atomic<bool> _cacheAttributes{false};
+    mutable Column<Vector3f> _positions;
+    mutable Column<size_t> _mtypes;
+    mutable Column<size_t> _etypes;
+    mutable Column<Quaternionf> _rotations;
+    mutable Column<std::string> _morphologyNames;
+
+    mutable lunchbox::Lockable<std::shared_ptr<const detail::SomaIndex>>
+        _somaIndex;
+
+    template <typename T>
+    std::shared_ptr<const std::vector<T>> _getColumn(
+        Column<T>& column, const ReadFunc<T> read) const
+    {
+        lunchbox::ScopedWrite mutex(column);
+        if (!*column)
+            column->reset(new std::vector<T>((this->*read)(getGIDs())));
+        return *column;
+    }
+
+    template <typename T>
+    std::vector<T> _query(Column<T>& column, const GIDSet& gids,
+                          const ReadFunc<T> read) const
+    {
+        if (!_cacheAttributes || gids.empty())
+            return (this->*read)(gids);
+
+        const uint32_ts indices(gids.begin(), gids.end());
+        return _gather(*_getColumn(column, read), indices.data(),
+                       indices.size());
+    }
+
+    template <typename T>
+    std::vector<T> _query(Column<T>& column, const CompactGIDSet& gids,
+                          const ReadFunc<T> read) const
+    {
+        if (!_cacheAttributes || gids.empty())
+            return (this->*read)(gids.toGIDSet());
+        return _gather(*_getColumn(column, read), gids.data(), gids.size());
+    }
+
+    /** @return the values of the sorted, non-empty GIDs. */
+    template <typename T>
+    std::vector<T> _gather(const std::vector<T>& values, const uint32_t* gids,
+                           const size_t size) const
+    {
+        if (gids[0] == 0 || gids[size - 1] > values.size())
+            LBTHROW(std::runtime_error("GIDs out of range for circuit " +
+                                       _circuitSource.getPath()));
+
+        std::vector<T> result(size);
+#pragma omp parallel for
+        for (int64_t i = 0; i < int64_t(size); ++i)
+            result[i] = values[gids[i] - 1];
+        return result;
+    }
 };
 
 class MVD2 : public Circuit::Impl
@@ -455,114 +733,70 @@ class MVD2 : public Circuit::Impl
 public:
     MVD2(const brion::BlueConfig& config)
         : Impl(config)
-        , _circuit(config.getCircuitSource().getPath())
     {
+        _checkCircuitSource();
     }
 
-    size_t getNumNeurons() const final { return _circuit.getNumNeurons(); }
-    Vector3fs getPositions(const GIDSet& gids) const final
+    size_t getNumNeurons() const final
     {
-        const brion::NeuronMatrix& data =
-            _circuit.get(gids, brion::NEURON_POSITION_X |
-                                   brion::NEURON_POSITION_Y |
-                                   brion::NEURON_POSITION_Z);
+        return _getCircuit().getNumNeurons();
+    }
 
-        Vector3fs positions(gids.size());
-#pragma omp parallel for
-        for (size_t i = 0; i < gids.size(); ++i)
-        {
-            try
-            {
-                positions[i] = brion::Vector3f(lexical_cast<float>(data[i][0]),
-                                               lexical_cast<float>(data[i][1]),
-                                               lexical_cast<float>(data[i][2]));
-            }
-            catch (const boost::bad_lexical_cast&)
-            {
-                GIDSet::const_iterator gid = gids.begin();
-                std::advance(gid, i);
-                LBWARN << "Error parsing circuit position for gid " << *gid
-                       << std::endl;
-            }
-        }
-        return positions;
+    Vector3fs getPositions(const GIDSet& gids) const final
+    {
+        return gids.empty() ? Vector3fs() : _getCircuit().getPositions(gids);
     }
 
     size_ts getMTypes(const GIDSet& gids) const final
     {
-        const brion::NeuronMatrix& matrix =
-            _circuit.get(gids, brion::NEURON_MTYPE);
-        size_ts result(matrix.shape()[0]);
-
-        brion::NeuronMatrix::const_array_view<1>::type view =
-            matrix[boost::indices[brion::NeuronMatrix::index_range()][0]];
-        std::transform(view.begin(), view.end(), result.begin(), toSize_t);
-        return result;
+        return gids.empty() ? size_ts() : _getCircuit().getMTypes(gids);
     }
 
     Strings getMorphologyNames() const final
     {
-        return _circuit.getTypes(brion::NEURONCLASS_MTYPE);
+        return _getCircuit().getTypes(brion::NEURONCLASS_MTYPE);
     }
 
     size_ts getETypes(const GIDSet& gids) const final
     {
-        const brion::NeuronMatrix& matrix =
-            _circuit.get(gids, brion::NEURON_ETYPE);
-        size_ts result(matrix.shape()[0]);
-
-        brion::NeuronMatrix::const_array_view<1>::type view =
-            matrix[boost::indices[brion::NeuronMatrix::index_range()][0]];
-        std::transform(view.begin(), view.end(), result.begin(), toSize_t);
-        return result;
+        return gids.empty() ? size_ts() : _getCircuit().getETypes(gids);
     }
 
     Strings getElectrophysiologyNames() const final
     {
-        return _circuit.getTypes(brion::NEURONCLASS_ETYPE);
+        return _getCircuit().getTypes(brion::NEURONCLASS_ETYPE);
     }
 
     Quaternionfs getRotations(const GIDSet& gids) const final
     {
-        const float deg2rad = float(M_PI) / 180.f;
-        const brion::NeuronMatrix& data =
-            _circuit.get(gids, brion::NEURON_ROTATION);
-        Quaternionfs rotations(gids.size());
+        if (gids.empty())
+            return Quaternionfs();
 
+        // transform rotation Y angle in degree into rotation quaternion
+        const float deg2rad = float(M_PI) / 180.f;
+        const floats& angles = _getCircuit().getRotations(gids);
+        Quaternionfs rotations(angles.size());
 #pragma omp parallel for
-        for (size_t i = 0; i < gids.size(); ++i)
-        {
-            try
-            {
-                // transform rotation Y angle in degree into rotation quaternion
-                const float angle = lexical_cast<float>(data[i][0]) * deg2rad;
-                rotations[i] = Quaternionf(angle, Vector3f(0, 1, 0));
-            }
-            catch (const boost::bad_lexical_cast&)
-            {
-                GIDSet::const_iterator gid = gids.begin();
-                std::advance(gid, i);
-                LBWARN << "Error parsing circuit orientation for gid " << *gid
-                       << std::endl;
-            }
-        }
+        for (int64_t i = 0; i < int64_t(angles.size()); ++i)
+            rotations[i] = Quaternionf(angles[i] * deg2rad, Vector3f(0, 1, 0));
         return rotations;
     }
 
     Strings getMorphologyNames(const GIDSet& gids) const final
     {
-        const brion::NeuronMatrix& matrix =
-            _circuit.get(gids, brion::NEURON_MORPHOLOGY_NAME);
-        Strings result(matrix.shape()[0]);
-
-        brion::NeuronMatrix::const_array_view<1>::type view =
-            matrix[boost::indices[brion::NeuronMatrix::index_range()][0]];
-        std::transform(view.begin(), view.end(), result.begin(), toString);
-        return result;
+        return gids.empty() ? Strings()
+                            : _getCircuit().getMorphologyNames(gids);
     }
 
 private:
-    brion::Circuit _circuit;
+    mutable LockPtr<brion::Circuit> _circuit;
+
+    const brion::Circuit& _getCircuit() const
+    {
+        return _open(_circuit, &Circuit::Stats::circuitOpen, [&] {
+            return new brion::Circuit(_circuitSource.getPath());
+        });
+    }
 };
 
 #ifdef BRAIN_USE_MVD3
@@ -570,21 +804,24 @@ struct MVD3 : public Circuit::Impl
 {
     MVD3(const brion::BlueConfig& config)
         : Impl(config)
-        , _circuit(config.getCircuitSource().getPath())
     {
+        _checkCircuitSource();
     }
 
-    size_t getNumNeurons() const final { return _circuit.getNbNeuron(); }
+    size_t getNumNeurons() const final { return _getCircuit().getNbNeuron(); }
     Vector3fs getPositions(const GIDSet& gids) const final
     {
+        const ::MVD3::MVD3File& circuit = _getCircuit();
         Vector3fs results(gids.size());
-        const ::MVD3::Range& range = getRange(gids);
         try
         {
             brion::detail::SilenceHDF5 silence;
             lunchbox::ScopedWrite mutex(brion::detail::hdf5Lock());
-            const ::MVD3::Positions& positions = _circuit.getPositions(range);
-            assign(range, gids, positions, results, toVector3f);
+            readSparse(gids,
+                       [&](const ::MVD3::Range& range) {
+                           return circuit.getPositions(range);
+                       },
+                       results, toVector3f);
             return results;
         }
         catch (const HighFive::Exception& e)
@@ -596,14 +833,17 @@ struct MVD3 : public Circuit::Impl
 
     size_ts getMTypes(const GIDSet& gids) const final
     {
+        const ::MVD3::MVD3File& circuit = _getCircuit();
         size_ts results(gids.size());
-        const ::MVD3::Range& range = getRange(gids);
         try
         {
             brion::detail::SilenceHDF5 silence;
             lunchbox::ScopedWrite mutex(brion::detail::hdf5Lock());
-            const size_ts& mtypes = _circuit.getIndexMtypes(range);
-            assign(range, gids, mtypes, results, nop);
+            readSparse(gids,
+                       [&](const ::MVD3::Range& range) {
+                           return circuit.getIndexMtypes(range);
+                       },
+                       results, nop);
             return results;
         }
         catch (const HighFive::Exception& e)
@@ -615,19 +855,22 @@ struct MVD3 : public Circuit::Impl
 
     Strings getMorphologyNames() const final
     {
-        return _circuit.listAllMtypes();
+        return _getCircuit().listAllMtypes();
     }
 
     size_ts getETypes(const GIDSet& gids) const final
     {
+        const ::MVD3::MVD3File& circuit = _getCircuit();
         size_ts results(gids.size());
-        const ::MVD3::Range& range = getRange(gids);
         try
         {
             brion::detail::SilenceHDF5 silence;
             lunchbox::ScopedWrite mutex(brion::detail::hdf5Lock());
-            const size_ts& etypes = _circuit.getIndexEtypes(range);
-            assign(range, gids, etypes, results, nop);
+            readSparse(gids,
+                       [&](const ::MVD3::Range& range) {
+                           return circuit.getIndexEtypes(range);
+                       },
+                       results, nop);
             return results;
         }
         catch (const HighFive::Exception& e)
@@ -639,19 +882,22 @@ struct MVD3 : public Circuit::Impl
 
     Strings getElectrophysiologyNames() const final
     {
-        return _circuit.listAllEtypes();
+        return _getCircuit().listAllEtypes();
     }
 
     Quaternionfs getRotations(const GIDSet& gids) const final
     {
+        const ::MVD3::MVD3File& circuit = _getCircuit();
         Quaternionfs results(gids.size());
-        const ::MVD3::Range& range = getRange(gids);
         try
         {
             brion::detail::SilenceHDF5 silence;
             lunchbox::ScopedWrite mutex(brion::detail::hdf5Lock());
-            const ::MVD3::Rotations& rotations = _circuit.getRotations(range);
-            assign(range, gids, rotations, results, toQuaternion);
+            readSparse(gids,
+                       [&](const ::MVD3::Range& range) {
+                           return circuit.getRotations(range);
+                       },
+                       results, toQuaternion);
             return results;
         }
         catch (const HighFive::Exception& e)
@@ -663,14 +909,17 @@ struct MVD3 : public Circuit::Impl
 
     Strings getMorphologyNames(const GIDSet& gids) const final
     {
+        const ::MVD3::MVD3File& circuit = _getCircuit();
         Strings results(gids.size());
-        const ::MVD3::Range& range = getRange(gids);
         try
         {
             brion::detail::SilenceHDF5 silence;
             lunchbox::ScopedWrite mutex(brion::detail::hdf5Lock());
-            const Strings& morphos = _circuit.getMorphologies(range);
-            assign(range, gids, morphos, results, toString);
+            readSparse(gids,
+                       [&](const ::MVD3::Range& range) {
+                           return circuit.getMorphologies(range);
+                       },
+                       results, toString);
             return results;
         }
         catch (const HighFive::Exception& e)
@@ -681,7 +930,16 @@ struct MVD3 : public Circuit::Impl
     }
 
 private:
-    ::MVD3::MVD3File _circuit;
+    mutable LockPtr<::MVD3::MVD3File> _circuit;
+
+    const ::MVD3::MVD3File& _getCircuit() const
+    {
+        return _open(_circuit, &Circuit::Stats::circuitOpen, [&] {
+            brion::detail::SilenceHDF5 silence;
+            lunchbox::ScopedWrite mutex(brion::detail::hdf5Lock());
+            return new ::MVD3::MVD3File(_circuitSource.getPath());
+        });
+    }
 };
 #endif
 }
@@ -0,0 +1,166 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_DETAIL_RANDOMSAMPLE
+#define BRAIN_DETAIL_RANDOMSAMPLE
+
+#include <brain/types.h>
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <unordered_set>
+
+namespace brain
+{
+namespace detail
+{
+using RandomEngine = std::mt19937_64;
+
+/**
+ * @return an engine seeded from $BRAIN_CIRCUIT_SEED if set, with a random seed
+ *         otherwise.
+ */
+inline RandomEngine createRandomEngine()
+{
+    std::random_device randomDevice;
+    RandomEngine randomEngine(randomDevice());
+    const char* seedEnv = getenv("BRAIN_CIRCUIT_SEED");
+    if (seedEnv)
+    {
+        try
+        {
+            randomEngine.seed(std::stoul(seedEnv));
+        }
+        catch (const std::exception& exc)
+        {
+            LBWARN << "Could not set BRAIN_CIRCUIT_SEED to " << seedEnv << ": "
+                   << exc.what() << std::endl;
+        }
+    }
+    return randomEngine;
+}
+
+/** @return the number of elements to sample from size elements. */
+inline size_t getSampleSize(const size_t size, const float fraction)
+{
+    return std::min(size, size_t(std::ceil(size * fraction)));
+}
+
+/**
+ * Draw count distinct indices from [0, size) using Floyd's algorithm.
+ *
+ * Runs in O(count) expected time and memory independent of size, plus the
+ * final sort. If more than half of the indices are requested, the excluded
+ * indices are drawn instead.
+ *
+ * @return the sorted indices.
+ */
+inline uint32_ts sampleIndices(const size_t size, const size_t count,
+                               RandomEngine& engine)
+{
+    if (count >= size)
+    {
+        uint32_ts all(size);
+        std::iota(all.begin(), all.end(), 0);
+        return all;
+    }
+
+    if (count > size / 2)
+    {
+        const uint32_ts excluded = sampleIndices(size, size - count, engine);
+        uint32_ts result;
+        result.reserve(count);
+        auto next = excluded.begin();
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            if (next != excluded.end() && *next == i)
+                ++next;
+            else
+                result.push_back(i);
+        }
+        return result;
+    }
+
+    std::unordered_set<uint32_t> selected(count * 2);
+    uint32_ts result;
+    result.reserve(count);
+    for (size_t j = size - count; j < size; ++j)
+    {
+        const uint32_t candidate =
+            uint32_t(std::uniform_int_distribution<size_t>(0, j)(engine));
+        const uint32_t pick =
+            selected.insert(candidate).second ? candidate : uint32_t(j);
+        if (pick == j)
+            selected.insert(pick);
+        result.push_back(pick);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/** @return a sorted random fraction of the given sorted GIDs. */
+inline uint32_ts sampleGIDs(const uint32_ts& gids, const float fraction,
+                            RandomEngine& engine)
+{
+    const uint32_ts indices =
+        sampleIndices(gids.size(), getSampleSize(gids.size(), fraction),
+                      engine);
+    uint32_ts result(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+        result[i] = gids[indices[i]];
+    return result;
+}
+
+/**
+ * Sample the same fraction from each stratum of sorted GIDs.
+ *
+ * Each stratum is sampled in parallel with its own engine, seeded in order
+ * from the given engine, so the result only depends on the seed.
+ *
+ * @return the sorted union of the samples.
+ */
+inline GIDSet sampleStrata(const std::vector<uint32_ts>& strata,
+                           const float fraction, RandomEngine& engine)
+{
+    std::vector<RandomEngine::result_type> seeds(strata.size());
+    for (auto& seed : seeds)
+        seed = engine();
+
+    std::vector<uint32_ts> samples(strata.size());
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < int64_t(strata.size()); ++i)
+    {
+        RandomEngine stratumEngine(seeds[i]);
+        samples[i] = sampleGIDs(strata[i], fraction, stratumEngine);
+    }
+
+    uint32_ts result;
+    for (const auto& sample : samples)
+        result.insert(result.end(), sample.begin(), sample.end());
+    std::sort(result.begin(), result.end());
+    return GIDSet(result.begin(), result.end());
+}
+}
+}
+
+#endif
@@ -0,0 +1,123 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_DETAIL_SOMAINDEX
+#define BRAIN_DETAIL_SOMAINDEX
+
+#include "../neuron/segmentBVH.h"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace brain
+{
+namespace detail
+{
+/**
+ * Bounding volume hierarchy over the soma positions of all cells of a
+ * circuit. Items are the positions in GID order, i.e., item i is GID i + 1.
+ */
+class SomaIndex
+{
+public:
+    explicit SomaIndex(const Vector3fs& positions)
+        : _positions(positions)
+        , _tree(_getBounds(positions))
+    {
+    }
+
+    GIDSet findInBox(const AABBf& box) const
+    {
+        const neuron::Bounds bounds(box.getMin(), box.getMax());
+        return _find([&](const neuron::Bounds& other) {
+            return other.overlaps(bounds);
+        });
+    }
+
+    GIDSet findInSphere(const Vector3f& center, const float radius) const
+    {
+        return _find([&](const neuron::Bounds& bounds) {
+            return bounds.getDistance(center) <= radius;
+        });
+    }
+
+    GIDSet findNearest(const Vector3f& point, const size_t count) const
+    {
+        if (count == 0)
+            return GIDSet();
+
+        // max-heap of the closest items found so far
+        typedef std::pair<float, uint32_t> Candidate;
+        std::priority_queue<Candidate> nearest;
+        _tree.traverseNearest(
+            [&](const neuron::Bounds& bounds) {
+                return bounds.getDistance(point);
+            },
+            [&](const uint32_t i) {
+                nearest.emplace((_positions[i] - point).length(), i);
+                if (nearest.size() > count)
+                    nearest.pop();
+                return nearest.size() < count
+                           ? std::numeric_limits<float>::infinity()
+                           : nearest.top().first;
+            },
+            std::numeric_limits<float>::infinity());
+
+        uint32_ts indices;
+        indices.reserve(nearest.size());
+        for (; !nearest.empty(); nearest.pop())
+            indices.push_back(nearest.top().second);
+        return _toGIDs(indices);
+    }
+
+private:
+    const Vector3fs _positions;
+    const neuron::BoxTree _tree;
+
+    static neuron::Boundss _getBounds(const Vector3fs& positions)
+    {
+        neuron::Boundss bounds(positions.size());
+#pragma omp parallel for
+        for (int64_t i = 0; i < int64_t(positions.size()); ++i)
+            bounds[i] = neuron::Bounds(positions[i], positions[i]);
+        return bounds;
+    }
+
+    template <typename TestFunc>
+    GIDSet _find(const TestFunc& test) const
+    {
+        uint32_ts indices;
+        _tree.traverse(test, [&](const uint32_t i) { indices.push_back(i); });
+        return _toGIDs(indices);
+    }
+
+    static GIDSet _toGIDs(uint32_ts& indices)
+    {
+        std::sort(indices.begin(), indices.end());
+        GIDSet gids;
+        for (const uint32_t index : indices)
+            gids.emplace_hint(gids.end(), index + 1);
+        return gids;
+    }
+};
+}
+}
+
+#endif
@@ -21,6 +21,7 @@
 #define BRAIN_DETAIL_SYNAPSESSTREAM
 
 #include <brain/circuit.h>
+#include <brion/compactGIDSet.h>
 
 #include <future>
 
@@ -30,7 +31,8 @@ namespace detail
 {
 struct SynapsesStream
 {
-    SynapsesStream(const Circuit& circuit, const GIDSet& gids,
+    template <typename GIDs>
+    SynapsesStream(const Circuit& circuit, const GIDs& gids,
                    const bool afferent, const SynapsePrefetch prefetch)
         : _circuit(circuit)
         , _afferent(afferent)
@@ -40,18 +42,20 @@ struct SynapsesStream
     {
     }
 
-    SynapsesStream(const Circuit& circuit, const GIDSet& preGIDs,
-                   const GIDSet& postGIDs, const SynapsePrefetch prefetch)
+    template <typename GIDs>
+    SynapsesStream(const Circuit& circuit, const GIDs& preGIDs,
+                   const GIDs& postGIDs, const SynapsePrefetch prefetch)
         : _circuit(circuit)
         , _afferent(preGIDs.empty() || (postGIDs.size() < preGIDs.size()))
         , _gids(_afferent ? postGIDs : preGIDs)
-        , _filterGIDs(_afferent ? preGIDs : postGIDs)
+        , _filterGIDs(_toGIDSet(_afferent ? preGIDs : postGIDs))
         , _prefetch(prefetch)
         , _it(_gids.begin())
     {
     }
 
-    SynapsesStream(const Circuit& circuit, const GIDSet& gids,
+    template <typename GIDs>
+    SynapsesStream(const Circuit& circuit, const GIDs& gids,
                    const std::string& source, const SynapsePrefetch prefetch)
         : _circuit(circuit)
         , _afferent(true)
@@ -64,25 +68,24 @@ struct SynapsesStream
 
     const Circuit& _circuit;
     const bool _afferent;
-    const GIDSet _gids;
+    // Contiguous storage to slice reads in constant time
+    const CompactGIDSet _gids;
     const GIDSet _filterGIDs;
     // Source name for external afferent projections
     const std::string _externalSource;
     const SynapsePrefetch _prefetch;
-    GIDSet::const_iterator _it;
+    CompactGIDSet::const_iterator _it;
 
-    size_t getRemaining() const
-    {
-        return size_t(std::abs(std::distance(_it, _gids.end())));
-    }
+    size_t getRemaining() const { return size_t(_gids.end() - _it); }
 
     std::future<Synapses> read(size_t count)
     {
         count = std::min(count, getRemaining());
-        GIDSet::const_iterator start = _it;
-        std::advance(_it, count);
-        GIDSet::const_iterator end = _it;
+        const CompactGIDSet::const_iterator start = _it;
+        _it += count;
+        const CompactGIDSet::const_iterator end = _it;
 
+        // The GIDs are sorted, so the GIDSet is built in linear time
         if (_externalSource.empty())
         {
             return std::async(std::launch::async, [&, start, end] {
@@ -95,6 +98,13 @@ struct SynapsesStream
                             _prefetch);
         });
     }
+
+private:
+    static const GIDSet& _toGIDSet(const GIDSet& gids) { return gids; }
+    static GIDSet _toGIDSet(const CompactGIDSet& gids)
+    {
+        return gids.toGIDSet();
+    }
 };
 }
 }
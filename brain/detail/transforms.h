@@ -0,0 +1,106 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_DETAIL_TRANSFORMS
+#define BRAIN_DETAIL_TRANSFORMS
+
+#include <brain/types.h>
+
+#include <vmmlib/matrix.hpp>
+#include <vmmlib/quaternion.hpp>
+
+#include <stdexcept>
+
+namespace brain
+{
+namespace detail
+{
+/**
+ * Compute the affine transformations of rotations followed by translations.
+ *
+ * The rotation matrices are expanded from the unit quaternions with the same
+ * formula as vmmlib. The computation is a straight-line kernel over the raw
+ * arrays, vectorized across elements and split over threads, writing each
+ * column-major matrix exactly once. Matrices with four rows get the
+ * homogeneous last row.
+ *
+ * @return the Matrix4f or Matrix3x4f transformations in the given order.
+ */
+template <typename Matrix>
+std::vector<Matrix> computeTransforms(const Vector3fs& positions,
+                                      const Quaternionfs& rotations)
+{
+    static_assert(sizeof(Vector3f) == 3 * sizeof(float), "Unpacked Vector3f");
+    static_assert(sizeof(Quaternionf) == 4 * sizeof(float),
+                  "Unpacked Quaternionf");
+    static_assert(sizeof(Matrix) == sizeof(Matrix::array), "Unpacked Matrix");
+
+    if (positions.size() != rotations.size())
+        throw std::runtime_error(
+            "Positions not equal rotations for given GIDs");
+
+    const size_t rows = sizeof(Matrix::array) / sizeof(float) / 4;
+    static_assert(rows == 3 || rows == 4, "Need a 3x4 or 4x4 matrix");
+
+    std::vector<Matrix> transforms(positions.size());
+    if (transforms.empty())
+        return transforms;
+
+    const float* const t = positions.front().array;
+    const float* const q = rotations.front().array;
+    float* const out = transforms.front().array;
+
+#pragma omp parallel for simd
+    for (int64_t i = 0; i < int64_t(transforms.size()); ++i)
+    {
+        const float x = q[4 * i];
+        const float y = q[4 * i + 1];
+        const float z = q[4 * i + 2];
+        const float w = q[4 * i + 3];
+        const float xx = x * x, yy = y * y, zz = z * z, ww = w * w;
+        const float xy = x * y, xz = x * z, yz = y * z;
+        const float wx = w * x, wy = w * y, wz = w * z;
+
+        float* const m = out + i * rows * 4;
+        m[0] = ww + xx - yy - zz;
+        m[1] = 2.f * (xy + wz);
+        m[2] = 2.f * (xz - wy);
+        m[rows] = 2.f * (xy - wz);
+        m[rows + 1] = ww - xx + yy - zz;
+        m[rows + 2] = 2.f * (yz + wx);
+        m[2 * rows] = 2.f * (xz + wy);
+        m[2 * rows + 1] = 2.f * (yz - wx);
+        m[2 * rows + 2] = ww - xx - yy + zz;
+        m[3 * rows] = t[3 * i];
+        m[3 * rows + 1] = t[3 * i + 1];
+        m[3 * rows + 2] = t[3 * i + 2];
+        if (rows == 4)
+        {
+            m[3] = 0.f;
+            m[7] = 0.f;
+            m[11] = 0.f;
+            m[15] = 1.f;
+        }
+    }
+    return transforms;
+}
+}
+}
+
+#endif
@@ -22,11 +22,14 @@
 #include "soma.h"
 
 #include "morphologyImpl.h"
+#include "segmentBVH.h"
 
 #include <brion/morphology.h>
 
 #include <lunchbox/log.h>
 
+#include <limits>
+
 namespace brain
 {
 namespace neuron
@@ -47,6 +50,12 @@ Morphology::Morphology(brion::MorphologyPtr morphology,
 {
 }
 
+Morphology::Morphology(brion::ConstMorphologyPtr morphology,
+                       const Matrix4f& transform)
+    : _impl(new Impl(morphology, transform))
+{
+}
+
 Morphology::Morphology(const URI& source)
     : _impl(new Impl(source))
 {
@@ -63,7 +72,7 @@ Morphology::~Morphology()
 
 const Vector4fs& Morphology::getPoints() const
 {
-    return _impl->data->getPoints();
+    return _impl->getPoints();
 }
 
 const Vector2is& Morphology::getSections() const
@@ -114,6 +123,51 @@ Section Morphology::getSection(const uint32_t& id) const
     return Section(id, _impl);
 }
 
+void Morphology::getSamples(const uint32_ts& sectionIDs, const floats& points,
+                            float* x, float* y, float* z,
+                            float* diameters) const
+{
+    _impl->getSectionSamples(sectionIDs, points, x, y, z, diameters);
+}
+
+SegmentHits Morphology::intersectRay(const Vector3f& origin,
+                                     const Vector3f& direction) const
+{
+    const float length = direction.length();
+    if (length == 0)
+        LBTHROW(std::runtime_error("Invalid ray direction"));
+
+    SegmentHits hits;
+    _impl->getBVH().intersectRay(origin, direction / length, hits);
+    sortHits(hits);
+    return hits;
+}
+
+SegmentHits Morphology::intersectBox(const AABBf& box) const
+{
+    SegmentHits hits;
+    _impl->getBVH().intersectBox(Bounds(box.getMin(), box.getMax()), hits);
+    sortHits(hits);
+    return hits;
+}
+
+SegmentHits Morphology::intersectSphere(const Vector3f& center,
+                                        const float radius) const
+{
+    SegmentHits hits;
+    _impl->getBVH().intersectSphere(center, radius, hits);
+    sortHits(hits);
+    return hits;
+}
+
+SegmentHit Morphology::getNearestSegment(const Vector3f& point) const
+{
+    SegmentHit hit{0, 0, 0, std::numeric_limits<float>::infinity()};
+    if (!_impl->getBVH().findNearest(point, hit))
+        LBTHROW(std::runtime_error("Morphology has no segments"));
+    return hit;
+}
+
 Soma Morphology::getSoma() const
 {
     return Soma(_impl);
@@ -126,7 +180,7 @@ const Matrix4f& Morphology::getTransformation() const
 
 servus::Serializable::Data Morphology::toBinary() const
 {
-    return _impl->data->toBinary();
+    return _impl->toBinary();
 }
 }
 }
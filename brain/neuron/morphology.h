@@ -26,6 +26,7 @@
 
 #include <boost/noncopyable.hpp>
 #include <servus/serializable.h>
+#include <vmmlib/aabb.hpp> // parameter
 
 namespace brain
 {
@@ -38,8 +39,9 @@ namespace neuron
  * in the context of circuits.
  * Morphologies can be loaded with a transformation applied to its points,
  * which is useful for operating in global circuit coordinates.
- * The transformation is applied at construction so it cannot be modified or
- * reverted.
+ * The transformation is given at construction so it cannot be modified or
+ * reverted. Morphologies created from a const brion::Morphology share its
+ * untransformed data and compute their transformed points on first use.
  *
  * Access to the raw data fields is still provided by getter functions.
  *
@@ -90,6 +92,23 @@ public:
     BRAIN_API Morphology(brion::MorphologyPtr morphology,
                          const Matrix4f& transform);
 
+    /**
+     * Create a morphology from a brion::Morphology with a transformation,
+     * sharing the data of the given morphology.
+     *
+     * The given morphology is not modified, so it can be shared by many
+     * morphologies with different transformations. The transformed points
+     * are computed on first access to them or to any derived geometry.
+     *
+     * @param morphology the brion::Morphology to load from.
+     * @param transform the transformation matrix to apply to the points.
+     *        Radii will not be affected by this transformation.
+     * @throw runtime_error if an inconsistency is detected in the input file.
+     * @version 3.0
+     */
+    BRAIN_API Morphology(brion::ConstMorphologyPtr morphology,
+                         const Matrix4f& transform);
+
     BRAIN_API ~Morphology();
 
     /** @sa brion::Morphology::readPoints */
@@ -126,6 +145,81 @@ public:
      */
     BRAIN_API Section getSection(const uint32_t& id) const;
 
+    /**
+     * Sample many sections at discrete locations in one call.
+     *
+     * Equivalent to calling Section::getSamples() with the single position
+     * points[i] on section sectionIDs[i] for each i, but without allocations
+     * per section and parallelized over the samples. The samples are written
+     * in structure-of-arrays layout to the given buffers, which must hold
+     * sectionIDs.size() elements each.
+     *
+     * @param sectionIDs the sections to sample, may contain duplicates.
+     * @param points normalized positions of the samples along their sections.
+     *        Values will be clamped to [0, 1] before sampling.
+     * @param x receives the x coordinates of the samples.
+     * @param y receives the y coordinates of the samples.
+     * @param z receives the z coordinates of the samples.
+     * @param diameters receives the diameters of the samples.
+     * @throw runtime_error if sectionIDs and points differ in size, or if a
+     *        section id is out of range or refers to a soma section.
+     */
+    BRAIN_API void getSamples(const uint32_ts& sectionIDs,
+                              const floats& points, float* x, float* y,
+                              float* z, float* diameters) const;
+
+    /**
+     * @name Spatial queries
+     *
+     * The segments of all sections except the soma are indexed in a bounding
+     * volume hierarchy, which is built on the first query. Each segment is
+     * treated as a capsule around the line between its two points with the
+     * larger of their radii. The results are sorted by distance.
+     */
+    //@{
+    /**
+     * Return the segments hit by a ray.
+     *
+     * @param origin the start of the ray.
+     * @param direction the direction of the ray, need not be normalized.
+     * @return the hit segments with the distance from the origin to the
+     *         point where the ray enters them, 0 if the origin is inside.
+     * @throw runtime_error if the direction is zero.
+     * @version 3.0
+     */
+    BRAIN_API SegmentHits intersectRay(const Vector3f& origin,
+                                       const Vector3f& direction) const;
+
+    /**
+     * Return the segments intersecting a box.
+     *
+     * @return the segments with the distance from their axis to the box, 0 if
+     *         the axis intersects the box.
+     * @version 3.0
+     */
+    BRAIN_API SegmentHits intersectBox(const AABBf& box) const;
+
+    /**
+     * Return the segments intersecting a sphere.
+     *
+     * @return the segments with the distance from the center of the sphere
+     *         to their surface, 0 if the center is inside.
+     * @version 3.0
+     */
+    BRAIN_API SegmentHits intersectSphere(const Vector3f& center,
+                                          float radius) const;
+
+    /**
+     * Return the segment nearest to a point.
+     *
+     * @return the segment with the distance from the point to its surface, 0
+     *         if the point is inside.
+     * @throw runtime_error if the morphology has no segments.
+     * @version 3.0
+     */
+    BRAIN_API SegmentHit getNearestSegment(const Vector3f& point) const;
+    //@}
+
     /** Return the object with the information about the neuron soma */
     BRAIN_API Soma getSoma() const;
 
@@ -137,6 +231,7 @@ public:
 
 private:
     friend class brain::Circuit;
+    friend class SegmentIndex;
     Morphology(const void* data, const size_t size);
     servus::Serializable::Data toBinary() const;
 
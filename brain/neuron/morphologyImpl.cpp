@@ -20,18 +20,68 @@
 
 #include "morphologyImpl.h"
 #include "section.h"
+#include "segmentBVH.h"
 
+#include <brion/flatMorphology.h>
 #include <brion/morphology.h>
 #include <brion/morphologyPlugin.h>
 
 #include <lunchbox/log.h>
 
+#include <algorithm>
 #include <bitset>
 
 namespace brain
 {
 namespace neuron
 {
+namespace
+{
+// Computes out[i] = transform * in[i] for the xyz components in homogeneous
+// coordinates, keeping the diameter. Written on plain floats with the matrix
+// coefficients hoisted so the loop vectorizes; in and out may alias.
+void _transformPoints(const Matrix4f& transform, const Vector4f* in,
+                      Vector4f* out, const size_t size)
+{
+    const float m00 = transform(0, 0), m01 = transform(0, 1),
+                m02 = transform(0, 2), m03 = transform(0, 3);
+    const float m10 = transform(1, 0), m11 = transform(1, 1),
+                m12 = transform(1, 2), m13 = transform(1, 3);
+    const float m20 = transform(2, 0), m21 = transform(2, 1),
+                m22 = transform(2, 2), m23 = transform(2, 3);
+    const float m30 = transform(3, 0), m31 = transform(3, 1),
+                m32 = transform(3, 2), m33 = transform(3, 3);
+    const bool affine = m30 == 0 && m31 == 0 && m32 == 0 && m33 == 1;
+
+    const int64_t count = size;
+#pragma omp parallel for
+    for (int64_t i = 0; i < count; ++i)
+    {
+        const float x = in[i][0];
+        const float y = in[i][1];
+        const float z = in[i][2];
+        float tx = m00 * x + m01 * y + m02 * z + m03;
+        float ty = m10 * x + m11 * y + m12 * z + m13;
+        float tz = m20 * x + m21 * y + m22 * z + m23;
+        if (!affine)
+        {
+            const float w = 1.f / (m30 * x + m31 * y + m32 * z + m33);
+            tx *= w;
+            ty *= w;
+            tz *= w;
+        }
+        out[i][0] = tx;
+        out[i][1] = ty;
+        out[i][2] = tz;
+        out[i][3] = in[i][3];
+    }
+}
+}
+
+Morphology::Impl::~Impl()
+{
+}
+
 Morphology::Impl::Impl(const void* ptr, const size_t size)
     : Impl(brion::ConstMorphologyPtr(new brion::Morphology(ptr, size)))
 {
@@ -57,14 +107,49 @@ Morphology::Impl::Impl(brion::MorphologyPtr morphology,
                        const Matrix4f& transform)
     : data(morphology)
     , transformation(transform)
+{
+    auto& points = morphology->getPoints();
+    _transformPoints(transformation, points.data(), points.data(),
+                     points.size());
+    _extractInformation();
+}
 
+Morphology::Impl::Impl(brion::ConstMorphologyPtr morphology,
+                       const Matrix4f& transform)
+    : data(morphology)
+    , transformation(transform)
+    , _sharedData(true)
 {
-    _transform(morphology);
     _extractInformation();
 }
 
+const Vector4fs& Morphology::Impl::getPoints() const
+{
+    if (!_sharedData)
+        return data->getPoints();
+
+    std::call_once(_pointsTransformed, [this] {
+        const auto& points = data->getPoints();
+        _points.resize(points.size());
+        _transformPoints(transformation, points.data(), _points.data(),
+                         points.size());
+    });
+    return _points;
+}
+
+servus::Serializable::Data Morphology::Impl::toBinary() const
+{
+    if (!_sharedData)
+        return data->toBinary();
+
+    brion::Morphology transformed(*data);
+    transformed.getPoints() = getPoints();
+    return transformed.toBinary();
+}
+
 SectionRange Morphology::Impl::getSectionRange(const uint32_t sectionID) const
 {
+    // The number of points does not depend on the transformation
     const auto& points = data->getPoints();
     const auto& sections = data->getSections();
     const size_t start = sections[sectionID][0];
@@ -97,21 +182,14 @@ uint32_ts Morphology::Impl::getSectionIDs(const SectionTypes& requestedTypes,
 
 float Morphology::Impl::getSectionLength(const uint32_t sectionID) const
 {
-    if (_sectionLengths.size() <= sectionID)
-        _sectionLengths.resize(sectionID + 1);
-
-    float& length = _sectionLengths[sectionID];
-    const auto& types = data->getSectionTypes();
-
-    if (length == 0 && types[sectionID] != brion::enums::SECTION_SOMA)
-        length = _computeSectionLength(sectionID);
-    return length;
+    _ensureGeometry();
+    return _sectionLengths[sectionID];
 }
 
 Vector4fs Morphology::Impl::getSectionSamples(const uint32_t sectionID) const
 {
     const SectionRange range = getSectionRange(sectionID);
-    const auto& points = data->getPoints();
+    const auto& points = getPoints();
 
     Vector4fs result;
     result.reserve(range.second - range.first);
@@ -131,123 +209,101 @@ Vector4fs Morphology::Impl::getSectionSamples(const uint32_t sectionID,
         // This code shouldn't be reached.
         LBTHROW(std::runtime_error("Invalid method called on soma section"));
 
-    // Dealing with the degenerate case of single point sections.
-    const auto& points = data->getPoints();
-    if (range.first + 1 == range.second)
-        return Vector4fs(samplePoints.size(), points[range.first]);
-
     Vector4fs result;
     result.reserve(samplePoints.size());
+    for (const float point : samplePoints)
+        result.push_back(_sample(range, point));
+    return result;
+}
 
-    const floats accumLengths = _computeAccumulatedLengths(range);
-    const float totalLength = accumLengths.back();
+void Morphology::Impl::getSectionSamples(const uint32_ts& sectionIDs,
+                                         const floats& samplePoints, float* x,
+                                         float* y, float* z,
+                                         float* diameters) const
+{
+    if (sectionIDs.size() != samplePoints.size())
+        LBTHROW(std::runtime_error(
+            "Section and sample position counts do not match"));
 
-    for (const float point : samplePoints)
+    const auto& types = data->getSectionTypes();
+    for (const uint32_t sectionID : sectionIDs)
     {
-        // Finding the segment index for the requested sampling position.
-        const float length = std::max(0.f, std::min(1.f, point)) * totalLength;
-        size_t index = 0;
-        for (; accumLengths[index + 1] < length &&
-               index < accumLengths.size() - 1;
-             ++index)
-            ;
-
-        // If the first point of the section is repeated and we are
-        // interpolating
-        // at 0 length - accumLengths[0] and accumLengths[1] - accumLengths[0]
-        // will be both 0. To avoid the 0/0 operation we check for
-        // length == accumLengths[index].
-        const size_t start = range.first + index;
-        if (length == accumLengths[index])
-        {
-            result.push_back(points[start]);
-            continue;
-        }
+        if (sectionID >= types.size())
+            LBTHROW(std::runtime_error(std::string("Section ID ") +
+                                       std::to_string(sectionID) +
+                                       " out of range"));
+        if (types[sectionID] == brion::enums::SECTION_SOMA)
+            LBTHROW(std::runtime_error(
+                "The soma cannot be sampled as a section"));
+    }
 
-        // Interpolating the cross section at point.
-        const float alpha = (length - accumLengths[index]) /
-                            (accumLengths[index + 1] - accumLengths[index]);
+    _ensureGeometry();
+    const int64_t size = sectionIDs.size();
+#pragma omp parallel for
+    for (int64_t i = 0; i < size; ++i)
+    {
         const Vector4f sample =
-            points[start + 1] * alpha + points[start] * (1 - alpha);
-        result.push_back(sample);
+            _sample(getSectionRange(sectionIDs[i]), samplePoints[i]);
+        x[i] = sample[0];
+        y[i] = sample[1];
+        z[i] = sample[2];
+        diameters[i] = sample[3];
     }
-
-    return result;
 }
 
 float Morphology::Impl::getDistanceToSoma(const uint32_t sectionID) const
 {
-    if (_distancesToSoma.size() <= sectionID)
-        _distancesToSoma.resize(sectionID + 1);
-
-    float& distance = _distancesToSoma[sectionID];
-    if (distance == 0)
-    {
-        // This is the soma, a first order section or the distance hasn't
-        // been computed yet. Soma and first order sections are cheap
-        // to detect and compute.
-        const auto& sections = data->getSections();
-        const auto& types = data->getSectionTypes();
-        const int32_t parent = sections[sectionID][1];
-        if (parent == -1 || types[parent] == brion::enums::SECTION_SOMA)
-            return 0;
-        // For the other cases it doesn't matter to have concurrent updates
-        // because they will yield the same result (and it's probably
-        // cheaper to go ahead with the computation than to contend for a
-        // mutex).
-        distance = getSectionLength(parent) + getDistanceToSoma(parent);
-    }
-    return distance;
+    _ensureGeometry();
+    return _distancesToSoma[sectionID];
 }
 
 floats Morphology::Impl::getSampleDistancesToSoma(
     const uint32_t sectionID) const
 {
     const SectionRange range = getSectionRange(sectionID);
-    const floats accumLengths = _computeAccumulatedLengths(range);
-    floats result;
-    result.reserve(accumLengths.size());
-    const float distance = getDistanceToSoma(sectionID);
-    for (const float length : accumLengths)
-        result.push_back(distance + length);
+    const floats& accumLengths = getAccumulatedLengths();
+    const float distance = _distancesToSoma[sectionID];
 
+    floats result(accumLengths.begin() + range.first,
+                  accumLengths.begin() + range.second);
+    for (float& length : result)
+        length += distance;
     return result;
 }
 
-const uint32_ts& Morphology::Impl::getChildren(const uint32_t sectionID) const
+uint32_t Morphology::Impl::getBranchOrder(const uint32_t sectionID) const
 {
-    return _sectionChildren[sectionID];
+    _ensureGeometry();
+    return _branchOrders[sectionID];
 }
 
-void Morphology::Impl::_transform(brion::MorphologyPtr morphology)
+brion::ConstSpan<uint32_t> Morphology::Impl::getChildren(
+    const uint32_t sectionID) const
 {
-    auto& points = morphology->getPoints();
-#pragma omp parallel for
-    for (size_t i = 0; i < points.size(); ++i)
-    {
-        auto& p = points[i];
-        const Vector3f& pp = transformation * p.get_sub_vector<3, 0>();
-        p.set_sub_vector<3, 0>(pp);
-    }
+    const uint32_t begin = _childOffsets[sectionID];
+    return brion::ConstSpan<uint32_t>(_children.data() + begin,
+                                      _childOffsets[sectionID + 1] - begin);
+}
+
+const floats& Morphology::Impl::getAccumulatedLengths() const
+{
+    _ensureGeometry();
+    return _accumulatedLengths;
+}
+
+const SegmentBVH& Morphology::Impl::getBVH() const
+{
+    std::call_once(_bvhBuilt, [this] {
+        _bvh.reset(new SegmentBVH(getPoints(), data->getSections(),
+                                  data->getSectionTypes()));
+    });
+    return *_bvh;
 }
 
 void Morphology::Impl::_extractInformation()
 {
     // children list
-    std::map<uint32_t, uint32_ts> children;
-    const auto& sections = data->getSections();
-    for (size_t i = 0; i < sections.size(); ++i)
-    {
-        const int32_t parent = sections[i][1];
-        if (parent != -1)
-            children[parent].push_back(i);
-    }
-    _sectionChildren.resize(sections.size());
-    for (auto& sectionAndChildren : children)
-    {
-        _sectionChildren[sectionAndChildren.first].swap(
-            sectionAndChildren.second);
-    }
+    brion::buildChildren(data->getSections(), _childOffsets, _children);
 
     // soma
     const uint32_ts ids = getSectionIDs({SectionType::soma}, false);
@@ -259,36 +315,102 @@ void Morphology::Impl::_extractInformation()
     somaSection = ids[0];
 }
 
-float Morphology::Impl::_computeSectionLength(const uint32_t sectionID) const
+Vector4f Morphology::Impl::_sample(const SectionRange& range,
+                                   const float position) const
 {
-    const auto& points = data->getPoints();
-    const SectionRange range = getSectionRange(sectionID);
-    float length = 0;
-    for (size_t i = range.first; i != range.second - 1; ++i)
-    {
-        const Vector4f& start = points[i];
-        const Vector4f& end = points[i + 1];
-        const Vector3f& diff = (end - start).get_sub_vector<3, 0>();
-        length += diff.length();
-    }
-    return length;
+    // Dealing with the degenerate case of single point sections.
+    const auto& points = getPoints();
+    if (range.first + 1 == range.second)
+        return points[range.first];
+
+    const float* accumLengths = getAccumulatedLengths().data() + range.first;
+    const size_t numPoints = range.second - range.first;
+    const float length = std::max(0.f, std::min(1.f, position)) *
+                         accumLengths[numPoints - 1];
+
+    // Finding the segment index for the requested sampling position: the
+    // first segment whose end is not before the requested length.
+    const float* end =
+        std::lower_bound(accumLengths + 1, accumLengths + numPoints, length);
+    const size_t index =
+        std::min(size_t(end - accumLengths), numPoints - 1) - 1;
+
+    // If the first point of the section is repeated and we are interpolating
+    // at 0 length - accumLengths[0] and accumLengths[1] - accumLengths[0]
+    // will be both 0. To avoid the 0/0 operation we check for
+    // length == accumLengths[index].
+    const size_t start = range.first + index;
+    if (length == accumLengths[index])
+        return points[start];
+
+    // Interpolating the cross section at point.
+    const float alpha = (length - accumLengths[index]) /
+                        (accumLengths[index + 1] - accumLengths[index]);
+    return points[start + 1] * alpha + points[start] * (1 - alpha);
 }
 
-floats Morphology::Impl::_computeAccumulatedLengths(
-    const SectionRange& range) const
+void Morphology::Impl::_ensureGeometry() const
 {
-    const auto& points = data->getPoints();
-    floats result;
-    result.reserve(range.second - range.first);
-    result.push_back(0);
-    for (size_t i = range.first; i != range.second - 1; ++i)
+    std::call_once(_geometryComputed, [this] { _computeGeometry(); });
+}
+
+void Morphology::Impl::_computeGeometry() const
+{
+    const auto& points = getPoints();
+    const auto& sections = data->getSections();
+    const auto& types = data->getSectionTypes();
+
+    // Segment lengths, prefix summed per section. The running sum restarts at
+    // 0 on the first point of each section.
+    _accumulatedLengths.resize(points.size());
+    _sectionLengths.resize(sections.size());
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        const SectionRange range = getSectionRange(i);
+        float length = 0;
+        if (range.first < range.second)
+        {
+            _accumulatedLengths[range.first] = 0;
+            for (size_t j = range.first + 1; j < range.second; ++j)
+            {
+                const Vector3f& diff =
+                    (points[j] - points[j - 1]).get_sub_vector<3, 0>();
+                length += diff.length();
+                _accumulatedLengths[j] = length;
+            }
+        }
+        // The length of the soma is ill-defined
+        _sectionLengths[i] =
+            types[i] == brion::enums::SECTION_SOMA ? 0 : length;
+    }
+
+    // Distances to the soma and branch orders, propagated from the roots to
+    // the leaves. Sections connected to the soma have branch order 1.
+    _distancesToSoma.assign(sections.size(), 0);
+    _branchOrders.assign(sections.size(), 0);
+    uint32_ts stack;
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        if (sections[i][1] != -1)
+            continue;
+        if (types[i] != brion::enums::SECTION_SOMA)
+            _branchOrders[i] = 1;
+        stack.push_back(i);
+    }
+
+    while (!stack.empty())
     {
-        const Vector4f& start = points[i];
-        const Vector4f& end = points[i + 1];
-        const Vector3f& diff = (end - start).get_sub_vector<3, 0>();
-        result.push_back(result.back() + diff.length());
+        const uint32_t parent = stack.back();
+        stack.pop_back();
+        const bool isSoma = types[parent] == brion::enums::SECTION_SOMA;
+        for (const uint32_t child : getChildren(parent))
+        {
+            _distancesToSoma[child] =
+                _distancesToSoma[parent] + _sectionLengths[parent];
+            _branchOrders[child] = isSoma ? 1 : _branchOrders[parent] + 1;
+            stack.push_back(child);
+        }
     }
-    return result;
 }
 }
 }
@@ -23,14 +23,18 @@
 
 #include "morphology.h"
 
+#include <brion/flatMorphology.h>
 #include <brion/morphology.h>
-#include <lunchbox/lfVector.h>
+#include <lunchbox/log.h>
 #include <vmmlib/matrix.hpp> // member
 
+#include <mutex>
+
 namespace brain
 {
 namespace neuron
 {
+class SegmentBVH;
 typedef std::pair<size_t, size_t> SectionRange;
 
 class Morphology::Impl
@@ -46,7 +50,19 @@ public:
     Impl(const URI& source, const Matrix4f& transform);
     explicit Impl(brion::ConstMorphologyPtr morphology);
     Impl(brion::MorphologyPtr morphology, const Matrix4f& transform);
+    Impl(brion::ConstMorphologyPtr morphology, const Matrix4f& transform);
     Impl(const void* data, const size_t size);
+    ~Impl();
+
+    /**
+     * @return the points in the coordinate system of the transformation. For
+     *         morphologies sharing untransformed data they are computed on
+     *         first use.
+     */
+    const Vector4fs& getPoints() const;
+
+    /** @return the morphology serialized with its points transformed. */
+    servus::Serializable::Data toBinary() const;
 
     SectionRange getSectionRange(const uint32_t sectionID) const;
 
@@ -60,26 +76,54 @@ public:
     Vector4fs getSectionSamples(const uint32_t sectionID,
                                 const floats& samplePoints) const;
 
+    void getSectionSamples(const uint32_ts& sectionIDs,
+                           const floats& samplePoints, float* x, float* y,
+                           float* z, float* diameters) const;
+
     float getDistanceToSoma(const uint32_t sectionID) const;
 
     floats getSampleDistancesToSoma(const uint32_t sectionID) const;
 
-    const uint32_ts& getChildren(const uint32_t sectionID) const;
+    uint32_t getBranchOrder(const uint32_t sectionID) const;
 
-private:
-    // Distances caches. These caches need to be thread-safe to follow the
-    // recommendations for C++11 about mutable and const correctness.
-    // (http://herbsutter.com/2013/05/24/gotw-6a-const-correctness-part-1-3/)
-    typedef lunchbox::LFVector<float> LFFloats;
-    mutable LFFloats _distancesToSoma;
-    mutable LFFloats _sectionLengths;
+    brion::ConstSpan<uint32_t> getChildren(const uint32_t sectionID) const;
+
+    /**
+     * @return the length from the start of its section for each point,
+     *         computed once for all sections on first use.
+     */
+    const floats& getAccumulatedLengths() const;
 
-    std::vector<uint32_ts> _sectionChildren;
+    /** @return the segment hierarchy, built on first use. */
+    const SegmentBVH& getBVH() const;
+
+private:
+    // Transformed points of morphologies which share their untransformed
+    // data, computed on first use.
+    const bool _sharedData = false;
+    mutable std::once_flag _pointsTransformed;
+    mutable Vector4fs _points;
+
+    mutable std::once_flag _bvhBuilt;
+    mutable std::unique_ptr<SegmentBVH> _bvh;
+
+    // Geometry derived from the points and sections, computed in one pass by
+    // _computeGeometry() on first use. The once flag makes the lazy
+    // computation thread-safe, afterwards the arrays are read-only.
+    mutable std::once_flag _geometryComputed;
+    mutable floats _accumulatedLengths; // per point
+    mutable floats _sectionLengths;     // per section
+    mutable floats _distancesToSoma;    // per section
+    mutable uint32_ts _branchOrders;    // per section
+
+    // children of all sections in compressed sparse row format
+    uint32_ts _childOffsets;
+    uint32_ts _children;
 
-    void _transform(brion::MorphologyPtr morphology);
     void _extractInformation();
-    float _computeSectionLength(const uint32_t sectionID) const;
-    floats _computeAccumulatedLengths(const SectionRange& range) const;
+    Vector4f _sample(const SectionRange& range, float position) const;
+    void _ensureGeometry() const;
+    void _computeGeometry() const;
 };
 }
 }
@@ -0,0 +1,230 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "morphometrics.h"
+#include "morphology.h"
+#include "section.h"
+#include "soma.h"
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace brain
+{
+namespace neuron
+{
+namespace
+{
+struct SegmentSums
+{
+    float area = 0;
+    float volume = 0;
+};
+
+/** Accumulate the truncated cone measures of the segments of a section. */
+void _addSegments(const Vector4f* points, const size_t size, SegmentSums& sums)
+{
+    float area = 0;
+    float volume = 0;
+    for (size_t i = 1; i < size; ++i)
+    {
+        const float dx = points[i][0] - points[i - 1][0];
+        const float dy = points[i][1] - points[i - 1][1];
+        const float dz = points[i][2] - points[i - 1][2];
+        const float r0 = points[i - 1][3] * .5f;
+        const float r1 = points[i][3] * .5f;
+        const float height = std::sqrt(dx * dx + dy * dy + dz * dz);
+        const float dr = r1 - r0;
+        area += (r0 + r1) * std::sqrt(dr * dr + height * height);
+        volume += height * (r0 * r0 + r0 * r1 + r1 * r1);
+    }
+    sums.area += float(M_PI) * area;
+    sums.volume += float(M_PI) / 3.f * volume;
+}
+
+/**
+ * Length and topological measures of a morphology, from the section lengths,
+ * branch orders and children cached by the morphology.
+ */
+struct Topology
+{
+    Topology() {}
+    explicit Topology(const Morphology& morphology)
+    {
+        const auto& types = morphology.getSectionTypes();
+        for (size_t i = 0; i < types.size(); ++i)
+        {
+            if (types[i] == SectionType::soma)
+                continue;
+            const Section section = morphology.getSection(i);
+            const size_t numChildren = section.getNumChildren();
+            totalLength += section.getLength();
+            ++sectionCount;
+            if (numChildren >= 2)
+                ++bifurcationCount;
+            if (numChildren == 0)
+                ++terminalCount;
+            maxBranchOrder = std::max(maxBranchOrder, section.getBranchOrder());
+        }
+    }
+
+    float totalLength = 0;
+    uint32_t sectionCount = 0;
+    uint32_t bifurcationCount = 0;
+    uint32_t terminalCount = 0;
+    uint32_t maxBranchOrder = 0;
+};
+
+SegmentSums _computeSegmentSums(const Morphology& morphology)
+{
+    const auto& points = morphology.getPoints();
+    const auto& sections = morphology.getSections();
+    const auto& types = morphology.getSectionTypes();
+
+    SegmentSums sums;
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        if (types[i] == SectionType::soma)
+            continue;
+        const size_t begin = sections[i][0];
+        const size_t end =
+            i + 1 < sections.size() ? sections[i + 1][0] : points.size();
+        if (end > begin)
+            _addSegments(points.data() + begin, end - begin, sums);
+    }
+    return sums;
+}
+
+bool _needs(const Morphometrics& metrics,
+            std::initializer_list<Morphometric> candidates)
+{
+    for (const Morphometric metric : metrics)
+        for (const Morphometric candidate : candidates)
+            if (metric == candidate)
+                return true;
+    return false;
+}
+}
+
+std::vector<floats> computeMorphometrics(const Morphologies& morphologies,
+                                         const Morphometrics& metrics)
+{
+    std::vector<floats> columns(metrics.size(),
+                                floats(morphologies.size(), 0.f));
+    const bool needSegments =
+        _needs(metrics, {Morphometric::surfaceArea, Morphometric::volume});
+    const bool needTopology =
+        _needs(metrics, {Morphometric::totalLength, Morphometric::sectionCount,
+                         Morphometric::bifurcationCount,
+                         Morphometric::terminalCount,
+                         Morphometric::maxBranchOrder});
+
+    const int64_t size = morphologies.size();
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < size; ++i)
+    {
+        const Morphology& morphology = *morphologies[i];
+        const SegmentSums sums =
+            needSegments ? _computeSegmentSums(morphology) : SegmentSums();
+        const Topology topology =
+            needTopology ? Topology(morphology) : Topology();
+        for (size_t j = 0; j < metrics.size(); ++j)
+        {
+            float& value = columns[j][i];
+            switch (metrics[j])
+            {
+            case Morphometric::totalLength:
+                value = topology.totalLength;
+                break;
+            case Morphometric::surfaceArea:
+                value = sums.area;
+                break;
+            case Morphometric::volume:
+                value = sums.volume;
+                break;
+            case Morphometric::sectionCount:
+                value = topology.sectionCount;
+                break;
+            case Morphometric::bifurcationCount:
+                value = topology.bifurcationCount;
+                break;
+            case Morphometric::terminalCount:
+                value = topology.terminalCount;
+                break;
+            case Morphometric::maxBranchOrder:
+                value = topology.maxBranchOrder;
+                break;
+            case Morphometric::somaRadius:
+                value = morphology.getSoma().getMeanRadius();
+                break;
+            }
+        }
+    }
+    return columns;
+}
+
+uint32_ts computeShollProfiles(const Morphologies& morphologies,
+                               const float radiusStep, const size_t numShells)
+{
+    if (!(radiusStep > 0))
+        LBTHROW(std::runtime_error("Sholl radius step must be positive"));
+
+    uint32_ts profiles(morphologies.size() * numShells, 0);
+    const int64_t size = morphologies.size();
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < size; ++i)
+    {
+        const Morphology& morphology = *morphologies[i];
+        const auto& points = morphology.getPoints();
+        const auto& sections = morphology.getSections();
+        const auto& types = morphology.getSectionTypes();
+        const Vector3f center = morphology.getSoma().getCentroid();
+        uint32_t* profile = profiles.data() + i * numShells;
+
+        for (size_t j = 0; j < sections.size(); ++j)
+        {
+            if (types[j] == SectionType::soma)
+                continue;
+            const size_t begin = sections[j][0];
+            const size_t end =
+                j + 1 < sections.size() ? sections[j + 1][0] : points.size();
+            for (size_t k = begin + 1; k < end; ++k)
+            {
+                // The segment crosses the spheres with radii in (near, far],
+                // i.e. the shells with indices in [first, last).
+                const float d0 =
+                    (points[k - 1].get_sub_vector<3, 0>() - center).length();
+                const float d1 =
+                    (points[k].get_sub_vector<3, 0>() - center).length();
+                const float inner = std::min(d0, d1) / radiusStep;
+                const float outer = std::max(d0, d1) / radiusStep;
+                const size_t first = std::floor(inner);
+                const size_t last =
+                    std::min(float(numShells), std::floor(outer));
+                for (size_t shell = first; shell < last; ++shell)
+                    ++profile[shell];
+            }
+        }
+    }
+    return profiles;
+}
+}
+}
@@ -0,0 +1,84 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_NEURON_MORPHOMETRICS
+#define BRAIN_NEURON_MORPHOMETRICS
+
+#include <brain/api.h>
+#include <brain/neuron/types.h>
+#include <brain/types.h>
+
+namespace brain
+{
+namespace neuron
+{
+/**
+ * Morphometric measures of a morphology.
+ *
+ * Except for the soma radius, all measures only consider the sections which
+ * are not soma sections. Segments are modelled as truncated cones between
+ * two consecutive points of a section.
+ */
+enum class Morphometric
+{
+    totalLength,      //!< sum of the segment lengths in micrometers
+    surfaceArea,      //!< sum of the lateral segment areas in micrometers^2
+    volume,           //!< sum of the segment volumes in micrometers^3
+    sectionCount,     //!< number of sections
+    bifurcationCount, //!< number of sections with two or more children
+    terminalCount,    //!< number of sections without children
+    maxBranchOrder,   //!< @sa Section::getBranchOrder()
+    somaRadius        //!< @sa Soma::getMeanRadius()
+};
+typedef std::vector<Morphometric> Morphometrics;
+
+/**
+ * Compute morphometric measures of many morphologies.
+ *
+ * The morphologies are processed in parallel.
+ *
+ * @param morphologies the morphologies to measure.
+ * @param metrics the measures to compute.
+ * @return one column per requested measure, in the order of the metrics,
+ *         with one value per morphology.
+ * @version 3.0
+ */
+BRAIN_API std::vector<floats> computeMorphometrics(
+    const Morphologies& morphologies, const Morphometrics& metrics);
+
+/**
+ * Compute the Sholl profiles of many morphologies.
+ *
+ * The profile of a morphology counts the segments crossing spheres around the
+ * soma centroid with radii radiusStep * (i + 1), for i in [0, numShells). A
+ * segment crosses a sphere if one of its points is inside and the other one
+ * on or outside of the sphere. The morphologies are processed in parallel.
+ *
+ * @param morphologies the morphologies to measure.
+ * @param radiusStep the radius increment between two spheres in micrometers.
+ * @param numShells the number of spheres.
+ * @return the crossing counts, numShells consecutive values per morphology.
+ * @throw std::runtime_error if radiusStep is not positive.
+ * @version 3.0
+ */
+BRAIN_API uint32_ts computeShollProfiles(const Morphologies& morphologies,
+                                         float radiusStep, size_t numShells);
+}
+}
+#endif
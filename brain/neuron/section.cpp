@@ -96,6 +96,11 @@ floats Section::getSampleDistancesToSoma() const
     return _morphology->getSampleDistancesToSoma(_id);
 }
 
+uint32_t Section::getBranchOrder() const
+{
+    return _morphology->getBranchOrder(_id);
+}
+
 bool Section::hasParent() const
 {
     const int32_t parent = _morphology->data->getSections()[_id][1];
@@ -111,12 +116,17 @@ Section Section::getParent() const
 
 Sections Section::getChildren() const
 {
-    const uint32_ts& children = _morphology->getChildren(_id);
+    const auto children = _morphology->getChildren(_id);
     Sections result;
     result.reserve(children.size());
     for (const uint32_t id : children)
         result.push_back(Section(id, _morphology));
     return result;
 }
+
+size_t Section::getNumChildren() const
+{
+    return _morphology->getChildren(_id).size();
+}
 }
 }
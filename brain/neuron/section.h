@@ -112,6 +112,14 @@ public:
      */
     BRAIN_API floats getSampleDistancesToSoma() const;
 
+    /**
+     * Return the branch order of this section.
+     *
+     * Sections connected to the soma have order 1 and the order increases by
+     * one at each bifurcation.
+     */
+    BRAIN_API uint32_t getBranchOrder() const;
+
     /** Return true if this section has a parent section, false otherwise. */
     BRAIN_API bool hasParent() const;
 
@@ -130,6 +138,9 @@ public:
      */
     BRAIN_API Sections getChildren() const;
 
+    /** Return the number of direct children of this section. */
+    BRAIN_API size_t getNumChildren() const;
+
 private:
     BRAIN_API Section(uint32_t id, Morphology::ImplPtr morphology);
     friend class Morphology;
@@ -0,0 +1,411 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "segmentBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+namespace brain
+{
+namespace neuron
+{
+namespace
+{
+const uint32_t MAX_LEAF_SIZE = 4;
+
+/** @return the parameter in [0, 1] of the point on [a, b] closest to p. */
+float _closestParameter(const Vector3f& p, const Vector3f& a,
+                        const Vector3f& b)
+{
+    const Vector3f ab = b - a;
+    const float length2 = ab.squared_length();
+    if (length2 == 0)
+        return 0;
+    return std::max(0.f, std::min(1.f, (p - a).dot(ab) / length2));
+}
+
+float _getDistance(const Vector3f& p, const Vector3f& a, const Vector3f& b)
+{
+    const float t = _closestParameter(p, a, b);
+    return (p - (a + (b - a) * t)).length();
+}
+
+/** @return the distance from the segment [a, b] to the box. */
+float _getDistance(const Bounds& box, const Vector3f& a, const Vector3f& b)
+{
+    // The distance of a point to a convex set is a convex function, so a
+    // ternary search along the segment converges to the minimum.
+    float low = 0;
+    float high = 1;
+    const Vector3f ab = b - a;
+    for (size_t i = 0; i < 32 && high - low > 1e-6f; ++i)
+    {
+        const float t1 = low + (high - low) / 3;
+        const float t2 = high - (high - low) / 3;
+        if (box.getDistance(a + ab * t1) <= box.getDistance(a + ab * t2))
+            high = t2;
+        else
+            low = t1;
+    }
+    return std::min({box.getDistance(a), box.getDistance(b),
+                     box.getDistance(a + ab * ((low + high) * .5f))});
+}
+
+/** @return the entry distance of the ray into the sphere, or -1. */
+float _intersectSphere(const Vector3f& origin, const Vector3f& direction,
+                       const Vector3f& center, const float radius)
+{
+    const Vector3f oc = origin - center;
+    const float b = oc.dot(direction);
+    const float c = oc.squared_length() - radius * radius;
+    const float h = b * b - c;
+    if (h < 0)
+        return -1;
+    return -b - std::sqrt(h);
+}
+
+/**
+ * @return the entry distance of a ray starting outside of the capsule, or a
+ *         negative value if it misses it.
+ */
+float _intersectCapsule(const Vector3f& origin, const Vector3f& direction,
+                        const Vector3f& a, const Vector3f& b,
+                        const float radius)
+{
+    // The capsule is the union of a finite cylinder and two spheres, so the
+    // entry point is the closest entry into any of them. A ray entering the
+    // infinite cylinder outside of the finite part enters the finite part
+    // through an end disk, which lies inside of an end sphere.
+    float entry = -1;
+    auto update = [&entry](const float t) {
+        if (t >= 0 && (entry < 0 || t < entry))
+            entry = t;
+    };
+
+    const Vector3f ba = b - a;
+    const Vector3f oa = origin - a;
+    const float baba = ba.dot(ba);
+    const float bard = ba.dot(direction);
+    const float baoa = ba.dot(oa);
+    const float rdoa = direction.dot(oa);
+    const float oaoa = oa.dot(oa);
+    const float qa = baba - bard * bard;
+    if (baba > 0 && qa > 0)
+    {
+        const float qb = baba * rdoa - baoa * bard;
+        const float qc = baba * oaoa - baoa * baoa - radius * radius * baba;
+        const float h = qb * qb - qa * qc;
+        if (h >= 0)
+        {
+            const float t = (-qb - std::sqrt(h)) / qa;
+            const float y = baoa + t * bard;
+            if (y > 0 && y < baba)
+                update(t);
+        }
+    }
+    update(_intersectSphere(origin, direction, a, radius));
+    update(_intersectSphere(origin, direction, b, radius));
+    return entry;
+}
+}
+
+Bounds::Bounds()
+    : min(FLT_MAX, FLT_MAX, FLT_MAX)
+    , max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+{
+}
+
+Bounds::Bounds(const Vector3f& min_, const Vector3f& max_)
+    : min(min_)
+    , max(max_)
+{
+}
+
+void Bounds::merge(const Bounds& other)
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        min[i] = std::min(min[i], other.min[i]);
+        max[i] = std::max(max[i], other.max[i]);
+    }
+}
+
+void Bounds::merge(const Vector3f& point)
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        min[i] = std::min(min[i], point[i]);
+        max[i] = std::max(max[i], point[i]);
+    }
+}
+
+bool Bounds::isEmpty() const
+{
+    return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+}
+
+bool Bounds::overlaps(const Bounds& other) const
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (min[i] > other.max[i] || max[i] < other.min[i])
+            return false;
+    }
+    return true;
+}
+
+float Bounds::getDistance(const Vector3f& point) const
+{
+    float distance2 = 0;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const float d = std::max({min[i] - point[i], 0.f, point[i] - max[i]});
+        distance2 += d * d;
+    }
+    return std::sqrt(distance2);
+}
+
+float Bounds::intersect(const Vector3f& origin, const Vector3f& direction) const
+{
+    float near = 0;
+    float far = FLT_MAX;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (direction[i] == 0)
+        {
+            if (origin[i] < min[i] || origin[i] > max[i])
+                return -1;
+            continue;
+        }
+        const float inverse = 1.f / direction[i];
+        float t1 = (min[i] - origin[i]) * inverse;
+        float t2 = (max[i] - origin[i]) * inverse;
+        if (t1 > t2)
+            std::swap(t1, t2);
+        near = std::max(near, t1);
+        far = std::min(far, t2);
+        if (near > far)
+            return -1;
+    }
+    return near;
+}
+
+BoxTree::BoxTree(const Boundss& items)
+    : _items(items)
+    , _order(items.size())
+{
+    std::iota(_order.begin(), _order.end(), 0);
+    if (items.empty())
+        return;
+    _nodes.reserve(2 * (items.size() / MAX_LEAF_SIZE + 1));
+    _build(0, items.size());
+}
+
+const Bounds& BoxTree::getBounds() const
+{
+    static const Bounds empty;
+    return _nodes.empty() ? empty : _nodes[0].bounds;
+}
+
+void BoxTree::_build(const uint32_t begin, const uint32_t end)
+{
+    const uint32_t index = _nodes.size();
+    _nodes.push_back(Node());
+
+    Bounds bounds;
+    Bounds centers;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const Bounds& item = _items[_order[i]];
+        bounds.merge(item);
+        centers.merge((item.min + item.max) * .5f);
+    }
+    _nodes[index].bounds = bounds;
+
+    if (end - begin <= MAX_LEAF_SIZE)
+    {
+        _nodes[index].first = begin;
+        _nodes[index].count = end - begin;
+        return;
+    }
+
+    // median split along the longest axis of the item centers
+    const Vector3f extent = centers.max - centers.min;
+    const size_t axis = extent[0] > extent[1]
+                            ? (extent[0] > extent[2] ? 0 : 2)
+                            : (extent[1] > extent[2] ? 1 : 2);
+    const uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(_order.begin() + begin, _order.begin() + middle,
+                     _order.begin() + end,
+                     [this, axis](const uint32_t a, const uint32_t b) {
+                         return _items[a].min[axis] + _items[a].max[axis] <
+                                _items[b].min[axis] + _items[b].max[axis];
+                     });
+
+    _build(begin, middle);
+    _nodes[index].first = _nodes.size();
+    _nodes[index].count = 0;
+    _build(middle, end);
+}
+
+SegmentBVH::SegmentBVH(const Vector4fs& points, const Vector2is& sections,
+                       const brion::SectionTypes& types)
+    : _segments(_collectSegments(points, sections, types))
+    , _tree(_getBounds(_segments))
+{
+}
+
+std::vector<SegmentBVH::Segment> SegmentBVH::_collectSegments(
+    const Vector4fs& points, const Vector2is& sections,
+    const brion::SectionTypes& types)
+{
+    std::vector<Segment> segments;
+    segments.reserve(points.size());
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        if (types[i] == brion::enums::SECTION_SOMA)
+            continue;
+
+        const size_t begin = sections[i][0];
+        const size_t end =
+            i + 1 < sections.size() ? sections[i + 1][0] : points.size();
+        for (size_t j = begin; j + 1 < end; ++j)
+        {
+            const Vector4f& start = points[j];
+            const Vector4f& stop = points[j + 1];
+            segments.push_back({start.get_sub_vector<3, 0>(),
+                                stop.get_sub_vector<3, 0>(),
+                                std::max(start[3], stop[3]) * .5f,
+                                uint32_t(i), uint32_t(j - begin)});
+        }
+    }
+    return segments;
+}
+
+Boundss SegmentBVH::_getBounds(const std::vector<Segment>& segments)
+{
+    Boundss bounds(segments.size());
+    const int64_t size = segments.size();
+#pragma omp parallel for
+    for (int64_t i = 0; i < size; ++i)
+    {
+        const Segment& segment = segments[i];
+        const Vector3f radius(segment.radius, segment.radius, segment.radius);
+        Bounds& box = bounds[i];
+        box.merge(segment.start - radius);
+        box.merge(segment.start + radius);
+        box.merge(segment.end - radius);
+        box.merge(segment.end + radius);
+    }
+    return bounds;
+}
+
+void SegmentBVH::intersectRay(const Vector3f& origin,
+                              const Vector3f& direction,
+                              SegmentHits& hits) const
+{
+    _tree.traverse(
+        [&](const Bounds& bounds) {
+            return bounds.intersect(origin, direction) >= 0;
+        },
+        [&](const uint32_t i) {
+            const Segment& segment = _segments[i];
+            float distance = 0;
+            if (_getDistance(origin, segment.start, segment.end) >
+                segment.radius)
+            {
+                distance = _intersectCapsule(origin, direction, segment.start,
+                                             segment.end, segment.radius);
+                if (distance < 0)
+                    return;
+            }
+            hits.push_back({0, segment.section, segment.segment, distance});
+        });
+}
+
+void SegmentBVH::intersectBox(const Bounds& box, SegmentHits& hits) const
+{
+    _tree.traverse([&](const Bounds& bounds) { return bounds.overlaps(box); },
+                   [&](const uint32_t i) {
+                       const Segment& segment = _segments[i];
+                       const float distance =
+                           _getDistance(box, segment.start, segment.end);
+                       if (distance <= segment.radius)
+                           hits.push_back({0, segment.section,
+                                           segment.segment, distance});
+                   });
+}
+
+void SegmentBVH::intersectSphere(const Vector3f& center, const float radius,
+                                 SegmentHits& hits) const
+{
+    _tree.traverse(
+        [&](const Bounds& bounds) {
+            return bounds.getDistance(center) <= radius;
+        },
+        [&](const uint32_t i) {
+            const Segment& segment = _segments[i];
+            const float distance =
+                _getDistance(center, segment.start, segment.end) -
+                segment.radius;
+            if (distance <= radius)
+                hits.push_back({0, segment.section, segment.segment,
+                                std::max(0.f, distance)});
+        });
+}
+
+bool SegmentBVH::findNearest(const Vector3f& point, SegmentHit& hit) const
+{
+    bool found = false;
+    _tree.traverseNearest(
+        [&](const Bounds& bounds) { return bounds.getDistance(point); },
+        [&](const uint32_t i) {
+            const Segment& segment = _segments[i];
+            const float distance = std::max(
+                0.f, _getDistance(point, segment.start, segment.end) -
+                         segment.radius);
+            if (distance < hit.distance)
+            {
+                hit.section = segment.section;
+                hit.segment = segment.segment;
+                hit.distance = distance;
+                found = true;
+            }
+            return hit.distance;
+        },
+        hit.distance);
+    return found;
+}
+
+void sortHits(SegmentHits& hits)
+{
+    std::sort(hits.begin(), hits.end(),
+              [](const SegmentHit& a, const SegmentHit& b) {
+                  return std::tie(a.distance, a.morphology, a.section,
+                                  a.segment) < std::tie(b.distance,
+                                                        b.morphology,
+                                                        b.section, b.segment);
+              });
+}
+}
+}
@@ -0,0 +1,242 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_NEURON_SEGMENTBVH
+#define BRAIN_NEURON_SEGMENTBVH
+
+#include <brain/neuron/types.h>
+#include <brain/types.h>
+
+#include <vmmlib/vector.hpp> // member
+
+namespace brain
+{
+namespace neuron
+{
+/** Axis-aligned box, empty on construction. */
+struct Bounds
+{
+    Bounds();
+    Bounds(const Vector3f& min, const Vector3f& max);
+
+    void merge(const Bounds& other);
+    void merge(const Vector3f& point);
+    bool isEmpty() const;
+    bool overlaps(const Bounds& other) const;
+
+    /** @return the distance from the point to the box, 0 if inside. */
+    float getDistance(const Vector3f& point) const;
+
+    /**
+     * @return the entry distance of the ray into the box, or a negative value
+     *         if the ray misses it. The direction must be normalized.
+     */
+    float intersect(const Vector3f& origin, const Vector3f& direction) const;
+
+    Vector3f min;
+    Vector3f max;
+};
+typedef std::vector<Bounds> Boundss;
+
+/**
+ * Bounding volume hierarchy over a set of boxes.
+ *
+ * The tree is built by recursive median splits along the longest axis of the
+ * box centers. Nodes are stored in depth-first order so the left child of a
+ * node directly follows it.
+ */
+class BoxTree
+{
+public:
+    /** Build the tree over the given item bounds. */
+    explicit BoxTree(const Boundss& items);
+
+    /** @return the bounds of all items. */
+    const Bounds& getBounds() const;
+
+    /**
+     * Visit all items whose bounds pass the node test, in tree order.
+     *
+     * @param test called with the bounds of each node and item, returns true
+     *        if the subtree or item may contain results.
+     * @param visit called with the index of each item passing the test.
+     */
+    template <typename TestFunc, typename VisitFunc>
+    void traverse(const TestFunc& test, const VisitFunc& visit) const;
+
+    /**
+     * Visit items in increasing distance of their bounds, stopping at items
+     * further than the distance returned by the last visit.
+     *
+     * @param distance called with bounds, returns the lower bound of the
+     *        distance to the query for any item inside.
+     * @param visit called with an item index, returns the current maximum
+     *        distance of interest.
+     * @param maxDistance the initial maximum distance of interest.
+     */
+    template <typename DistanceFunc, typename VisitFunc>
+    void traverseNearest(const DistanceFunc& distance, const VisitFunc& visit,
+                         float maxDistance) const;
+
+private:
+    struct Node
+    {
+        Bounds bounds;
+        uint32_t first;  //!< first item of leaves, right child otherwise
+        uint32_t count;  //!< number of items of leaves, 0 otherwise
+    };
+
+    std::vector<Node> _nodes;
+    Boundss _items;
+    uint32_ts _order; //!< item indices in leaf order
+
+    void _build(uint32_t begin, uint32_t end);
+};
+
+/**
+ * Bounding volume hierarchy over the segments of a morphology.
+ *
+ * Each segment is treated as a capsule around the segment between two
+ * consecutive points of a section, with the larger radius of its two points.
+ * Soma sections are not included.
+ */
+class SegmentBVH
+{
+public:
+    SegmentBVH(const Vector4fs& points, const Vector2is& sections,
+               const brion::SectionTypes& types);
+
+    const Bounds& getBounds() const { return _tree.getBounds(); }
+
+    /** Add the segments hit by the ray with their entry distance. */
+    void intersectRay(const Vector3f& origin, const Vector3f& direction,
+                      SegmentHits& hits) const;
+
+    /** Add the segments intersecting the box with their axis distance. */
+    void intersectBox(const Bounds& box, SegmentHits& hits) const;
+
+    /** Add the segments intersecting the sphere with their distance. */
+    void intersectSphere(const Vector3f& center, float radius,
+                         SegmentHits& hits) const;
+
+    /**
+     * Find the segment nearest to the point if it is closer than the
+     * distance of the given hit, and update the hit in that case.
+     *
+     * @return true if the hit was updated.
+     */
+    bool findNearest(const Vector3f& point, SegmentHit& hit) const;
+
+private:
+    struct Segment
+    {
+        Vector3f start;
+        Vector3f end;
+        float radius;
+        uint32_t section;
+        uint32_t segment;
+    };
+    std::vector<Segment> _segments;
+    BoxTree _tree;
+
+    static std::vector<Segment> _collectSegments(
+        const Vector4fs& points, const Vector2is& sections,
+        const brion::SectionTypes& types);
+    static Boundss _getBounds(const std::vector<Segment>& segments);
+};
+
+/** Sort hits by distance, then by morphology, section and segment. */
+void sortHits(SegmentHits& hits);
+
+template <typename TestFunc, typename VisitFunc>
+void BoxTree::traverse(const TestFunc& test, const VisitFunc& visit) const
+{
+    if (_nodes.empty())
+        return;
+
+    uint32_ts stack{0};
+    while (!stack.empty())
+    {
+        const Node& node = _nodes[stack.back()];
+        const uint32_t index = stack.back();
+        stack.pop_back();
+        if (!test(node.bounds))
+            continue;
+
+        if (node.count == 0)
+        {
+            stack.push_back(node.first);
+            stack.push_back(index + 1);
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            if (test(_items[_order[i]]))
+                visit(_order[i]);
+        }
+    }
+}
+
+template <typename DistanceFunc, typename VisitFunc>
+void BoxTree::traverseNearest(const DistanceFunc& distance,
+                              const VisitFunc& visit, float maxDistance) const
+{
+    if (_nodes.empty())
+        return;
+
+    // Depth-first with the closer child first, which finds a close candidate
+    // quickly and prunes the remaining subtrees by their distance.
+    std::vector<std::pair<float, uint32_t>> stack{
+        {distance(_nodes[0].bounds), 0}};
+    while (!stack.empty())
+    {
+        const auto entry = stack.back();
+        stack.pop_back();
+        if (entry.first > maxDistance)
+            continue;
+
+        const Node& node = _nodes[entry.second];
+        if (node.count == 0)
+        {
+            const uint32_t left = entry.second + 1;
+            const uint32_t right = node.first;
+            const float leftDistance = distance(_nodes[left].bounds);
+            const float rightDistance = distance(_nodes[right].bounds);
+            if (leftDistance < rightDistance)
+            {
+                stack.emplace_back(rightDistance, right);
+                stack.emplace_back(leftDistance, left);
+            }
+            else
+            {
+                stack.emplace_back(leftDistance, left);
+                stack.emplace_back(rightDistance, right);
+            }
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            if (distance(_items[_order[i]]) <= maxDistance)
+                maxDistance = visit(_order[i]);
+        }
+    }
+}
+}
+}
+#endif
@@ -0,0 +1,159 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "segmentIndex.h"
+#include "morphology.h"
+#include "morphologyImpl.h"
+#include "segmentBVH.h"
+
+#include <lunchbox/log.h>
+
+#include <limits>
+
+namespace brain
+{
+namespace neuron
+{
+namespace
+{
+std::vector<const SegmentBVH*> _buildBVHs(
+    const std::vector<Morphology::ImplPtr>& morphologies)
+{
+    std::vector<const SegmentBVH*> bvhs(morphologies.size());
+    const int64_t size = morphologies.size();
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < size; ++i)
+        bvhs[i] = &morphologies[i]->getBVH();
+    return bvhs;
+}
+
+Boundss _getBounds(const std::vector<const SegmentBVH*>& bvhs)
+{
+    Boundss bounds;
+    bounds.reserve(bvhs.size());
+    for (const SegmentBVH* bvh : bvhs)
+        bounds.push_back(bvh->getBounds());
+    return bounds;
+}
+}
+
+class SegmentIndex::Impl
+{
+public:
+    explicit Impl(std::vector<Morphology::ImplPtr> morphologies_)
+        : morphologies(std::move(morphologies_))
+        , bvhs(_buildBVHs(morphologies))
+        , tree(_getBounds(bvhs))
+    {
+    }
+
+    template <typename TestFunc, typename QueryFunc>
+    SegmentHits query(const TestFunc& test, const QueryFunc& query) const
+    {
+        SegmentHits hits;
+        tree.traverse(test, [&](const uint32_t i) {
+            const size_t first = hits.size();
+            query(*bvhs[i], hits);
+            for (size_t j = first; j < hits.size(); ++j)
+                hits[j].morphology = i;
+        });
+        sortHits(hits);
+        return hits;
+    }
+
+    // keep the morphologies alive, which own the hierarchies
+    const std::vector<Morphology::ImplPtr> morphologies;
+    const std::vector<const SegmentBVH*> bvhs;
+    const BoxTree tree;
+};
+
+SegmentIndex::SegmentIndex(const Morphologies& morphologies)
+{
+    std::vector<Morphology::ImplPtr> impls;
+    impls.reserve(morphologies.size());
+    for (const auto& morphology : morphologies)
+        impls.push_back(morphology->_impl);
+    _impl.reset(new Impl(std::move(impls)));
+}
+
+SegmentIndex::~SegmentIndex()
+{
+}
+
+SegmentHits SegmentIndex::intersectRay(const Vector3f& origin,
+                                       const Vector3f& direction) const
+{
+    const float length = direction.length();
+    if (length == 0)
+        LBTHROW(std::runtime_error("Invalid ray direction"));
+
+    const Vector3f normalized = direction / length;
+    return _impl->query(
+        [&](const Bounds& bounds) {
+            return bounds.intersect(origin, normalized) >= 0;
+        },
+        [&](const SegmentBVH& bvh, SegmentHits& hits) {
+            bvh.intersectRay(origin, normalized, hits);
+        });
+}
+
+SegmentHits SegmentIndex::intersectBox(const AABBf& box) const
+{
+    const Bounds bounds(box.getMin(), box.getMax());
+    return _impl->query(
+        [&](const Bounds& other) { return other.overlaps(bounds); },
+        [&](const SegmentBVH& bvh, SegmentHits& hits) {
+            bvh.intersectBox(bounds, hits);
+        });
+}
+
+SegmentHits SegmentIndex::intersectSphere(const Vector3f& center,
+                                          const float radius) const
+{
+    return _impl->query(
+        [&](const Bounds& bounds) {
+            return bounds.getDistance(center) <= radius;
+        },
+        [&](const SegmentBVH& bvh, SegmentHits& hits) {
+            bvh.intersectSphere(center, radius, hits);
+        });
+}
+
+SegmentHit SegmentIndex::getNearestSegment(const Vector3f& point) const
+{
+    SegmentHit hit{0, 0, 0, std::numeric_limits<float>::infinity()};
+    bool found = false;
+    _impl->tree.traverseNearest(
+        [&](const Bounds& bounds) { return bounds.getDistance(point); },
+        [&](const uint32_t i) {
+            if (_impl->bvhs[i]->findNearest(point, hit))
+            {
+                hit.morphology = i;
+                found = true;
+            }
+            return hit.distance;
+        },
+        hit.distance);
+
+    if (!found)
+        LBTHROW(std::runtime_error("No segments in index"));
+    return hit;
+}
+}
+}
@@ -0,0 +1,82 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_NEURON_SEGMENTINDEX
+#define BRAIN_NEURON_SEGMENTINDEX
+
+#include <brain/api.h>
+#include <brain/neuron/types.h>
+#include <brain/types.h>
+
+#include <boost/noncopyable.hpp>
+#include <vmmlib/aabb.hpp> // parameter
+
+namespace brain
+{
+namespace neuron
+{
+/**
+ * Spatial index over the segments of a set of morphologies.
+ *
+ * Combines the segment hierarchies of the given morphologies, typically the
+ * result of Circuit::loadMorphologies() in global coordinates, under a
+ * hierarchy of their bounding boxes. The queries have the same semantics as
+ * the spatial queries of Morphology, and report the index of the morphology
+ * of each segment in the morphologies passed at construction.
+ *
+ * @version 3.0
+ */
+class SegmentIndex : public boost::noncopyable
+{
+public:
+    /**
+     * Build the index over the given morphologies.
+     *
+     * The hierarchies of the morphologies are built in parallel if they have
+     * not been built by previous queries. The index keeps a reference on the
+     * morphologies.
+     */
+    BRAIN_API explicit SegmentIndex(const Morphologies& morphologies);
+
+    BRAIN_API ~SegmentIndex();
+
+    /** @sa Morphology::intersectRay */
+    BRAIN_API SegmentHits intersectRay(const Vector3f& origin,
+                                       const Vector3f& direction) const;
+
+    /** @sa Morphology::intersectBox */
+    BRAIN_API SegmentHits intersectBox(const AABBf& box) const;
+
+    /** @sa Morphology::intersectSphere */
+    BRAIN_API SegmentHits intersectSphere(const Vector3f& center,
+                                          float radius) const;
+
+    /**
+     * @sa Morphology::getNearestSegment
+     * @throw runtime_error if none of the morphologies has segments.
+     */
+    BRAIN_API SegmentHit getNearestSegment(const Vector3f& point) const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
+}
+#endif
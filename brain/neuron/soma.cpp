@@ -77,8 +77,7 @@ Vector3f Soma::getCentroid() const
 
 Sections Soma::getChildren() const
 {
-    const uint32_ts& children =
-        _morphology->getChildren(_morphology->somaSection);
+    const auto children = _morphology->getChildren(_morphology->somaSection);
     Sections result;
     for (const uint32_t id : children)
         result.push_back(Section(id, _morphology));
@@ -21,6 +21,7 @@
 #define BRAIN_NEURON_TYPES
 
 #include <brion/enums.h>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -31,6 +32,7 @@ namespace neuron
 {
 class Morphology;
 class Section;
+class SegmentIndex;
 class Soma;
 
 enum class SectionType
@@ -42,11 +44,22 @@ enum class SectionType
     undefined = brion::enums::SECTION_UNDEFINED
 };
 
+/** A segment of a morphology found by a spatial query. */
+struct SegmentHit
+{
+    /** Index of the morphology in a SegmentIndex, 0 for Morphology queries */
+    size_t morphology;
+    uint32_t section; //!< ID of the section of the segment
+    uint32_t segment; //!< Index of the segment in its section
+    float distance;   //!< Query dependent distance to the segment
+};
+
 typedef std::shared_ptr<Morphology> MorphologyPtr;
 
 typedef std::vector<MorphologyPtr> Morphologies;
 typedef std::vector<Section> Sections;
 typedef std::vector<SectionType> SectionTypes;
+typedef std::vector<SegmentHit> SegmentHits;
 }
 }
 #endif
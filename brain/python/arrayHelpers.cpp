@@ -92,6 +92,7 @@ DECLARE_ARRAY_INFO(Vector3f, NPY_FLOAT, 2, 3)
 DECLARE_ARRAY_INFO(Vector4f, NPY_FLOAT, 2, 4)
 DECLARE_ARRAY_INFO(Quaternionf, NPY_FLOAT, 2, 4)
 DECLARE_ARRAY_INFO(Matrix4f, NPY_FLOAT, 3, 4, 4)
+DECLARE_ARRAY_INFO(Matrix3x4f, NPY_FLOAT, 3, 4, 3)
 DECLARE_STRUCTURED_ARRAY_INFO(CompartmentReportMapping::IndexEntry, "u4, u4")
 DECLARE_STRUCTURED_ARRAY_INFO(Spike, "f4, u4")
 
@@ -205,6 +206,7 @@ void importArray()
     REGISTER_ARRAY_CONVERTER(neuron::SectionType);
     REGISTER_ARRAY_CONVERTER(CompartmentReportMapping::IndexEntry);
     REGISTER_ARRAY_CONVERTER(Matrix4f);
+    REGISTER_ARRAY_CONVERTER(Matrix3x4f);
     REGISTER_ARRAY_CONVERTER(Quaternionf);
     REGISTER_ARRAY_CONVERTER(Spike);
     REGISTER_ARRAY_CONVERTER(Vector2i);
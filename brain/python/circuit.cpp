@@ -60,8 +60,10 @@ void _reorderDestructive(std::vector<T>& values, uint32_ts& order)
     }
 }
 
-template <typename MemberFunction>
-bp::object _getProperty(const Circuit& circuit, const MemberFunction& property,
+template <typename T>
+bp::object _getProperty(const Circuit& circuit,
+                        std::vector<T> (Circuit::*property)(const GIDSet&)
+                            const,
                         bp::object cellSet)
 {
     uint32_ts mapping;
@@ -100,6 +102,55 @@ bp::object Circuit_getRandomGIDs(const Circuit& circuit, const float fraction)
     return toNumpy(toVector(circuit.getRandomGIDs(fraction)));
 }
 
+Vector3f _toVector3f(const bp::object& point)
+{
+    if (bp::len(point) != 3)
+    {
+        PyErr_SetString(PyExc_ValueError, "Expected a 3-element point");
+        bp::throw_error_already_set();
+    }
+    return Vector3f(bp::extract<float>(point[0]), bp::extract<float>(point[1]),
+                    bp::extract<float>(point[2]));
+}
+
+bp::object Circuit_getGIDsInBox(const Circuit& circuit, bp::object min,
+                                bp::object max)
+{
+    const AABBf box(_toVector3f(min), _toVector3f(max));
+    return toNumpy(toVector(circuit.getGIDsInBox(box)));
+}
+
+bp::object Circuit_getGIDsInSphere(const Circuit& circuit, bp::object center,
+                                   const float radius)
+{
+    return toNumpy(
+        toVector(circuit.getGIDsInSphere(_toVector3f(center), radius)));
+}
+
+bp::object Circuit_getNearestGIDs(const Circuit& circuit, bp::object point,
+                                  const size_t count)
+{
+    return toNumpy(toVector(circuit.getNearestGIDs(_toVector3f(point), count)));
+}
+
+bp::object Circuit_getStratifiedRandomGIDs(
+    const Circuit& circuit, const float fraction,
+    const Circuit::Stratification stratification, const std::string& target)
+{
+    return toNumpy(toVector(
+        circuit.getStratifiedRandomGIDs(fraction, stratification, target)));
+}
+
+bp::object Circuit_getStratifiedRandomTargetsGIDs(const Circuit& circuit,
+                                                  const float fraction,
+                                                  bp::object targets)
+{
+    const Strings names{bp::stl_input_iterator<std::string>(targets),
+                        bp::stl_input_iterator<std::string>()};
+    return toNumpy(
+        toVector(circuit.getStratifiedRandomGIDs(fraction, names)));
+}
+
 #define GET_CIRCUIT_PROPERTY_FOR_GIDS(property)                               \
     bp::object Circuit_get##property(const Circuit& circuit, bp::object gids) \
     {                                                                         \
@@ -157,6 +208,30 @@ bp::object Circuit_getTransforms(const Circuit& circuit, bp::object gids)
     return matrices.attr("transpose")(0, 2, 1);
 }
 
+bp::object Circuit_getAffineTransforms(const Circuit& circuit, bp::object gids)
+{
+    bp::object matrices =
+        _getProperty(circuit, &Circuit::getAffineTransforms, gids);
+    // Same column-major storage as getTransforms, see above.
+    return matrices.attr("transpose")(0, 2, 1);
+}
+
+bp::object Circuit_getStats(const Circuit& circuit)
+{
+    const Circuit::Stats& stats = circuit.getStats();
+
+    bp::dict dict;
+    dict["config_parse"] = stats.configParse;
+    dict["circuit_open"] = stats.circuitOpen;
+    dict["target_parse"] = stats.targetParse;
+    dict["synapse_open"] = stats.synapseOpen;
+    dict["cache_open"] = stats.cacheOpen;
+    dict["cache_hits"] = stats.cacheHits;
+    dict["cache_misses"] = stats.cacheMisses;
+
+    return dict;
+}
+
 bp::object Circuit_getRotations(const Circuit& circuit, bp::object gids)
 {
     return _getProperty(circuit, &Circuit::getRotations, gids);
@@ -213,6 +288,11 @@ bp::enum_<Circuit::Coordinates>("Coordinates")
     .value("global_", Circuit::Coordinates::global)
     .value("local", Circuit::Coordinates::local);
 
+bp::enum_<Circuit::Stratification>("Stratification")
+    .value("morphology_type", Circuit::Stratification::morphologyType)
+    .value("electrophysiology_type",
+           Circuit::Stratification::electrophysiologyType);
+
 const auto selfarg = bp::arg("self");
 
 // Do not modify whitespace on DOXY_FN lines
@@ -229,6 +309,22 @@ circuitWrapper
     .def("random_gids", Circuit_getRandomGIDs,
          (selfarg, bp::arg("fraction")),
          DOXY_FN(brain::Circuit::getRandomGIDs(float) const))
+    .def("stratified_random_gids", Circuit_getStratifiedRandomTargetsGIDs,
+         (selfarg, bp::arg("fraction"), bp::arg("targets")),
+         DOXY_FN(brain::Circuit::getStratifiedRandomGIDs(float, const Strings&) const))
+    .def("stratified_random_gids", Circuit_getStratifiedRandomGIDs,
+         (selfarg, bp::arg("fraction"), bp::arg("stratification"),
+          bp::arg("target") = std::string()),
+         DOXY_FN(brain::Circuit::getStratifiedRandomGIDs(float, Stratification, const std::string&) const))
+    .def("gids_in_box", Circuit_getGIDsInBox,
+         (selfarg, bp::arg("min"), bp::arg("max")),
+         DOXY_FN(brain::Circuit::getGIDsInBox))
+    .def("gids_in_sphere", Circuit_getGIDsInSphere,
+         (selfarg, bp::arg("center"), bp::arg("radius")),
+         DOXY_FN(brain::Circuit::getGIDsInSphere))
+    .def("nearest_gids", Circuit_getNearestGIDs,
+         (selfarg, bp::arg("point"), bp::arg("count")),
+         DOXY_FN(brain::Circuit::getNearestGIDs))
     .def("morphology_uris", Circuit_getMorphologyURIs,
          (selfarg, bp::arg("gids")),
          DOXY_FN(brain::Circuit::getMorphologyURIs))
@@ -250,10 +346,17 @@ circuitWrapper
          DOXY_FN(brain::Circuit::getElectrophysiologyTypeNames))
     .def("transforms", Circuit_getTransforms, (selfarg, bp::arg("gids")),
          DOXY_FN(brain::Circuit::getTransforms))
+    .def("affine_transforms", Circuit_getAffineTransforms,
+         (selfarg, bp::arg("gids")), DOXY_FN(brain::Circuit::getAffineTransforms))
     .def("rotations", Circuit_getRotations, (selfarg, bp::arg("gids")),
          DOXY_FN(brain::Circuit::getRotations))
+    .def("enable_attribute_cache", &Circuit::enableAttributeCache,
+         (selfarg, bp::arg("preload") = false),
+         DOXY_FN(brain::Circuit::enableAttributeCache))
     .def("num_neurons", &Circuit::getNumNeurons, (selfarg),
          DOXY_FN(brain::Circuit::getNumNeurons))
+    .def("stats", Circuit_getStats, (selfarg),
+         DOXY_FN(brain::Circuit::getStats))
     .def("afferent_synapses", Circuit_getAfferentSynapses,
          (selfarg, bp::arg("gids"),
           bp::arg("prefetch") = SynapsePrefetch::none),
@@ -26,6 +26,7 @@ namespace brain
 namespace neuron
 {
 void export_Morphology();
+void export_Morphometrics();
 
 // clang-format off
 void export_module()
@@ -40,6 +41,7 @@ void export_module()
         .value( "undefined", neuron::SectionType::undefined );
 
     export_Morphology();
+    export_Morphometrics();
 }
 // clang-format on
 }
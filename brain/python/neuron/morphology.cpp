@@ -211,10 +211,14 @@ bp::class_<SectionWrapper>(
          DOXY_FN(brain::neuron::Section::getDistanceToSoma))
     .def("sample_distances_to_soma", Section_getSampleDistancesToSoma, (selfarg),
          DOXY_FN(brain::neuron::Section::getSampleDistancesToSoma))
+    .def("branch_order", &Section::getBranchOrder, (selfarg),
+         DOXY_FN(brain::neuron::Section::getBranchOrder))
     .def("parent", Section_getParent, (selfarg),
          DOXY_FN(brain::neuron::Section::getParent))
     .def("children", Section_getChildren, (selfarg),
-         DOXY_FN(brain::neuron::Section::getChildren));
+         DOXY_FN(brain::neuron::Section::getChildren))
+    .def("num_children", &Section::getNumChildren, (selfarg),
+         DOXY_FN(brain::neuron::Section::getNumChildren));
 
 bp::class_<Morphology, boost::noncopyable, MorphologyPtr>(
     "Morphology", DOXY_CLASS(brain::neuron::Morphology), bp::no_init)
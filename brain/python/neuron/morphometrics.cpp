@@ -0,0 +1,92 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <boost/python.hpp>
+
+#include "../arrayHelpers.h"
+#include "../helpers.h"
+#include "docstrings.h"
+
+#include <brain/neuron/morphology.h>
+#include <brain/neuron/morphometrics.h>
+
+namespace bp = boost::python;
+
+namespace brain
+{
+namespace neuron
+{
+namespace
+{
+Morphologies _morphologiesFromPython(bp::object morphologies)
+{
+    return vectorFromIterable<MorphologyPtr>(
+        morphologies, "Cannot convert argument to a list of morphologies");
+}
+
+bp::list _computeMorphometrics(bp::object morphologies, bp::object metrics)
+{
+    auto columns = computeMorphometrics(
+        _morphologiesFromPython(morphologies),
+        vectorFromIterable<Morphometric>(
+            metrics, "Cannot convert argument to a list of morphometrics"));
+
+    bp::list result;
+    for (auto& column : columns)
+        result.append(toNumpy(std::move(column)));
+    return result;
+}
+
+bp::object _computeShollProfiles(bp::object morphologies,
+                                 const float radiusStep, const size_t numShells)
+{
+    const auto cells = _morphologiesFromPython(morphologies);
+    const bp::object profiles =
+        toNumpy(computeShollProfiles(cells, radiusStep, numShells));
+    return profiles.attr("reshape")(bp::make_tuple(cells.size(), numShells));
+}
+}
+
+// clang-format off
+void export_Morphometrics()
+{
+bp::enum_<Morphometric>("Morphometric")
+    .value("total_length", Morphometric::totalLength)
+    .value("surface_area", Morphometric::surfaceArea)
+    .value("volume", Morphometric::volume)
+    .value("section_count", Morphometric::sectionCount)
+    .value("bifurcation_count", Morphometric::bifurcationCount)
+    .value("terminal_count", Morphometric::terminalCount)
+    .value("max_branch_order", Morphometric::maxBranchOrder)
+    .value("soma_radius", Morphometric::somaRadius);
+
+bp::def("compute_morphometrics", _computeMorphometrics,
+        (bp::arg("morphologies"), bp::arg("metrics")),
+        "Return a list with one numpy array per metric, with the value of the "
+        "metric for each morphology.");
+bp::def("compute_sholl_profiles", _computeShollProfiles,
+        (bp::arg("morphologies"), bp::arg("radius_step"),
+         bp::arg("num_shells")),
+        "Return a numpy array of shape (morphologies, num_shells) with the "
+        "number of segments crossing spheres of radius "
+        "radius_step * (i + 1) around the soma centroid.");
+}
+// clang-format on
+}
+}
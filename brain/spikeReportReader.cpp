@@ -33,7 +33,8 @@ public:
     {
     }
 
-    _Impl(const brion::URI& uri, const GIDSet& subset)
+    template <typename GIDs>
+    _Impl(const brion::URI& uri, const GIDs& subset)
         : _report(uri, subset)
     {
     }
@@ -53,6 +54,12 @@ SpikeReportReader::SpikeReportReader(const brion::URI& uri,
 {
 }
 
+SpikeReportReader::SpikeReportReader(const brion::URI& uri,
+                                     const CompactGIDSet& subset)
+    : _impl(new _Impl(uri, subset))
+{
+}
+
 SpikeReportReader::~SpikeReportReader()
 {
     delete _impl;
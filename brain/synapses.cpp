@@ -509,10 +509,12 @@ Synapses::~Synapses()
 
 Synapses::Synapses(const SynapsesStream& stream)
     : _impl(stream._impl->_externalSource.empty()
-                ? new Impl(stream._impl->_circuit, stream._impl->_gids,
+                ? new Impl(stream._impl->_circuit,
+                           stream._impl->_gids.toGIDSet(),
                            stream._impl->_filterGIDs, stream._impl->_afferent,
                            stream._impl->_prefetch)
-                : new Impl(stream._impl->_circuit, stream._impl->_gids,
+                : new Impl(stream._impl->_circuit,
+                           stream._impl->_gids.toGIDSet(),
                            stream._impl->_externalSource,
                            stream._impl->_prefetch))
 {
@@ -46,6 +46,29 @@ SynapsesStream::SynapsesStream(const Circuit& circuit, const GIDSet& gids,
 {
 }
 
+SynapsesStream::SynapsesStream(const Circuit& circuit,
+                               const CompactGIDSet& gids, const bool afferent,
+                               const SynapsePrefetch prefetch)
+    : _impl(new detail::SynapsesStream(circuit, gids, afferent, prefetch))
+{
+}
+
+SynapsesStream::SynapsesStream(const Circuit& circuit,
+                               const CompactGIDSet& preGIDs,
+                               const CompactGIDSet& postGIDs,
+                               const SynapsePrefetch prefetch)
+    : _impl(new detail::SynapsesStream(circuit, preGIDs, postGIDs, prefetch))
+{
+}
+
+SynapsesStream::SynapsesStream(const Circuit& circuit,
+                               const CompactGIDSet& gids,
+                               const std::string& source,
+                               const SynapsePrefetch prefetch)
+    : _impl(new detail::SynapsesStream(circuit, gids, source, prefetch))
+{
+}
+
 SynapsesStream::~SynapsesStream()
 {
 }
@@ -77,6 +77,12 @@ private:
     // Constructor for afferent external projections
     SynapsesStream(const Circuit& circuit, const GIDSet& gids,
                    const std::string& source, SynapsePrefetch prefetch);
+    SynapsesStream(const Circuit& circuit, const CompactGIDSet& gids,
+                   bool afferent, SynapsePrefetch prefetch);
+    SynapsesStream(const Circuit& circuit, const CompactGIDSet& preGIDs,
+                   const CompactGIDSet& postGIDs, SynapsePrefetch prefetch);
+    SynapsesStream(const Circuit& circuit, const CompactGIDSet& gids,
+                   const std::string& source, SynapsePrefetch prefetch);
 
     friend class Synapses;
     std::unique_ptr<detail::SynapsesStream> _impl;
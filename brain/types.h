@@ -52,13 +52,16 @@ class Synapses;
 class SynapsesIterator;
 class SynapsesStream;
 
+using vmml::AABBf;
 using vmml::Matrix4f;
 using vmml::Quaternionf;
 using vmml::Vector2i;
 using vmml::Vector3f;
 using vmml::Vector4f;
 
+using brion::CompactGIDSet;
 using brion::GIDSet;
+using brion::MorphologyLOD;
 using brion::Strings;
 using brion::URI;
 using brion::URIs;
@@ -76,6 +79,8 @@ using brion::CompartmentCounts;
 
 typedef std::vector<CompartmentReportFrame> CompartmentReportFrames;
 typedef std::vector<Matrix4f> Matrix4fs;
+typedef vmml::Matrix<3, 4, float> Matrix3x4f; //!< affine transformation
+typedef std::vector<Matrix3x4f> Matrix3x4fs;
 typedef std::vector<Quaternionf> Quaternionfs;
 
 typedef std::shared_ptr<SpikeReportReader> SpikeReportReaderPtr;
@@ -25,9 +25,11 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
-#include <boost/regex.hpp>
+#include <ctime>
 #include <fstream>
 #include <lunchbox/log.h>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace fs = boost::filesystem;
@@ -80,86 +82,247 @@ namespace brion
 typedef std::unordered_map<std::string, std::string> KVStore;
 typedef std::unordered_map<std::string, KVStore> ValueTable;
 
-namespace detail
+namespace
 {
-class BlueConfig
+/** The parsed content of one BlueConfig file. */
+struct Sections
 {
-public:
-    explicit BlueConfig(const std::string& source)
+    Strings names[CONFIGSECTION_ALL];
+    ValueTable table[CONFIGSECTION_ALL];
+};
+typedef std::shared_ptr<const Sections> SectionsPtr;
+
+bool isSpace(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+           c == '\v';
+}
+
+bool isNameChar(const char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+std::string readFile(const std::string& source)
+{
+    std::ifstream file(source.c_str(), std::ios::binary);
+    if (!file.is_open())
+        LBTHROW(std::runtime_error("Cannot open BlueConfig file " + source));
+
+    std::string content;
+    file.seekg(0, std::ios::end);
+    const std::streamoff size = file.tellg();
+    if (size > 0)
     {
-        std::ifstream file(source.c_str());
-        if (!file.is_open())
-            LBTHROW(
-                std::runtime_error("Cannot open BlueConfig file " + source));
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-
-        boost::regex commentregx("#.*?\\n");
-        const std::string fileString =
-            boost::regex_replace(buffer.str(), commentregx, "\n");
-
-        boost::regex regx(
-            "(?<type>[a-zA-Z0-9_-]+) (?<name>[a-zA-Z0-9_-]+?)"
-            "\\s+\\{(?<contents>.*?)\\}");
-        const int subs[] = {1, 2, 3};
-        boost::sregex_token_iterator i(fileString.begin(), fileString.end(),
-                                       regx, subs);
-        for (boost::sregex_token_iterator end; i != end;)
+        content.resize(size_t(size));
+        file.seekg(0, std::ios::beg);
+        file.read(&content[0], size);
+        content.resize(size_t(file.gcount()));
+    }
+    return content;
+}
+
+/** @return the range without leading and trailing whitespace. */
+std::string trim(const char* begin, const char* end)
+{
+    while (begin != end && isSpace(*begin))
+        ++begin;
+    while (end != begin && isSpace(*(end - 1)))
+        --end;
+    return std::string(begin, end);
+}
+
+void parseContent(const std::string& content, const std::string& source,
+                  KVStore& store)
+{
+    size_t lineStart = 0;
+    while (lineStart < content.size())
+    {
+        size_t lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = content.size();
+
+        const std::string line =
+            trim(content.data() + lineStart, content.data() + lineEnd);
+        lineStart = lineEnd + 1;
+        if (line.empty())
+            continue;
+
+        const std::string::size_type pos = line.find(' ');
+        if (pos == std::string::npos)
         {
-            const std::string& typeStr = *i++;
-            const std::string& name = *i++;
-            const std::string& content = *i++;
-            if (content.empty())
-            {
-                LBWARN << "Found empty section '" << typeStr << " " << name
-                       << "' in BlueConfig file " << source << std::endl;
-                continue;
-            }
+            LBWARN << "Found invalid key-value pair '" << line
+                   << "' in BlueConfig file " << source << std::endl;
+            continue;
+        }
+
+        store.insert(std::make_pair(line.substr(0, pos),
+                                    trim(line.data() + pos + 1,
+                                         line.data() + line.size())));
+    }
+}
 
-            const BlueConfigSection type =
-                boost::lexical_cast<BlueConfigSection>(typeStr);
-            if (type == brion::CONFIGSECTION_UNKNOWN)
+/**
+ * Parse the sections of a BlueConfig in a single pass.
+ *
+ * A section starts with 'Type Name {', where type and name are separated by a
+ * single space, and ends at the next '}'. Comments run from '#' to the end of
+ * the line.
+ */
+SectionsPtr parse(const std::string& source)
+{
+    const std::string file = readFile(source);
+    std::shared_ptr<Sections> sections(new Sections);
+
+    // The last two names, whether they form a 'Type Name' header and whether
+    // whitespace followed it
+    const size_t none = std::string::npos;
+    size_t typeBegin = none, typeEnd = none, nameBegin = none, nameEnd = none;
+    bool header = false;
+    bool spaced = false;
+
+    size_t i = 0;
+    while (i < file.size())
+    {
+        const char c = file[i];
+        if (c == '#') // comments act as a line break
+        {
+            i = file.find('\n', i);
+            if (i == none)
+                break;
+            continue;
+        }
+        if (isSpace(c))
+        {
+            spaced = true;
+            ++i;
+            continue;
+        }
+        if (isNameChar(c))
+        {
+            const size_t begin = i;
+            while (i < file.size() && isNameChar(file[i]))
+                ++i;
+            header = nameBegin != none && nameEnd + 1 == begin &&
+                     file[nameEnd] == ' ';
+            spaced = false;
+            typeBegin = nameBegin;
+            typeEnd = nameEnd;
+            nameBegin = begin;
+            nameEnd = i;
+            continue;
+        }
+        if (c != '{' || !header || !spaced)
+        {
+            header = false;
+            nameBegin = none;
+            ++i;
+            continue;
+        }
+
+        // collect the section content up to the closing brace
+        std::string content;
+        size_t j = i + 1;
+        while (j < file.size() && file[j] != '}')
+        {
+            if (file[j] == '#')
             {
-                LBDEBUG << "Found unknown section '" << typeStr
-                        << "' in BlueConfig file " << source << std::endl;
+                j = file.find('\n', j);
+                if (j == none)
+                    j = file.size();
                 continue;
             }
+            content.push_back(file[j++]);
+        }
+        if (j == file.size())
+            break;
+        const std::string typeStr(file, typeBegin, typeEnd - typeBegin);
+        const std::string name(file, nameBegin, nameEnd - nameBegin);
+        i = j + 1;
+        header = false;
+        nameBegin = none;
+        if (content.empty())
+        {
+            LBWARN << "Found empty section '" << typeStr << " " << name
+                   << "' in BlueConfig file " << source << std::endl;
+            continue;
+        }
 
-            names[type].push_back(name);
+        const BlueConfigSection type =
+            boost::lexical_cast<BlueConfigSection>(typeStr);
+        if (type == brion::CONFIGSECTION_UNKNOWN)
+        {
+            LBDEBUG << "Found unknown section '" << typeStr
+                    << "' in BlueConfig file " << source << std::endl;
+            continue;
+        }
 
-            Strings lines;
-            boost::split(lines, content, boost::is_any_of("\n"),
-                         boost::token_compress_on);
+        sections->names[type].push_back(name);
+        KVStore store;
+        parseContent(content, source, store);
+        if (!store.empty())
+            sections->table[type][name].insert(store.begin(), store.end());
+    }
 
-            for (std::string line : lines)
-            {
-                boost::trim(line);
-                if (line.empty())
-                    continue;
-
-                const std::string::size_type pos = line.find(' ', 0);
-                if (pos == std::string::npos)
-                {
-                    LBWARN << "Found invalid key-value pair '" << line
-                           << "' in BlueConfig file " << source << std::endl;
-                    continue;
-                }
-
-                std::string value = line.substr(pos + 1);
-                boost::trim(value);
-                table[type][name].insert(
-                    std::make_pair(line.substr(0, pos), value));
-            }
+    if (sections->table[CONFIGSECTION_RUN].empty())
+        LBTHROW(std::runtime_error(source + " not a valid BlueConfig file"));
+    return sections;
+}
+
+/**
+ * @return the parsed file, shared with all other BlueConfig instances of this
+ *         process opened on the same, unmodified file.
+ */
+SectionsPtr load(const std::string& source)
+{
+    struct Entry
+    {
+        std::time_t mtime;
+        uintmax_t size;
+        SectionsPtr sections;
+    };
+    static std::mutex mutex;
+    static std::unordered_map<std::string, Entry> cache;
+
+    boost::system::error_code error;
+    const std::string path = fs::absolute(source).string();
+    const std::time_t mtime = fs::last_write_time(path, error);
+    // mtime has second resolution, the size catches most quick rewrites
+    const uintmax_t size = error ? 0 : fs::file_size(path, error);
+    if (error)
+        return parse(source); // throws the appropriate error
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto i = cache.find(path);
+        if (i != cache.end() && i->second.mtime == mtime &&
+            i->second.size == size)
+        {
+            return i->second.sections;
         }
+    }
+
+    const SectionsPtr sections = parse(source);
+    std::lock_guard<std::mutex> lock(mutex);
+    cache[path] = Entry{mtime, size, sections};
+    return sections;
+}
+}
 
-        if (table[CONFIGSECTION_RUN].empty())
-            LBTHROW(
-                std::runtime_error(source + " not a valid BlueConfig file"));
+namespace detail
+{
+class BlueConfig
+{
+public:
+    explicit BlueConfig(const std::string& source)
+        : sections(load(source))
+    {
     }
 
     std::string getRun()
     {
-        const brion::Strings& runs = names[brion::CONFIGSECTION_RUN];
+        const brion::Strings& runs = sections->names[brion::CONFIGSECTION_RUN];
         return runs.empty() ? std::string() : runs.front();
     }
 
@@ -171,8 +334,8 @@ public:
         // don't exist.
         static std::string empty;
         const ValueTable::const_iterator tableIt =
-            table[section].find(sectionName);
-        if (tableIt == table[section].end())
+            sections->table[section].find(sectionName);
+        if (tableIt == sections->table[section].end())
             return empty;
         const KVStore& store = tableIt->second;
         const KVStore::const_iterator kv = store.find(key);
@@ -208,8 +371,7 @@ public:
         return true;
     }
 
-    Strings names[CONFIGSECTION_ALL];
-    ValueTable table[CONFIGSECTION_ALL];
+    const SectionsPtr sections;
 };
 }
 
@@ -226,7 +388,7 @@ BlueConfig::~BlueConfig()
 const Strings& BlueConfig::getSectionNames(
     const BlueConfigSection section) const
 {
-    return _impl->names[section];
+    return _impl->sections->names[section];
 }
 
 const std::string& BlueConfig::get(const BlueConfigSection section,
@@ -387,7 +549,8 @@ std::ostream& operator<<(std::ostream& os, const BlueConfig& config)
 {
     for (size_t i = 0; i < CONFIGSECTION_ALL; ++i)
     {
-        for (const ValueTable::value_type& entry : config._impl->table[i])
+        const ValueTable& table = config._impl->sections->table[i];
+        for (const ValueTable::value_type& entry : table)
         {
             os << boost::lexical_cast<std::string>(BlueConfigSection(i)) << " "
                << entry.first << std::endl;
@@ -47,6 +47,9 @@ public:
     /** @name Read API */
     //@{
     /** Open given filepath to a BlueConfig or CircuitConfig for reading.
+     *
+     * The parsed content is shared by all instances of the process opened on
+     * the same file, until the file is modified.
      *
      * @param source filepath to BlueConfig or CircuitConfig file
      * @throw std::runtime_error if source is not a valid BlueConfig or
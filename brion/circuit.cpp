@@ -23,8 +23,14 @@
 #include <bitset>
 #include <boost/filesystem.hpp>
 #include <boost/tokenizer.hpp>
-#include <fstream>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <lunchbox/log.h>
+#include <lunchbox/memoryMap.h>
+#include <mutex>
+#include <sstream>
+#include <type_traits>
 #include <unordered_map>
 
 namespace brion
@@ -42,6 +48,62 @@ enum Section
     SECTION_UNKNOWN
 };
 
+namespace
+{
+/** A line or field of the memory-mapped circuit file. */
+struct Token
+{
+    const char* data;
+    size_t size;
+};
+typedef std::vector<Token> Tokens;
+
+/** Split a neuron line into at most NEURON_ALL space-separated fields. */
+size_t split(const Token& line, Token* fields)
+{
+    const char* ptr = line.data;
+    const char* const end = line.data + line.size;
+    size_t count = 0;
+    while (count < NEURON_ALL)
+    {
+        while (ptr < end && *ptr == ' ')
+            ++ptr;
+        if (ptr == end)
+            break;
+        const char* const start = ptr;
+        while (ptr < end && *ptr != ' ')
+            ++ptr;
+        fields[count++] = {start, size_t(ptr - start)};
+    }
+    return count;
+}
+
+template <typename T>
+bool parse(const Token& token, T& value)
+{
+    char buffer[64]; // null-terminated copy, the mapping is not
+    if (token.size == 0 || token.size >= sizeof(buffer))
+        return false;
+    ::memcpy(buffer, token.data, token.size);
+    buffer[token.size] = 0;
+
+    char* end = nullptr;
+    value = std::is_floating_point<T>::value ? T(std::strtof(buffer, &end))
+                                             : T(std::strtoul(buffer, &end,
+                                                              10));
+    return end == buffer + token.size;
+}
+
+/** Field index of a single NeuronAttributes bit. */
+size_t getField(const NeuronAttributes attribute)
+{
+    size_t field = 0;
+    while ((1u << field) != uint32_t(attribute))
+        ++field;
+    return field;
+}
+}
+
 class Circuit::Impl
 {
 public:
@@ -69,24 +131,47 @@ public:
         sections.insert(
             std::make_pair("MiniColumnsPosition", SECTION_MCPOSITIONS));
         sections.insert(std::make_pair("CircuitSeeds", SECTION_CIRCUITSEEDS));
+        size_t maxSectionLength = 0;
+        for (const auto& section : sections)
+            maxSectionLength = std::max(maxSectionLength, section.first.size());
 
-        _file.open(source.c_str());
-        if (!_file.is_open())
+        // The neuron lines are kept in the mapping, only the small sections
+        // are copied into strings.
+        const char* ptr = static_cast<const char*>(_map.map(source));
+        if (!ptr && !(fs::exists(path) && fs::is_empty(path)))
             LBTHROW(std::runtime_error("Could not open MVD2 file " + source));
+        const char* const end = ptr + _map.getSize();
 
-        _file >> std::ws;
         Section current = SECTION_UNKNOWN;
-        while (!_file.eof())
+        while (ptr < end)
         {
-            std::string content;
-            std::getline(_file, content);
-            _file >> std::ws;
+            // skip white space and empty lines
+            if (std::isspace(static_cast<unsigned char>(*ptr)))
+            {
+                ++ptr;
+                continue;
+            }
+            const char* eol =
+                static_cast<const char*>(::memchr(ptr, '\n', end - ptr));
+            if (!eol)
+                eol = end;
+            const Token line = {ptr, size_t(eol - ptr)};
+            ptr = eol;
 
-            LookUp::const_iterator it = sections.find(content);
-            if (it != sections.end())
-                current = it->second;
+            if (line.size <= maxSectionLength)
+            {
+                const LookUp::const_iterator it =
+                    sections.find(std::string(line.data, line.size));
+                if (it != sections.end())
+                {
+                    current = it->second;
+                    continue;
+                }
+            }
+            if (current == SECTION_NEURONS)
+                _neurons.push_back(line);
             else
-                _table[current].push_back(content);
+                _table[current].emplace_back(line.data, line.size);
         }
     }
 
@@ -96,72 +181,63 @@ public:
         if (!bits.any())
             return NeuronMatrix();
 
-        const Strings& neurons = _table.find(SECTION_NEURONS)->second;
-
-        std::vector<int32_t> indices;
-        indices.reserve(gids.size());
-        for (const uint32_t gid : gids)
-        {
-            if (gid > neurons.size() || gid == 0)
-            {
-                std::stringstream msg;
-                msg << "Cell GID out of range: " << gid;
-                LBTHROW(std::runtime_error(msg.str().c_str()));
-            }
-            indices.push_back(gid - 1);
-        }
-
+        const std::vector<int32_t> indices = _getIndices(gids);
         const size_t numNeurons =
             indices.empty() ? getNumNeurons() : indices.size();
         NeuronMatrix values(boost::extents[numNeurons][bits.count()]);
-        std::vector<char> buffer;
 
-        // This loop uses a hand-written string tokenizer to improve the
-        // performance of loading very large circuits (millions of neurons).
-        // This code is faster than using boost tokenizer because it does not
-        // use std::string and does only very few memory allocations.
-        for (size_t i = 0; i < numNeurons; ++i)
+        // Tokenize in place and only allocate the strings of the requested
+        // fields, which keeps loading very large circuits (millions of
+        // neurons) fast.
+#pragma omp parallel for
+        for (int64_t i = 0; i < int64_t(numNeurons); ++i)
         {
             const size_t neuronIdx = indices.empty() ? i : indices[i];
+            Token fields[NEURON_ALL];
+            const size_t count = split(_neurons[neuronIdx], fields);
 
-            const std::string& line = neurons[neuronIdx];
-            buffer.resize(std::max(buffer.size(), line.size() + 1));
-            buffer[0] = 0;
-            size_t bit = 0;
             size_t field = 0;
-            size_t k = 0;
-            for (unsigned int j = 0; j != line.size() + 1; ++j)
+            for (size_t bit = 0; bit < count; ++bit)
             {
-                char c = line[j];
-                if (c == ' ' || c == 0)
-                {
-                    // A new input field is stored in buffer (except for the
-                    // null terminating character.
-                    if (bits.test(bit))
-                    {
-                        buffer[k] = 0;
-                        values[i][field++] = buffer.data();
-                    }
-                    ++bit;
-                    k = 0;
-                    buffer[0] = 0;
-
-                    // Skipping white space and stopping j at the position
-                    // of the next character.
-                    while (c == ' ')
-                        c = line[++j];
-                }
-                buffer[k++] = c;
+                if (bits.test(bit))
+                    values[i][field++].assign(fields[bit].data,
+                                              fields[bit].size);
             }
         }
         return values;
     }
 
-    size_t getNumNeurons() const
+    Vector3fs getPositions(const GIDSet& gids) const
+    {
+        _parseColumns();
+        return _gather(_positions, gids);
+    }
+
+    floats getRotations(const GIDSet& gids) const
+    {
+        _parseColumns();
+        return _gather(_rotations, gids);
+    }
+
+    size_ts getMTypes(const GIDSet& gids) const
+    {
+        _parseColumns();
+        return _gather(_mtypes, gids);
+    }
+
+    size_ts getETypes(const GIDSet& gids) const
     {
-        return _table.find(SECTION_NEURONS)->second.size();
+        _parseColumns();
+        return _gather(_etypes, gids);
     }
 
+    Strings getMorphologyNames(const GIDSet& gids) const
+    {
+        _parseColumns();
+        return _gather(_morphologyNames, gids);
+    }
+
+    size_t getNumNeurons() const { return _neurons.size(); }
     Strings getTypes(const NeuronClass type) const
     {
         switch (type)
@@ -200,10 +276,93 @@ public:
     }
 
 private:
-    std::ifstream _file;
+    lunchbox::MemoryMap _map;
+    Tokens _neurons;
 
     typedef std::unordered_map<uint32_t, Strings> CircuitTable;
     CircuitTable _table;
+
+    // typed neuron columns, parsed in parallel on first typed access
+    mutable std::once_flag _parsed;
+    mutable Vector3fs _positions;
+    mutable floats _rotations;
+    mutable size_ts _mtypes;
+    mutable size_ts _etypes;
+    mutable Strings _morphologyNames;
+
+    std::vector<int32_t> _getIndices(const GIDSet& gids) const
+    {
+        std::vector<int32_t> indices;
+        indices.reserve(gids.size());
+        for (const uint32_t gid : gids)
+        {
+            if (gid > _neurons.size() || gid == 0)
+            {
+                std::stringstream msg;
+                msg << "Cell GID out of range: " << gid;
+                LBTHROW(std::runtime_error(msg.str().c_str()));
+            }
+            indices.push_back(gid - 1);
+        }
+        return indices;
+    }
+
+    template <typename T>
+    std::vector<T> _gather(const std::vector<T>& column,
+                           const GIDSet& gids) const
+    {
+        const std::vector<int32_t> indices = _getIndices(gids);
+        if (indices.empty())
+            return column;
+
+        std::vector<T> values(indices.size());
+#pragma omp parallel for
+        for (int64_t i = 0; i < int64_t(indices.size()); ++i)
+            values[i] = column[indices[i]];
+        return values;
+    }
+
+    void _parseColumns() const
+    {
+        std::call_once(_parsed, [this] {
+            const size_t numNeurons = _neurons.size();
+            _positions.resize(numNeurons);
+            _rotations.resize(numNeurons);
+            _mtypes.resize(numNeurons);
+            _etypes.resize(numNeurons);
+            _morphologyNames.resize(numNeurons);
+
+            const size_t name = getField(NEURON_MORPHOLOGY_NAME);
+            const size_t mtype = getField(NEURON_MTYPE);
+            const size_t etype = getField(NEURON_ETYPE);
+            const size_t x = getField(NEURON_POSITION_X);
+            const size_t y = getField(NEURON_POSITION_Y);
+            const size_t z = getField(NEURON_POSITION_Z);
+            const size_t rotation = getField(NEURON_ROTATION);
+
+#pragma omp parallel for
+            for (int64_t i = 0; i < int64_t(numNeurons); ++i)
+            {
+                Token fields[NEURON_ALL];
+                const size_t count = split(_neurons[i], fields);
+                if (count > name)
+                    _morphologyNames[i].assign(fields[name].data,
+                                               fields[name].size);
+
+                Vector3f& position = _positions[i];
+                if (count <= rotation || !parse(fields[mtype], _mtypes[i]) ||
+                    !parse(fields[etype], _etypes[i]) ||
+                    !parse(fields[x], position[0]) ||
+                    !parse(fields[y], position[1]) ||
+                    !parse(fields[z], position[2]) ||
+                    !parse(fields[rotation], _rotations[i]))
+                {
+                    LBWARN << "Error parsing circuit attributes for gid "
+                           << i + 1 << std::endl;
+                }
+            }
+        });
+    }
 };
 
 Circuit::Circuit(const std::string& source)
@@ -226,6 +385,31 @@ NeuronMatrix Circuit::get(const GIDSet& gids, const uint32_t attributes) const
     return _impl->get(gids, attributes);
 }
 
+Vector3fs Circuit::getPositions(const GIDSet& gids) const
+{
+    return _impl->getPositions(gids);
+}
+
+floats Circuit::getRotations(const GIDSet& gids) const
+{
+    return _impl->getRotations(gids);
+}
+
+size_ts Circuit::getMTypes(const GIDSet& gids) const
+{
+    return _impl->getMTypes(gids);
+}
+
+size_ts Circuit::getETypes(const GIDSet& gids) const
+{
+    return _impl->getETypes(gids);
+}
+
+Strings Circuit::getMorphologyNames(const GIDSet& gids) const
+{
+    return _impl->getMorphologyNames(gids);
+}
+
 size_t Circuit::getNumNeurons() const
 {
     return _impl->getNumNeurons();
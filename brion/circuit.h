@@ -68,6 +68,34 @@ public:
     BRION_API NeuronMatrix get(const GIDSet& gids,
                                const uint32_t attributes) const;
 
+    /** Retrieve the soma positions of a set of neurons.
+     *
+     * The neuron attributes are parsed in parallel into typed columns on the
+     * first call of any typed getter, later calls only gather the requested
+     * neurons.
+     *
+     * @param gids set of neurons of interest; if empty, all neurons in the
+     *             circuit file are considered
+     * @return the positions in the iteration order of the gids
+     * @throw std::runtime_error if any GID is out of range.
+     * @version 3.0
+     */
+    BRION_API Vector3fs getPositions(const GIDSet& gids) const;
+
+    /** @return the rotation angles around the Y axis in degrees.
+     *  @sa getPositions() @version 3.0 */
+    BRION_API floats getRotations(const GIDSet& gids) const;
+
+    /** @return the morphology type indices. @sa getPositions() @version 3.0 */
+    BRION_API size_ts getMTypes(const GIDSet& gids) const;
+
+    /** @return the electrophysiology type indices.
+     *  @sa getPositions() @version 3.0 */
+    BRION_API size_ts getETypes(const GIDSet& gids) const;
+
+    /** @return the morphology names. @sa getPositions() @version 3.0 */
+    BRION_API Strings getMorphologyNames(const GIDSet& gids) const;
+
     /** @return number of neurons stored in the circuit file. @version 1.0 */
     BRION_API size_t getNumNeurons() const;
 
@@ -0,0 +1,121 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compactGIDSet.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace brion
+{
+namespace
+{
+/** Size ratio above which intersections gallop through the larger set. */
+const size_t GALLOP_RATIO = 32;
+
+typedef uint32_ts::const_iterator Iter;
+
+/** @return the first element not less than gid in [begin, end), probing
+ *          exponentially growing steps first to stay local. */
+Iter gallop(Iter begin, const Iter end, const uint32_t gid)
+{
+    size_t step = 1;
+    while (step < size_t(end - begin) && begin[step] < gid)
+    {
+        begin += step;
+        step *= 2;
+    }
+    return std::lower_bound(begin, begin + std::min(step + 1,
+                                                    size_t(end - begin)),
+                            gid);
+}
+}
+
+CompactGIDSet::CompactGIDSet(const GIDSet& gids)
+    : _gids(gids.begin(), gids.end())
+{
+}
+
+CompactGIDSet::CompactGIDSet(uint32_ts gids)
+    : _gids(std::move(gids))
+{
+    if (std::adjacent_find(_gids.begin(), _gids.end(),
+                           std::greater_equal<uint32_t>()) == _gids.end())
+    {
+        return;
+    }
+    std::sort(_gids.begin(), _gids.end());
+    _gids.erase(std::unique(_gids.begin(), _gids.end()), _gids.end());
+}
+
+bool CompactGIDSet::contains(const uint32_t gid) const
+{
+    return std::binary_search(_gids.begin(), _gids.end(), gid);
+}
+
+GIDSet CompactGIDSet::toGIDSet() const
+{
+    // std::set construction from a sorted range is linear
+    return GIDSet(_gids.begin(), _gids.end());
+}
+
+CompactGIDSet CompactGIDSet::intersect(const CompactGIDSet& other) const
+{
+    const uint32_ts& small = size() < other.size() ? _gids : other._gids;
+    const uint32_ts& large = size() < other.size() ? other._gids : _gids;
+
+    uint32_ts result;
+    result.reserve(small.size());
+    if (small.size() * GALLOP_RATIO < large.size())
+    {
+        Iter i = large.begin();
+        for (const uint32_t gid : small)
+        {
+            i = gallop(i, large.end(), gid);
+            if (i == large.end())
+                break;
+            if (*i == gid)
+                result.push_back(gid);
+        }
+    }
+    else
+        std::set_intersection(small.begin(), small.end(), large.begin(),
+                              large.end(), std::back_inserter(result));
+    return CompactGIDSet(std::move(result), Sorted());
+}
+
+CompactGIDSet CompactGIDSet::unite(const CompactGIDSet& other) const
+{
+    uint32_ts result;
+    result.reserve(size() + other.size());
+    std::set_union(_gids.begin(), _gids.end(), other._gids.begin(),
+                   other._gids.end(), std::back_inserter(result));
+    return CompactGIDSet(std::move(result), Sorted());
+}
+
+CompactGIDSet CompactGIDSet::subtract(const CompactGIDSet& other) const
+{
+    uint32_ts result;
+    result.reserve(size());
+    std::set_difference(_gids.begin(), _gids.end(), other._gids.begin(),
+                        other._gids.end(), std::back_inserter(result));
+    return CompactGIDSet(std::move(result), Sorted());
+}
+}
@@ -0,0 +1,100 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brion/api.h>
+#include <brion/types.h>
+
+namespace brion
+{
+/**
+ * Ordered set of GIDs stored as a sorted array.
+ *
+ * Unlike GIDSet, which allocates one tree node per GID, the GIDs are stored
+ * contiguously. Iteration, indexing and the set operations are linear in the
+ * size of the sets or better, and membership tests are binary searches.
+ * Functions taking a CompactGIDSet return their results in the same order as
+ * their GIDSet counterparts. Use toGIDSet() where a GIDSet is still needed.
+ *
+ * @version 3.0
+ */
+class CompactGIDSet
+{
+public:
+    typedef uint32_ts::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    typedef uint32_t value_type;
+
+    CompactGIDSet() {}
+
+    /** Create a compact copy of the given set. */
+    BRION_API explicit CompactGIDSet(const GIDSet& gids);
+
+    /** Create the set from GIDs in any order, removing duplicates. */
+    BRION_API explicit CompactGIDSet(uint32_ts gids);
+
+    size_t size() const { return _gids.size(); }
+    bool empty() const { return _gids.empty(); }
+    const_iterator begin() const { return _gids.begin(); }
+    const_iterator end() const { return _gids.end(); }
+    const uint32_t* data() const { return _gids.data(); }
+
+    /** @return the i-th smallest GID. */
+    uint32_t operator[](const size_t i) const { return _gids[i]; }
+
+    /** @return the sorted GIDs. */
+    const uint32_ts& getGIDs() const { return _gids; }
+
+    /** @return true if the set contains the given GID. */
+    BRION_API bool contains(uint32_t gid) const;
+
+    /** @return the GIDs as a GIDSet, built in linear time. */
+    BRION_API GIDSet toGIDSet() const;
+
+    /**
+     * @return the GIDs contained in both sets. Sets of very different sizes
+     *         are intersected in sub-linear time of the larger one.
+     */
+    BRION_API CompactGIDSet intersect(const CompactGIDSet& other) const;
+
+    /** @return the GIDs contained in either set. */
+    BRION_API CompactGIDSet unite(const CompactGIDSet& other) const;
+
+    /** @return the GIDs of this set not contained in the other set. */
+    BRION_API CompactGIDSet subtract(const CompactGIDSet& other) const;
+
+    bool operator==(const CompactGIDSet& rhs) const
+    {
+        return _gids == rhs._gids;
+    }
+    bool operator!=(const CompactGIDSet& rhs) const { return !(*this == rhs); }
+
+private:
+    uint32_ts _gids;
+
+    struct Sorted
+    {
+    };
+    CompactGIDSet(uint32_ts&& gids, Sorted)
+        : _gids(std::move(gids))
+    {
+    }
+};
+}
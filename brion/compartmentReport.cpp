@@ -18,6 +18,7 @@
  */
 
 #include "compartmentReport.h"
+#include "compactGIDSet.h"
 #include "compartmentReportPlugin.h"
 
 #include <lunchbox/log.h>
@@ -53,6 +54,12 @@ CompartmentReport::CompartmentReport(const URI& uri, const int mode,
 {
 }
 
+CompartmentReport::CompartmentReport(const URI& uri, const int mode,
+                                     const CompactGIDSet& gids)
+    : CompartmentReport(uri, mode, gids.toGIDSet())
+{
+}
+
 CompartmentReport::~CompartmentReport()
 {
     delete _impl;
@@ -182,6 +189,11 @@ void CompartmentReport::updateMapping(const GIDSet& gids)
     _impl->plugin->updateMapping(gids);
 }
 
+void CompartmentReport::updateMapping(const CompactGIDSet& gids)
+{
+    _impl->plugin->updateMapping(gids.toGIDSet());
+}
+
 void CompartmentReport::writeHeader(const double startTime,
                                     const double endTime, const double timestep,
                                     const std::string& dunit,
@@ -61,6 +61,20 @@ public:
     BRION_API CompartmentReport(const URI& uri, int mode,
                                 const GIDSet& gids = GIDSet());
 
+    /** Open given URI to a compartment report for reading the given GIDs.
+     *
+     * @param uri URI to compartment report. The report type is deduced from
+     *        here.
+     * @param mode the brion::AccessMode bitmask
+     * @param gids the neurons of interest in READ_MODE
+     * @throw std::runtime_error if compartment report could be opened for read
+     *                           or write, cannot be overwritten or it is not
+     *                           valid
+     * @version 3.0
+     */
+    BRION_API CompartmentReport(const URI& uri, int mode,
+                                const CompactGIDSet& gids);
+
     /** @return the descriptions of all loaded report backends. @version 1.0 */
     BRION_API static std::string getDescriptions();
 
@@ -78,6 +92,9 @@ public:
      */
     BRION_API void updateMapping(const GIDSet& gids);
 
+    /** @copydoc updateMapping(const GIDSet&) @version 3.0 */
+    BRION_API void updateMapping(const CompactGIDSet& gids);
+
     /** @return the current considered GIDs. @version 1.0 */
     BRION_API const GIDSet& getGIDs() const;
 
@@ -0,0 +1,87 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace brion
+{
+/**
+ * Read-only view on a contiguous array.
+ *
+ * A span either refers to data owned by someone else, which has to outlive
+ * the span, or shares the ownership of the data through an owner handle, e.g.
+ * to keep a memory-mapped file mapped as long as views into it exist.
+ *
+ * @version 3.0
+ */
+template <typename T>
+class ConstSpan
+{
+public:
+    ConstSpan()
+        : _data(nullptr)
+        , _size(0)
+    {
+    }
+
+    ConstSpan(const T* data, const size_t size)
+        : _data(data)
+        , _size(size)
+    {
+    }
+
+    /** Create a span keeping the given owner of the data alive. */
+    ConstSpan(const T* data, const size_t size,
+              std::shared_ptr<const void> owner)
+        : _data(data)
+        , _size(size)
+        , _owner(std::move(owner))
+    {
+    }
+
+    ConstSpan(const std::vector<T>& vector)
+        : _data(vector.data())
+        , _size(vector.size())
+    {
+    }
+
+    /** Create a span sharing the ownership of the given vector. */
+    ConstSpan(std::shared_ptr<const std::vector<T>> vector)
+        : _data(vector ? vector->data() : nullptr)
+        , _size(vector ? vector->size() : 0)
+        , _owner(std::move(vector))
+    {
+    }
+
+    const T* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const T* begin() const { return _data; }
+    const T* end() const { return _data + _size; }
+    const T& operator[](const size_t i) const { return _data[i]; }
+
+private:
+    const T* _data;
+    size_t _size;
+    std::shared_ptr<const void> _owner;
+};
+}
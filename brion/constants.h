@@ -48,6 +48,12 @@ const char* const BLUECONFIG_PROJECTION_PATH_KEY = "Path";
 const char* const ZEROEQ_SCHEME = "zeroeq";
 const uint128_t ZEROEQ_GET_MORPHOLOGY =
     servus::make_uint128("brion::Morphology::get");
+/**
+ * Request many morphologies at once. The request data are the paths, each
+ * terminated by a null character, the reply is a MorphologyBatchHeader.
+ */
+const uint128_t ZEROEQ_GET_MORPHOLOGIES =
+    servus::make_uint128("brion::Morphologies::get");
 }
 
 #endif
@@ -64,6 +64,45 @@ public:
     virtual Vector3fsPtr readNormals() const = 0;
     //@}
 
+    /** @name Zero-copy read API for membrane/surface mesh */
+    //@{
+    /** Read the surface mesh ahead of access through the views. */
+    virtual void prefetch()
+    {
+        _prefetched.vertices = readVertices();
+        _prefetched.vertexSections = readVertexSections();
+        _prefetched.vertexDistances = readVertexDistances();
+        _prefetched.triangles = readTriangles();
+        _prefetched.triStrip = readTriStrip();
+        _prefetched.normals = readNormals();
+    }
+
+    virtual ConstSpan<Vector3f> getVertices() const
+    {
+        return _view(_prefetched.vertices, &Mesh::readVertices);
+    }
+    virtual ConstSpan<uint16_t> getVertexSections() const
+    {
+        return _view(_prefetched.vertexSections, &Mesh::readVertexSections);
+    }
+    virtual ConstSpan<float> getVertexDistances() const
+    {
+        return _view(_prefetched.vertexDistances, &Mesh::readVertexDistances);
+    }
+    virtual ConstSpan<uint32_t> getTriangles() const
+    {
+        return _view(_prefetched.triangles, &Mesh::readTriangles);
+    }
+    virtual ConstSpan<uint32_t> getTriStrip() const
+    {
+        return _view(_prefetched.triStrip, &Mesh::readTriStrip);
+    }
+    virtual ConstSpan<Vector3f> getNormals() const
+    {
+        return _view(_prefetched.normals, &Mesh::readNormals);
+    }
+    //@}
+
     /** @name Read API for structural mesh */
     //@{
     virtual size_t getNumStructures(const MeshStructure type) const = 0;
@@ -103,6 +142,25 @@ public:
                                         const size_t index) = 0;
     virtual void flush() = 0;
     //@}
+
+private:
+    struct
+    {
+        Vector3fsPtr vertices;
+        uint16_tsPtr vertexSections;
+        floatsPtr vertexDistances;
+        uint32_tsPtr triangles;
+        uint32_tsPtr triStrip;
+        Vector3fsPtr normals;
+    } _prefetched;
+
+    template <typename T>
+    ConstSpan<T> _view(const std::shared_ptr<std::vector<T>>& prefetched,
+                       std::shared_ptr<std::vector<T>> (Mesh::*read)()
+                           const) const
+    {
+        return ConstSpan<T>(prefetched ? prefetched : (this->*read)());
+    }
 };
 }
 }
@@ -22,6 +22,7 @@
 
 #include "mesh.h"
 
+#include <cstring>
 #include <fstream>
 #include <lunchbox/debug.h>
 #include <lunchbox/log.h>
@@ -45,11 +46,13 @@ class MeshBinary : public Mesh
 public:
     explicit MeshBinary(const std::string& source)
         : Mesh(source)
-        , _mmap(source)
-        , _ptr(reinterpret_cast<const uint8_t*>(_mmap.getAddress()))
+        , _mmap(std::make_shared<lunchbox::MemoryMap>(source))
+        , _ptr(reinterpret_cast<const uint8_t*>(_mmap->getAddress()))
     {
         if (!_ptr)
             LBTHROW(std::runtime_error("Could not open mesh file: " + source));
+        if (_mmap->getSize() < 3 * sizeof(uint32_t))
+            LBTHROW(std::runtime_error(source + " not a valid mesh file"));
 
         size_t pos = 0;
         _vertices = get<uint32_t>(_ptr, pos);
@@ -63,7 +66,7 @@ public:
         _tristripSeek = _triangleSeek + _triangles * 3 * sizeof(uint32_t);
 
         // if the version is contained in the current file apply offset
-        if (_mmap.getSize() != _tristripSeek + _tristrip * sizeof(uint32_t))
+        if (_mmap->getSize() != _tristripSeek + _tristrip * sizeof(uint32_t))
         {
             _version = get<MeshVersion>(_ptr, pos);
 
@@ -74,6 +77,9 @@ public:
             _triangleSeek += versionOffset;
             _tristripSeek += versionOffset;
         }
+
+        if (_mmap->getSize() < _tristripSeek + _tristrip * sizeof(uint32_t))
+            LBTHROW(std::runtime_error(source + " is truncated"));
     }
 
     MeshBinary(const std::string& source, const MeshVersion version)
@@ -177,6 +183,43 @@ public:
         return buffer;
     }
 
+    void prefetch() final
+    {
+        // Fault in all pages of the mapping now, so concurrent prefetches of
+        // many meshes overlap their I/O instead of stalling on first access.
+        if (!_ptr)
+            return;
+        const size_t pageSize = 4096;
+        volatile uint8_t sink = 0;
+        for (size_t i = 0; i < _mmap->getSize(); i += pageSize)
+            sink += _ptr[i];
+    }
+
+    ConstSpan<Vector3f> getVertices() const final
+    {
+        return _view<Vector3f>(_vertexSeek, _vertices);
+    }
+    ConstSpan<uint16_t> getVertexSections() const final
+    {
+        return _view<uint16_t>(_vSectionSeek, _vertices);
+    }
+    ConstSpan<float> getVertexDistances() const final
+    {
+        return _view<float>(_vDistanceSeek, _vertices);
+    }
+    ConstSpan<uint32_t> getTriangles() const final
+    {
+        return _view<uint32_t>(_triangleSeek, _triangles * 3);
+    }
+    ConstSpan<uint32_t> getTriStrip() const final
+    {
+        return _view<uint32_t>(_tristripSeek, _tristrip);
+    }
+    ConstSpan<Vector3f> getNormals() const final
+    {
+        return ConstSpan<Vector3f>();
+    }
+
     virtual size_t getNumNormals() const { return 0u; }
     virtual Vector3fsPtr readNormals() const
     {
@@ -328,7 +371,7 @@ public:
 
     virtual void flush() { _file.flush(); }
 private:
-    lunchbox::MemoryMap _mmap;
+    std::shared_ptr<lunchbox::MemoryMap> _mmap; // shared with the views
     const uint8_t* const _ptr;
     std::ofstream _file;
 
@@ -341,6 +384,23 @@ private:
     size_t _vDistanceSeek;
     size_t _triangleSeek;
     size_t _tristripSeek;
+
+    template <typename T>
+    ConstSpan<T> _view(const size_t offset, const size_t size) const
+    {
+        if (!_ptr || size == 0)
+            return ConstSpan<T>();
+
+        const uint8_t* data = _ptr + offset;
+        if (reinterpret_cast<uintptr_t>(data) % alignof(T) == 0)
+            return ConstSpan<T>(reinterpret_cast<const T*>(data), size, _mmap);
+
+        // Arrays following an odd number of 16 bit vertex sections are not
+        // aligned for direct access and need a copy.
+        std::shared_ptr<std::vector<T>> copy(new std::vector<T>(size));
+        ::memcpy(copy->data(), data, size * sizeof(T));
+        return ConstSpan<T>(std::shared_ptr<const std::vector<T>>(copy));
+    }
 };
 }
 }
@@ -0,0 +1,550 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_DETAIL_MESHCOMPRESSED
+#define BRION_DETAIL_MESHCOMPRESSED
+
+#include "mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <lunchbox/log.h>
+#include <lunchbox/memoryMap.h>
+#include <vmmlib/vector.hpp>
+
+namespace brion
+{
+namespace detail
+{
+/**
+ * Header of a MESH_VERSION_3 binary mesh.
+ *
+ * The first four fields overlay the header of uncompressed binary meshes, so
+ * the version identifies the layout. The header is followed by the quantized
+ * positions (3 x uint16 per vertex), the quantized vertex distances (uint16 per
+ * vertex) and the varint streams of the delta-coded vertex sections, triangle
+ * indices and triangle strip.
+ */
+struct MeshCompressedHeader
+{
+    uint32_t vertices;
+    uint32_t triangles;
+    uint32_t tristrip;
+    uint32_t version; //!< MESH_VERSION_3
+    char magic[8];    //!< "BRIONMSH"
+    float positionMin[3];
+    float positionScale[3]; //!< position = min + scale * quantized value
+    float distanceMin;
+    float distanceScale; //!< distance = min + scale * quantized value
+    uint64_t sectionBytes;
+    uint64_t triangleBytes;
+    uint64_t tristripBytes;
+};
+static_assert(sizeof(MeshCompressedHeader) == 80,
+              "MeshCompressedHeader must be 80 bytes");
+
+const char MESH_COMPRESSED_MAGIC[8] = {'B', 'R', 'I', 'O', 'N', 'M', 'S', 'H'};
+
+namespace codec
+{
+inline uint64_t zigzag(const int64_t value)
+{
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+inline int64_t unzigzag(const uint64_t value)
+{
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+/** Append the differences of consecutive values as zigzag varints. */
+template <typename T>
+void encodeDeltas(const T* values, const size_t count,
+                  std::vector<uint8_t>& out)
+{
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t value = zigzag(int64_t(values[i]) - previous);
+        previous = int64_t(values[i]);
+        while (value >= 0x80)
+        {
+            out.push_back(uint8_t(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(uint8_t(value));
+    }
+}
+
+/** Decode count values written by encodeDeltas(). */
+template <typename T>
+void decodeDeltas(const uint8_t* data, const size_t size, T* values,
+                  const size_t count)
+{
+    const uint8_t* const end = data + size;
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0;; shift += 7)
+        {
+            if (data == end || shift > 63)
+                LBTHROW(std::runtime_error("Corrupt compressed mesh data"));
+            const uint8_t byte = *data++;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        previous += unzigzag(value);
+        values[i] = T(previous);
+    }
+}
+
+/** @return the scale to quantize [min, max] to 16 bits. */
+inline float getScale(const float min, const float max)
+{
+    return max > min ? (max - min) / 65535.f : 0.f;
+}
+
+inline uint16_t quantize(const float value, const float min, const float scale)
+{
+    if (scale == 0.f)
+        return 0;
+    const float quantized = std::round((value - min) / scale);
+    return uint16_t(std::min(std::max(quantized, 0.f), 65535.f));
+}
+}
+
+/**
+ * Binary mesh with quantized vertex attributes and delta-coded indices.
+ *
+ * Positions are quantized to 16 bits per axis within the bounding box of the
+ * mesh, so the error per axis is at most half of positionScale. Vertex
+ * distances are quantized likewise, sections and indices are stored losslessly.
+ * Writes are buffered and encoded on flush.
+ */
+class MeshCompressed : public Mesh
+{
+public:
+    /** @return true if the given binary mesh file uses this layout. */
+    static bool isCompressed(const std::string& source)
+    {
+        std::ifstream file(source.c_str(), std::ios::binary);
+        MeshCompressedHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+        return header.version == MESH_VERSION_3 &&
+               ::memcmp(header.magic, MESH_COMPRESSED_MAGIC,
+                        sizeof(header.magic)) == 0;
+    }
+
+    explicit MeshCompressed(const std::string& source)
+        : Mesh(source)
+        , _mmap(new lunchbox::MemoryMap(source))
+        , _ptr(reinterpret_cast<const uint8_t*>(_mmap->getAddress()))
+    {
+        if (!_ptr)
+            LBTHROW(std::runtime_error("Could not open mesh file: " + source));
+        if (_mmap->getSize() < sizeof(_header))
+            LBTHROW(std::runtime_error(source + " not a valid mesh file"));
+
+        ::memcpy(&_header, _ptr, sizeof(_header));
+        _version = MESH_VERSION_3;
+
+        // Each array must fit into the bytes remaining after the previous
+        // one, which also rejects sizes that would wrap the offsets.
+        const uint64_t size = _mmap->getSize();
+        uint64_t offset = sizeof(_header);
+        const auto next = [&](const uint64_t bytes) -> size_t {
+            if (bytes > size - offset)
+                LBTHROW(std::runtime_error(source + " is truncated"));
+            const uint64_t start = offset;
+            offset += bytes;
+            return size_t(start);
+        };
+        const uint64_t vertices = _header.vertices;
+        _positionSeek = next(vertices * 3 * sizeof(uint16_t));
+        _distanceSeek = next(vertices * sizeof(uint16_t));
+        _sectionSeek = next(_header.sectionBytes);
+        _triangleSeek = next(_header.triangleBytes);
+        _tristripSeek = next(_header.tristripBytes);
+    }
+
+    MeshCompressed(const std::string& source, const MeshVersion version)
+        : Mesh(source, version)
+        , _ptr(nullptr)
+        , _file(source.c_str(), std::ios::binary | std::ios::trunc)
+    {
+        if (!_file.is_open())
+            LBTHROW(std::runtime_error("Could not open mesh file " + source +
+                                       " for writing "));
+    }
+
+    ~MeshCompressed()
+    {
+        if (!_dirty)
+            return;
+        try
+        {
+            flush();
+        }
+        catch (const std::exception& e)
+        {
+            LBWARN << "Failed to write " << _source << ": " << e.what()
+                   << std::endl;
+        }
+    }
+
+    virtual size_t getNumVertices() const
+    {
+        return _ptr ? _header.vertices : _vertices.size();
+    }
+
+    virtual Vector3fsPtr readVertices() const
+    {
+        Vector3fsPtr buffer(new Vector3fs);
+        if (!_ptr)
+            return buffer;
+
+        const size_t count = _header.vertices;
+        std::vector<uint16_t> quantized(count * 3);
+        ::memcpy(quantized.data(), _ptr + _positionSeek,
+                 quantized.size() * sizeof(uint16_t));
+
+        // Straight-line dequantization into the output, which the compiler
+        // vectorizes; the float layout of Vector3fs is checked by the
+        // uncompressed binary format as well.
+        buffer->resize(count);
+        float* out = reinterpret_cast<float*>(buffer->data());
+        const float* min = _header.positionMin;
+        const float* scale = _header.positionScale;
+        for (size_t i = 0; i < count * 3; i += 3)
+        {
+            out[i] = min[0] + scale[0] * float(quantized[i]);
+            out[i + 1] = min[1] + scale[1] * float(quantized[i + 1]);
+            out[i + 2] = min[2] + scale[2] * float(quantized[i + 2]);
+        }
+        return buffer;
+    }
+
+    virtual uint16_tsPtr readVertexSections() const
+    {
+        uint16_tsPtr buffer(new uint16_ts);
+        if (!_ptr)
+            return buffer;
+
+        buffer->resize(_header.vertices);
+        codec::decodeDeltas(_ptr + _sectionSeek, _header.sectionBytes,
+                            buffer->data(), buffer->size());
+        return buffer;
+    }
+
+    virtual floatsPtr readVertexDistances() const
+    {
+        floatsPtr buffer(new floats);
+        if (!_ptr)
+            return buffer;
+
+        const size_t count = _header.vertices;
+        std::vector<uint16_t> quantized(count);
+        ::memcpy(quantized.data(), _ptr + _distanceSeek,
+                 count * sizeof(uint16_t));
+
+        buffer->resize(count);
+        float* out = buffer->data();
+        for (size_t i = 0; i < count; ++i)
+            out[i] = _header.distanceMin +
+                     _header.distanceScale * float(quantized[i]);
+        return buffer;
+    }
+
+    virtual size_t getNumTriangles() const
+    {
+        return _ptr ? _header.triangles : _triangles.size() / 3;
+    }
+
+    virtual uint32_tsPtr readTriangles() const
+    {
+        uint32_tsPtr buffer(new uint32_ts);
+        if (!_ptr)
+            return buffer;
+
+        buffer->resize(size_t(_header.triangles) * 3);
+        codec::decodeDeltas(_ptr + _triangleSeek, _header.triangleBytes,
+                            buffer->data(), buffer->size());
+        return buffer;
+    }
+
+    virtual uint16_tsPtr readTriangleSections() const
+    {
+        return uint16_tsPtr(new uint16_ts);
+    }
+
+    virtual floatsPtr readTriangleDistances() const
+    {
+        return floatsPtr(new floats);
+    }
+
+    virtual size_t getTriStripLength() const
+    {
+        return _ptr ? _header.tristrip : _tristrip.size();
+    }
+
+    virtual uint32_tsPtr readTriStrip() const
+    {
+        uint32_tsPtr buffer(new uint32_ts);
+        if (!_ptr)
+            return buffer;
+
+        buffer->resize(_header.tristrip);
+        codec::decodeDeltas(_ptr + _tristripSeek, _header.tristripBytes,
+                            buffer->data(), buffer->size());
+        return buffer;
+    }
+
+    virtual size_t getNumNormals() const { return 0u; }
+    virtual Vector3fsPtr readNormals() const
+    {
+        return Vector3fsPtr(new Vector3fs);
+    }
+
+    virtual size_t getNumStructures(const MeshStructure /*type*/) const
+    {
+        return 0u;
+    }
+
+    virtual Vector3fsPtr readStructureVertices(const MeshStructure /*type*/,
+                                               const size_t /*index*/) const
+    {
+        return Vector3fsPtr(new Vector3fs);
+    }
+
+    virtual uint32_tsPtr readStructureTriangles(const MeshStructure /*type*/,
+                                                const size_t /*index*/) const
+    {
+        return uint32_tsPtr(new uint32_ts);
+    }
+
+    virtual uint32_tsPtr readStructureTriStrip(const MeshStructure /*type*/,
+                                               const size_t /*index*/) const
+    {
+        return uint32_tsPtr(new uint32_ts);
+    }
+
+    virtual void writeVertices(const Vector3fs& vertices)
+    {
+        _vertices = vertices;
+        _dirty = true;
+    }
+
+    virtual void writeVertexSections(const uint16_ts& vSections)
+    {
+        if (_vertices.size() != vSections.size())
+            LBTHROW(
+                std::runtime_error("Number of vertices does not match "
+                                   "number of vertex sections"));
+        _sections = vSections;
+        _dirty = true;
+    }
+
+    virtual void writeVertexDistances(const floats& vDistances)
+    {
+        if (_vertices.size() != vDistances.size())
+            LBTHROW(
+                std::runtime_error("Number of vertices does not match "
+                                   "number of vertex distances"));
+        _distances = vDistances;
+        _dirty = true;
+    }
+
+    virtual void writeTriangles(const uint32_ts& triangles)
+    {
+        if (_vertices.empty())
+            LBTHROW(
+                std::runtime_error("No vertices written before "
+                                   "triangles"));
+        if (triangles.size() % 3 != 0)
+            LBTHROW(
+                std::runtime_error("Number of triangle indices is not a "
+                                   "multiple of 3"));
+        _triangles = triangles;
+        _dirty = true;
+    }
+
+    virtual void writeTriangleSections(const uint16_ts& /*tSections*/)
+    {
+        LBTHROW(
+            std::runtime_error("No triangle sections support for binary "
+                               "mesh files"));
+    }
+
+    virtual void writeTriangleDistances(const floats& /*tDistances*/)
+    {
+        LBTHROW(
+            std::runtime_error("No triangle distances support for binary "
+                               "mesh files"));
+    }
+
+    virtual void writeTriStrip(const uint32_ts& tristrip)
+    {
+        if (_vertices.empty())
+            LBTHROW(
+                std::runtime_error("No vertices written before "
+                                   "tristrip"));
+        _tristrip = tristrip;
+        _dirty = true;
+    }
+
+    virtual void writeNormals(const Vector3fs& /*normals*/)
+    {
+        LBTHROW(
+            std::runtime_error("No normal support for binary mesh "
+                               "files"));
+    }
+
+    virtual void writeStructureVertices(const Vector3fs& /*vertices*/,
+                                        const MeshStructure /*type*/,
+                                        const size_t /*index*/)
+    {
+        LBTHROW(
+            std::runtime_error("No structural mesh support for binary "
+                               "mesh files"));
+    }
+
+    virtual void writeStructureTriangles(const uint32_ts& /*triangles*/,
+                                         const MeshStructure /*type*/,
+                                         const size_t /*index*/)
+    {
+        LBTHROW(
+            std::runtime_error("No structural mesh support for binary "
+                               "mesh files"));
+    }
+
+    virtual void writeStructureTriStrip(const uint32_ts& /*tristrip*/,
+                                        const MeshStructure /*type*/,
+                                        const size_t /*index*/)
+    {
+        LBTHROW(
+            std::runtime_error("No structural mesh support for binary "
+                               "mesh files"));
+    }
+
+    virtual void flush()
+    {
+        if (!_file.is_open())
+            return;
+        _dirty = false;
+
+        const size_t count = _vertices.size();
+        MeshCompressedHeader header;
+        ::memset(&header, 0, sizeof(header));
+        header.vertices = uint32_t(count);
+        header.triangles = uint32_t(_triangles.size() / 3);
+        header.tristrip = uint32_t(_tristrip.size());
+        header.version = MESH_VERSION_3;
+        ::memcpy(header.magic, MESH_COMPRESSED_MAGIC, sizeof(header.magic));
+
+        // quantized positions within the bounding box
+        std::vector<uint16_t> positions(count * 3);
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            float min = count ? _vertices[0][axis] : 0.f;
+            float max = min;
+            for (const Vector3f& vertex : _vertices)
+            {
+                min = std::min(min, vertex[axis]);
+                max = std::max(max, vertex[axis]);
+            }
+            const float scale = codec::getScale(min, max);
+            header.positionMin[axis] = min;
+            header.positionScale[axis] = scale;
+            for (size_t i = 0; i < count; ++i)
+                positions[i * 3 + axis] =
+                    codec::quantize(_vertices[i][axis], min, scale);
+        }
+
+        // quantized distances, missing attributes are stored as zero
+        std::vector<uint16_t> distances(count, 0);
+        if (!_distances.empty())
+        {
+            const auto range =
+                std::minmax_element(_distances.begin(), _distances.end());
+            header.distanceMin = *range.first;
+            header.distanceScale = codec::getScale(*range.first,
+                                                   *range.second);
+            for (size_t i = 0; i < count; ++i)
+                distances[i] = codec::quantize(_distances[i],
+                                               header.distanceMin,
+                                               header.distanceScale);
+        }
+
+        std::vector<uint8_t> sections;
+        std::vector<uint8_t> triangles;
+        std::vector<uint8_t> tristrip;
+        _sections.resize(count, 0);
+        codec::encodeDeltas(_sections.data(), count, sections);
+        codec::encodeDeltas(_triangles.data(), _triangles.size(), triangles);
+        codec::encodeDeltas(_tristrip.data(), _tristrip.size(), tristrip);
+        header.sectionBytes = sections.size();
+        header.triangleBytes = triangles.size();
+        header.tristripBytes = tristrip.size();
+
+        _file.seekp(0);
+        _file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        _writeArray(positions.data(), positions.size());
+        _writeArray(distances.data(), distances.size());
+        _writeArray(sections.data(), sections.size());
+        _writeArray(triangles.data(), triangles.size());
+        _writeArray(tristrip.data(), tristrip.size());
+        _file.flush();
+        if (!_file)
+            LBTHROW(std::runtime_error("Could not write mesh file " +
+                                       _source));
+    }
+
+private:
+    std::unique_ptr<lunchbox::MemoryMap> _mmap;
+    const uint8_t* const _ptr;
+    MeshCompressedHeader _header;
+    size_t _positionSeek = 0;
+    size_t _distanceSeek = 0;
+    size_t _sectionSeek = 0;
+    size_t _triangleSeek = 0;
+    size_t _tristripSeek = 0;
+
+    std::ofstream _file;
+    bool _dirty = false;
+    Vector3fs _vertices;
+    uint16_ts _sections;
+    floats _distances;
+    uint32_ts _triangles;
+    uint32_ts _tristrip;
+
+    template <typename T>
+    void _writeArray(const T* data, const size_t count)
+    {
+        _file.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+    }
+};
+}
+}
+
+#endif
@@ -63,7 +63,8 @@ enum MeshFormat
 enum MeshVersion
 {
     MESH_VERSION_1 = 1,
-    MESH_VERSION_2 = 2
+    MESH_VERSION_2 = 2,
+    MESH_VERSION_3 = 3 //!< compressed binary mesh @version 3.0
 };
 
 /** The supported versions for morphology files. */
@@ -0,0 +1,93 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "flatMorphology.h"
+#include "morphology.h"
+
+#include <lunchbox/log.h>
+
+namespace brion
+{
+void buildChildren(const Vector2is& sections, uint32_ts& offsets,
+                   uint32_ts& children)
+{
+    // Counting sort of the sections by parent, which keeps the children of
+    // each section in increasing order.
+    const size_t numSections = sections.size();
+    offsets.assign(numSections + 1, 0);
+    for (const auto& section : sections)
+    {
+        const int32_t parent = section[1];
+        if (parent == -1)
+            continue;
+        if (parent < 0 || size_t(parent) >= numSections)
+            LBTHROW(std::runtime_error("Invalid parent section " +
+                                       std::to_string(parent)));
+        ++offsets[parent + 1];
+    }
+    for (size_t i = 0; i < numSections; ++i)
+        offsets[i + 1] += offsets[i];
+
+    children.resize(offsets.back());
+    uint32_ts next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < numSections; ++i)
+    {
+        const int32_t parent = sections[i][1];
+        if (parent != -1)
+            children[next[parent]++] = i;
+    }
+}
+
+FlatMorphology::FlatMorphology(const Morphology& morphology)
+{
+    const auto& points = morphology.getPoints();
+    const auto& sections = morphology.getSections();
+
+    const size_t numPoints = points.size();
+    _x.resize(numPoints);
+    _y.resize(numPoints);
+    _z.resize(numPoints);
+    _diameters.resize(numPoints);
+    for (size_t i = 0; i < numPoints; ++i)
+    {
+        _x[i] = points[i][0];
+        _y[i] = points[i][1];
+        _z[i] = points[i][2];
+        _diameters[i] = points[i][3];
+    }
+
+    _sectionOffsets.resize(sections.size() + 1);
+    _parents.resize(sections.size());
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        _sectionOffsets[i] = sections[i][0];
+        _parents[i] = sections[i][1];
+        if (sections[i][0] < 0 || size_t(sections[i][0]) > numPoints ||
+            (i > 0 && _sectionOffsets[i] < _sectionOffsets[i - 1]))
+        {
+            LBTHROW(std::runtime_error("Invalid first point of section " +
+                                       std::to_string(i)));
+        }
+    }
+    _sectionOffsets.back() = numPoints;
+
+    _types = morphology.getSectionTypes();
+    buildChildren(sections, _childOffsets, _children);
+}
+}
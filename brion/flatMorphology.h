@@ -0,0 +1,123 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brion/api.h>
+#include <brion/constSpan.h> // return value
+#include <brion/types.h>
+
+namespace brion
+{
+/**
+ * Structure-of-arrays copy of the points and topology of a Morphology.
+ *
+ * The point coordinates and diameters are stored in separate arrays, the
+ * first point of each section in an offset array with one extra element for
+ * the end of the last section, and the children of all sections in
+ * compressed sparse row format. Kernels iterating over all points or walking
+ * the section tree thus read contiguous arrays without pointer chasing.
+ *
+ * A flat morphology is built from a loaded Morphology, independently of the
+ * plugin which read it, and does not reference it after construction.
+ *
+ * @version 3.0
+ */
+class FlatMorphology
+{
+public:
+    /**
+     * Build the flat representation of the given morphology.
+     *
+     * @throw std::runtime_error if a section refers to an invalid parent or
+     *        the sections are not sorted by their first point.
+     */
+    BRION_API explicit FlatMorphology(const Morphology& morphology);
+
+    /** @return the number of points. */
+    size_t getNumPoints() const { return _x.size(); }
+    /** @return the number of sections. */
+    size_t getNumSections() const { return _types.size(); }
+
+    /** @return the x coordinates of all points. */
+    ConstSpan<float> getX() const { return _x; }
+    /** @return the y coordinates of all points. */
+    ConstSpan<float> getY() const { return _y; }
+    /** @return the z coordinates of all points. */
+    ConstSpan<float> getZ() const { return _z; }
+    /** @return the diameters of all points. */
+    ConstSpan<float> getDiameters() const { return _diameters; }
+
+    /**
+     * @return the index of the first point of each section, followed by the
+     *         number of points. The points of section i are in
+     *         [offsets[i], offsets[i + 1]).
+     */
+    ConstSpan<uint32_t> getSectionOffsets() const { return _sectionOffsets; }
+
+    /** @return the parent of each section, -1 for root sections. */
+    ConstSpan<int32_t> getParents() const { return _parents; }
+
+    /** @return the type of each section. */
+    ConstSpan<SectionType> getSectionTypes() const { return _types; }
+
+    /**
+     * @return the row offsets of the children in compressed sparse row
+     *         format. The children of section i are
+     *         getChildIndices()[offsets[i], offsets[i + 1]).
+     */
+    ConstSpan<uint32_t> getChildOffsets() const { return _childOffsets; }
+
+    /** @return the children of all sections, ordered by parent and index. */
+    ConstSpan<uint32_t> getChildIndices() const { return _children; }
+
+    /** @return the children of the given section in increasing order. */
+    ConstSpan<uint32_t> getChildren(const uint32_t section) const
+    {
+        const uint32_t begin = _childOffsets[section];
+        return ConstSpan<uint32_t>(_children.data() + begin,
+                                   _childOffsets[section + 1] - begin);
+    }
+
+private:
+    floats _x;
+    floats _y;
+    floats _z;
+    floats _diameters;
+    uint32_ts _sectionOffsets;
+    int32_ts _parents;
+    SectionTypes _types;
+    uint32_ts _childOffsets;
+    uint32_ts _children;
+};
+
+/**
+ * Build the children of each section in compressed sparse row format.
+ *
+ * @param sections the first point and parent of each section, as returned by
+ *        Morphology::getSections().
+ * @param offsets set to the row offsets, one more than the number of sections.
+ * @param children set to the children of all sections, ordered by parent and
+ *        index.
+ * @throw std::runtime_error if a parent is out of range.
+ * @version 3.0
+ */
+BRION_API void buildChildren(const Vector2is& sections, uint32_ts& offsets,
+                             uint32_ts& children);
+}
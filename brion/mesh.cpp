@@ -19,9 +19,13 @@
 
 #include "mesh.h"
 #include "detail/meshBinary.h"
+#include "detail/meshCompressed.h"
 #include "detail/meshHDF5.h"
 
 #include <boost/filesystem.hpp>
+#include <lunchbox/threadPool.h>
+
+#include <unordered_map>
 
 #define ASSERT_WRITE                                             \
     if (!_impl->_write)                                          \
@@ -40,7 +44,10 @@ Mesh::Mesh(const std::string& source)
     const std::string& ext = fs::extension(path);
     if (ext == ".bin")
     {
-        _impl = new detail::MeshBinary(source);
+        if (detail::MeshCompressed::isCompressed(source))
+            _impl = new detail::MeshCompressed(source);
+        else
+            _impl = new detail::MeshBinary(source);
         return;
     }
     if (ext == ".h5" || ext == ".hdf5")
@@ -61,11 +68,17 @@ Mesh::Mesh(const std::string& source, const MeshFormat format,
     switch (format)
     {
     case MESHFORMAT_HDF5:
+        if (version == MESH_VERSION_3)
+            LBTHROW(std::runtime_error("No compression support for HDF5 "
+                                       "mesh files"));
         _impl = new detail::MeshHDF5(source, overwrite, version);
         return;
     case MESHFORMAT_BINARY:
     default:
-        _impl = new detail::MeshBinary(source, version);
+        if (version == MESH_VERSION_3)
+            _impl = new detail::MeshCompressed(source, version);
+        else
+            _impl = new detail::MeshBinary(source, version);
     }
 }
 
@@ -162,6 +175,36 @@ uint32_tsPtr Mesh::readStructureTriStrip(const MeshStructure type,
     return _impl->readStructureTriStrip(type, index);
 }
 
+ConstSpan<Vector3f> Mesh::getVertices() const
+{
+    return _impl->getVertices();
+}
+
+ConstSpan<uint16_t> Mesh::getVertexSections() const
+{
+    return _impl->getVertexSections();
+}
+
+ConstSpan<float> Mesh::getVertexDistances() const
+{
+    return _impl->getVertexDistances();
+}
+
+ConstSpan<uint32_t> Mesh::getTriangles() const
+{
+    return _impl->getTriangles();
+}
+
+ConstSpan<uint32_t> Mesh::getTriStrip() const
+{
+    return _impl->getTriStrip();
+}
+
+ConstSpan<Vector3f> Mesh::getNormals() const
+{
+    return _impl->getNormals();
+}
+
 void Mesh::writeVertices(const Vector3fs& vertices)
 {
     ASSERT_WRITE;
@@ -238,4 +281,54 @@ void Mesh::flush()
     ASSERT_WRITE;
     _impl->flush();
 }
+
+Meshes loadMeshes(const Strings& sources, const MeshLoadOptions& options)
+{
+    // deduplicate, remembering the unique mesh of each source
+    std::unordered_map<std::string, size_t> lookup;
+    Strings unique;
+    size_ts indices;
+    indices.reserve(sources.size());
+    for (const auto& source : sources)
+    {
+        const auto result =
+            lookup.insert(std::make_pair(source, unique.size()));
+        if (result.second)
+            unique.push_back(source);
+        indices.push_back(result.first->second);
+    }
+    if (unique.empty())
+        return Meshes();
+
+    size_t maxThreads = options.maxThreads;
+    if (maxThreads == 0)
+        maxThreads = std::thread::hardware_concurrency();
+    maxThreads = std::max(size_t(1), std::min(maxThreads, unique.size()));
+
+    Meshes meshes(unique.size());
+    {
+        std::vector<std::future<void>> futures;
+        futures.reserve(unique.size());
+        lunchbox::ThreadPool threadPool{maxThreads};
+        for (size_t i = 0; i < unique.size(); ++i)
+        {
+            futures.push_back(threadPool.post([&, i] {
+                MeshPtr mesh(new Mesh(unique[i]));
+                if (options.prefetch)
+                    mesh->_impl->prefetch();
+                meshes[i] = mesh;
+            }));
+        }
+        for (auto& future : futures)
+            future.wait();
+        for (auto& future : futures)
+            future.get(); // rethrows load errors
+    }
+
+    Meshes result;
+    result.reserve(sources.size());
+    for (const size_t index : indices)
+        result.push_back(meshes[index]);
+    return result;
+}
 }
@@ -22,6 +22,7 @@
 
 #include <boost/noncopyable.hpp>
 #include <brion/api.h>
+#include <brion/constSpan.h> // return value
 #include <brion/types.h>
 
 namespace brion
@@ -136,6 +137,36 @@ public:
                                                  size_t index) const;
     //@}
 
+    /** @name Zero-copy read API
+     *
+     * The views of binary meshes point directly into the memory-mapped file,
+     * other formats read the data into memory once per call unless the mesh
+     * was prefetched by loadMeshes(). Each view keeps its data alive, also
+     * after the destruction of the Mesh.
+     */
+    //@{
+    /** @return view on the vertices. @version 3.0 */
+    BRION_API ConstSpan<Vector3f> getVertices() const;
+
+    /** @return view on the section indices of each vertex. @version 3.0 */
+    BRION_API ConstSpan<uint16_t> getVertexSections() const;
+
+    /**
+     * @return view on the relative distances in the section of each vertex.
+     * @version 3.0
+     */
+    BRION_API ConstSpan<float> getVertexDistances() const;
+
+    /** @return view on the triangle indices. @version 3.0 */
+    BRION_API ConstSpan<uint32_t> getTriangles() const;
+
+    /** @return view on the triangle strip indices. @version 3.0 */
+    BRION_API ConstSpan<uint32_t> getTriStrip() const;
+
+    /** @return view on the per-vertex normals. @version 3.0 */
+    BRION_API ConstSpan<Vector3f> getNormals() const;
+    //@}
+
     /** @name Write API */
     //@{
     /** Open the given mesh file for write access.
@@ -143,7 +174,9 @@ public:
      * @param source filepath to mesh file
      * @param format output format of the mesh
      * @param overwrite true to allow overwrite of existing file
-     * @param version the output file format version
+     * @param version the output file format version. MESH_VERSION_3 writes a
+     *        compressed binary mesh with 16 bit quantized vertex positions
+     *        and distances, which is encoded on flush().
      * @throw std::runtime_error if file could not be opened for write access
      */
     BRION_API Mesh(const std::string& source, MeshFormat format,
@@ -257,7 +290,42 @@ public:
 
 private:
     detail::Mesh* _impl;
+
+    friend Meshes loadMeshes(const Strings&, const MeshLoadOptions&);
 };
+
+/** Options for loadMeshes(). @version 3.0 */
+struct MeshLoadOptions
+{
+    /**
+     * The maximum number of meshes opened concurrently, or 0 to use the
+     * number of hardware threads.
+     */
+    size_t maxThreads = 0;
+
+    /**
+     * Read the surface mesh data while loading. Binary meshes fault in their
+     * memory mapping, other formats read and keep the arrays returned by the
+     * zero-copy read API.
+     */
+    bool prefetch = true;
+};
+
+/**
+ * Open a list of meshes in parallel.
+ *
+ * Identical sources are opened only once.
+ *
+ * @param sources the mesh files to open.
+ * @param options the load options.
+ * @return the meshes in the order of the given sources. Identical sources
+ *         share the same Mesh object.
+ * @throw std::runtime_error if any of the meshes could not be opened.
+ * @version 3.0
+ */
+BRION_API Meshes loadMeshes(
+    const Strings& sources,
+    const MeshLoadOptions& options = MeshLoadOptions());
 }
 
 #endif
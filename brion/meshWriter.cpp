@@ -0,0 +1,338 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "meshWriter.h"
+
+#include <boost/filesystem.hpp>
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace brion
+{
+namespace
+{
+/**
+ * Block-buffered array stream, spooling full blocks to a temporary file or
+ * directly to the output.
+ */
+class Stream
+{
+public:
+    Stream(const size_t blockSize, std::ofstream* output)
+        : _block(new uint8_t[blockSize])
+        , _blockSize(blockSize)
+        , _output(output)
+    {
+    }
+
+    ~Stream()
+    {
+        if (_spool)
+            std::fclose(_spool);
+    }
+
+    void write(const void* data, size_t size)
+    {
+        const uint8_t* ptr = static_cast<const uint8_t*>(data);
+        _size += size;
+        while (size > 0)
+        {
+            const size_t chunk = std::min(size, _blockSize - _used);
+            ::memcpy(_block.get() + _used, ptr, chunk);
+            _used += chunk;
+            ptr += chunk;
+            size -= chunk;
+            if (_used == _blockSize)
+                _writeBlock();
+        }
+    }
+
+    void fill(size_t size)
+    {
+        _size += size;
+        while (size > 0)
+        {
+            const size_t chunk = std::min(size, _blockSize - _used);
+            ::memset(_block.get() + _used, 0, chunk);
+            _used += chunk;
+            size -= chunk;
+            if (_used == _blockSize)
+                _writeBlock();
+        }
+    }
+
+    /** Append the complete stream to the given output. */
+    void copyTo(std::ofstream& output)
+    {
+        if (_spool)
+        {
+            std::rewind(_spool);
+            for (;;)
+            {
+                const size_t read =
+                    std::fread(_block.get() + _used, 1, _blockSize - _used,
+                               _spool);
+                if (read == 0)
+                    break;
+                // keep the unspooled tail at the end of the block
+                output.write(reinterpret_cast<const char*>(_block.get() +
+                                                           _used),
+                             read);
+            }
+        }
+        output.write(reinterpret_cast<const char*>(_block.get()), _used);
+        _used = 0;
+    }
+
+    /** Write the buffered data to the output given at construction. */
+    void flush()
+    {
+        if (_used > 0)
+            _writeBlock();
+    }
+
+    uint64_t getSize() const { return _size; }
+private:
+    std::unique_ptr<uint8_t[]> _block;
+    const size_t _blockSize;
+    size_t _used = 0;
+    uint64_t _size = 0;
+    std::ofstream* const _output; // direct output, spool file if nullptr
+    std::FILE* _spool = nullptr;
+
+    void _writeBlock()
+    {
+        if (_output)
+            _output->write(reinterpret_cast<const char*>(_block.get()), _used);
+        else
+        {
+            if (!_spool)
+                _spool = std::tmpfile();
+            if (!_spool || std::fwrite(_block.get(), 1, _used, _spool) != _used)
+                LBTHROW(std::runtime_error("Cannot write mesh spool file"));
+        }
+        _used = 0;
+    }
+};
+}
+
+class MeshWriter::Impl
+{
+public:
+    Impl(const std::string& destination, const bool overwrite,
+         const MeshVersion version, const size_t blockSize)
+        : _destination(destination)
+        , _vertices(blockSize, &_file)
+        , _sections(blockSize, nullptr)
+        , _distances(blockSize, nullptr)
+        , _triangles(blockSize, nullptr)
+        , _triStrip(blockSize, nullptr)
+    {
+        if (blockSize == 0)
+            LBTHROW(std::runtime_error("Mesh block size must not be 0"));
+        if (version == MESH_VERSION_3)
+            LBTHROW(std::runtime_error("Cannot stream compressed meshes"));
+        if (!overwrite && boost::filesystem::exists(destination))
+            LBTHROW(std::runtime_error("Cannot override existing file " +
+                                       destination));
+
+        _file.open(destination.c_str(), std::ios::binary | std::ios::trunc);
+        if (!_file.is_open())
+            LBTHROW(std::runtime_error("Could not open mesh file " +
+                                       destination + " for writing"));
+
+        // placeholder header, vertices are streamed directly after it
+        const uint32_t header[] = {0, 0, 0, uint32_t(version)};
+        _file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+
+    void addIndices(Stream& stream, const uint32_t* indices, const size_t count)
+    {
+        _checkOpen();
+        for (size_t i = 0; i < count; ++i)
+            _maxIndex = std::max(_maxIndex, int64_t(indices[i]));
+        stream.write(indices, count * sizeof(uint32_t));
+    }
+
+    void flush()
+    {
+        _checkOpen();
+        _flushed = true;
+
+        const uint64_t numVertices = getNumVertices();
+        if (_sections.getSize() > numVertices * sizeof(uint16_t) ||
+            _distances.getSize() > numVertices * sizeof(float))
+        {
+            LBTHROW(std::runtime_error(
+                "More vertex sections or distances than vertices in " +
+                _destination));
+        }
+        if (_triangles.getSize() % (3 * sizeof(uint32_t)) != 0)
+            LBTHROW(std::runtime_error(
+                "Number of triangle indices is not a multiple of 3 in " +
+                _destination));
+        if (_maxIndex >= int64_t(numVertices))
+            LBTHROW(std::runtime_error("Vertex index out of range in " +
+                                       _destination));
+        if (numVertices > std::numeric_limits<uint32_t>::max() ||
+            _triangles.getSize() / (3 * sizeof(uint32_t)) >
+                std::numeric_limits<uint32_t>::max())
+        {
+            LBTHROW(std::runtime_error("Too many vertices or triangles for " +
+                                       _destination));
+        }
+
+        _sections.fill(numVertices * sizeof(uint16_t) - _sections.getSize());
+        _distances.fill(numVertices * sizeof(float) - _distances.getSize());
+
+        _vertices.flush();
+        _sections.copyTo(_file);
+        _distances.copyTo(_file);
+        _triangles.copyTo(_file);
+        _triStrip.copyTo(_file);
+
+        const uint32_t header[] = {
+            uint32_t(numVertices),
+            uint32_t(_triangles.getSize() / (3 * sizeof(uint32_t))),
+            uint32_t(_triStrip.getSize() / sizeof(uint32_t))};
+        _file.seekp(0);
+        _file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        _file.close();
+        if (_file.fail())
+            LBTHROW(std::runtime_error("Could not write mesh file " +
+                                       _destination));
+    }
+
+    uint64_t getNumVertices() const
+    {
+        return _vertices.getSize() / sizeof(Vector3f);
+    }
+
+    void _checkOpen() const
+    {
+        if (_flushed)
+            LBTHROW(std::runtime_error("Mesh file " + _destination +
+                                       " already finished"));
+    }
+
+    const std::string _destination;
+    std::ofstream _file;
+    Stream _vertices;
+    Stream _sections;
+    Stream _distances;
+    Stream _triangles;
+    Stream _triStrip;
+    int64_t _maxIndex = -1;
+    bool _flushed = false;
+};
+
+MeshWriter::MeshWriter(const std::string& destination, const bool overwrite,
+                       const MeshVersion version, const size_t blockSize)
+    : _impl(new Impl(destination, overwrite, version, blockSize))
+{
+}
+
+MeshWriter::~MeshWriter()
+{
+    if (_impl->_flushed)
+        return;
+    try
+    {
+        flush();
+    }
+    catch (const std::exception& e)
+    {
+        LBERROR << e.what() << std::endl;
+    }
+}
+
+void MeshWriter::addVertices(const Vector3f* vertices, const size_t count)
+{
+    _impl->_checkOpen();
+    _impl->_vertices.write(vertices, count * sizeof(Vector3f));
+}
+
+void MeshWriter::addVertices(const Vector3fs& vertices)
+{
+    addVertices(vertices.data(), vertices.size());
+}
+
+void MeshWriter::addVertexSections(const uint16_t* sections,
+                                   const size_t count)
+{
+    _impl->_checkOpen();
+    _impl->_sections.write(sections, count * sizeof(uint16_t));
+}
+
+void MeshWriter::addVertexSections(const uint16_ts& sections)
+{
+    addVertexSections(sections.data(), sections.size());
+}
+
+void MeshWriter::addVertexDistances(const float* distances, const size_t count)
+{
+    _impl->_checkOpen();
+    _impl->_distances.write(distances, count * sizeof(float));
+}
+
+void MeshWriter::addVertexDistances(const floats& distances)
+{
+    addVertexDistances(distances.data(), distances.size());
+}
+
+void MeshWriter::addTriangles(const uint32_t* indices, const size_t count)
+{
+    _impl->addIndices(_impl->_triangles, indices, count);
+}
+
+void MeshWriter::addTriangles(const uint32_ts& indices)
+{
+    addTriangles(indices.data(), indices.size());
+}
+
+void MeshWriter::addTriStrip(const uint32_t* indices, const size_t count)
+{
+    _impl->addIndices(_impl->_triStrip, indices, count);
+}
+
+void MeshWriter::addTriStrip(const uint32_ts& indices)
+{
+    addTriStrip(indices.data(), indices.size());
+}
+
+size_t MeshWriter::getNumVertices() const
+{
+    return _impl->getNumVertices();
+}
+
+size_t MeshWriter::getNumTriangleIndices() const
+{
+    return _impl->_triangles.getSize() / sizeof(uint32_t);
+}
+
+void MeshWriter::flush()
+{
+    _impl->flush();
+}
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brion/api.h>
+#include <brion/types.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace brion
+{
+/**
+ * Single-pass writer for binary mesh files.
+ *
+ * The arrays of a mesh are added in chunks of any size and in any order. The
+ * vertices are streamed directly into the output file, all other arrays are
+ * buffered in blocks and spooled to temporary files once a block is full.
+ * flush() appends the spooled arrays sequentially and writes the header, so
+ * memory use is bounded by a few blocks independent of the mesh size.
+ *
+ * The written files are identical to binary meshes written through Mesh and
+ * are read by Mesh.
+ *
+ * @version 3.0
+ */
+class MeshWriter : public boost::noncopyable
+{
+public:
+    /**
+     * Open the given binary mesh file for writing.
+     *
+     * @param destination filepath of the mesh file.
+     * @param overwrite true to allow overwriting an existing file.
+     * @param version the output file format version, MESH_VERSION_3 is not
+     *        supported for streaming.
+     * @param blockSize the size of the write buffers in bytes.
+     * @throw std::runtime_error if the file could not be opened.
+     */
+    BRION_API MeshWriter(const std::string& destination,
+                         bool overwrite = false,
+                         MeshVersion version = MESH_VERSION_1,
+                         size_t blockSize = 4 << 20);
+
+    /** Finish the mesh file if flush() was not called. */
+    BRION_API ~MeshWriter();
+
+    /** Append vertices describing the surface/membrane mesh. */
+    BRION_API void addVertices(const Vector3f* vertices, size_t count);
+    BRION_API void addVertices(const Vector3fs& vertices);
+
+    /** Append section indices for the next vertices. */
+    BRION_API void addVertexSections(const uint16_t* sections, size_t count);
+    BRION_API void addVertexSections(const uint16_ts& sections);
+
+    /** Append relative distances in the section for the next vertices. */
+    BRION_API void addVertexDistances(const float* distances, size_t count);
+    BRION_API void addVertexDistances(const floats& distances);
+
+    /**
+     * Append triangle indices, three per triangle. Triangles may be split
+     * across calls.
+     */
+    BRION_API void addTriangles(const uint32_t* indices, size_t count);
+    BRION_API void addTriangles(const uint32_ts& indices);
+
+    /** Append triangle strip indices. */
+    BRION_API void addTriStrip(const uint32_t* indices, size_t count);
+    BRION_API void addTriStrip(const uint32_ts& indices);
+
+    /** @return the number of vertices added so far. */
+    BRION_API size_t getNumVertices() const;
+
+    /** @return the number of triangle indices added so far. */
+    BRION_API size_t getNumTriangleIndices() const;
+
+    /**
+     * Finish the mesh file.
+     *
+     * Vertex sections and distances which were not added for all vertices
+     * are filled with zeros. No data can be added afterwards.
+     *
+     * @throw std::runtime_error if more vertex sections or distances than
+     *        vertices were added, the triangle indices are not a multiple of
+     *        three, an index refers to a missing vertex or the file could not
+     *        be written.
+     */
+    BRION_API void flush();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
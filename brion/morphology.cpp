@@ -25,6 +25,14 @@
 #include <lunchbox/pluginFactory.h>
 #include <lunchbox/threadPool.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
 namespace brion
 {
 namespace
@@ -86,6 +94,23 @@ public:
     {
     }
 
+    explicit Impl(std::unique_ptr<MorphologyPlugin> loaded)
+        : plugin(std::move(loaded))
+    {
+    }
+
+    static std::unique_ptr<MorphologyPlugin> load(const URI& uri)
+    {
+        std::unique_ptr<MorphologyPlugin> plugin(
+            MorphologyPluginFactory::getInstance().create(
+                MorphologyInitData(uri)));
+        plugin->load();
+        if (plugin->getPoints().empty())
+            LBTHROW(std::runtime_error("Failed to load morphology " +
+                                       std::to_string(uri)));
+        return plugin;
+    }
+
     ~Impl()
     {
         try
@@ -131,6 +156,11 @@ Morphology::Morphology(const Morphology& from)
 {
 }
 
+Morphology::Morphology(std::unique_ptr<MorphologyPlugin> plugin)
+    : _impl(new Impl(std::move(plugin)))
+{
+}
+
 Morphology& Morphology::operator=(const Morphology& from)
 {
     if (this != &from)
@@ -216,4 +246,111 @@ servus::Serializable::Data Morphology::toBinary() const
     _impl->finishLoad();
     return _impl->plugin->toBinary();
 }
+
+namespace
+{
+struct LoadResult
+{
+    size_t index;
+    std::unique_ptr<MorphologyPlugin> plugin;
+    std::exception_ptr error;
+};
+}
+
+void loadMorphologies(const URIs& uris, const MorphologyLoadedFunc& func,
+                      const MorphologyLoadOptions& options)
+{
+    // deduplicate, remembering all users of each unique URI
+    std::unordered_map<std::string, size_t> lookup;
+    URIs unique;
+    std::vector<size_ts> users;
+    for (size_t i = 0; i < uris.size(); ++i)
+    {
+        const auto result = lookup.insert(
+            std::make_pair(std::to_string(uris[i]), unique.size()));
+        if (result.second)
+        {
+            unique.push_back(uris[i]);
+            users.push_back(size_ts());
+        }
+        users[result.first->second].push_back(i);
+    }
+    if (unique.empty())
+        return;
+
+    size_ts order(unique.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (options.sortByLocation)
+    {
+        std::sort(order.begin(), order.end(),
+                  [&unique](const size_t a, const size_t b) {
+                      const URI& lhs = unique[a];
+                      const URI& rhs = unique[b];
+                      return std::tie(lhs.getScheme(), lhs.getHost(),
+                                      lhs.getPath()) <
+                             std::tie(rhs.getScheme(), rhs.getHost(),
+                                      rhs.getPath());
+                  });
+    }
+
+    size_t maxThreads = options.maxThreads;
+    if (maxThreads == 0)
+        maxThreads = std::thread::hardware_concurrency();
+    maxThreads = std::max(size_t(1), std::min(maxThreads, unique.size()));
+
+    // completed loads, handed from the workers to the calling thread
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<LoadResult> results;
+
+    lunchbox::ThreadPool threadPool{maxThreads};
+    for (const size_t index : order)
+    {
+        threadPool.post([&, index] {
+            LoadResult result{index, nullptr, nullptr};
+            try
+            {
+                result.plugin = Morphology::Impl::load(unique[index]);
+            }
+            catch (...)
+            {
+                result.error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(result));
+            condition.notify_one();
+        });
+    }
+
+    for (size_t i = 0; i < unique.size(); ++i)
+    {
+        LoadResult result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&results] { return !results.empty(); });
+            result = std::move(results.front());
+            results.pop_front();
+        }
+        if (result.error)
+            std::rethrow_exception(result.error);
+
+        const MorphologyPtr morphology(
+            new Morphology(std::move(result.plugin)));
+        for (const size_t user : users[result.index])
+            func(user, morphology);
+    }
+}
+
+Morphologies loadMorphologies(const URIs& uris,
+                              const MorphologyLoadOptions& options)
+{
+    Morphologies morphologies(uris.size());
+    loadMorphologies(uris,
+                     [&morphologies](const size_t index,
+                                     MorphologyPtr morphology) {
+                         morphologies[index] = morphology;
+                     },
+                     options);
+    return morphologies;
+}
 }
@@ -25,6 +25,8 @@
 #include <servus/serializable.h> // return value
 #include <vmmlib/vector.hpp>     // return value
 
+#include <functional>
+
 namespace brion
 {
 /** Read access a Morphology file.
@@ -109,6 +111,65 @@ public:
 private:
     class Impl;
     std::unique_ptr<Impl> _impl;
+
+    explicit Morphology(std::unique_ptr<MorphologyPlugin> plugin);
+    friend void loadMorphologies(const URIs&, const MorphologyLoadedFunc&,
+                                 const MorphologyLoadOptions&);
+};
+
+/** Options for loadMorphologies(). @version 3.0 */
+struct MorphologyLoadOptions
+{
+    /**
+     * The maximum number of morphologies read concurrently, or 0 to use the
+     * number of hardware threads.
+     */
+    size_t maxThreads = 0;
+
+    /**
+     * Read morphologies grouped by their container (scheme and host) and in
+     * path order, which follows the on-disk layout of most file systems more
+     * closely than the input order.
+     */
+    bool sortByLocation = true;
 };
+
+/**
+ * Load a list of morphologies in parallel and process them as they arrive.
+ *
+ * In contrast to constructing each Morphology individually, which queues the
+ * load in the global thread pool, identical URIs are loaded only once and all
+ * reads are done by a dedicated set of at most options.maxThreads threads.
+ *
+ * The callback is invoked from the calling thread in completion order, once
+ * for each index of the given URIs. Identical URIs receive the same
+ * Morphology object.
+ *
+ * @param uris the morphologies to load
+ * @param func the function called with the index of the URI and its loaded
+ *        morphology
+ * @param options the load options
+ * @throw std::runtime_error if any of the morphologies could not be loaded
+ * @version 3.0
+ */
+BRION_API void loadMorphologies(
+    const URIs& uris, const MorphologyLoadedFunc& func,
+    const MorphologyLoadOptions& options = MorphologyLoadOptions());
+
+/**
+ * Load a list of morphologies in parallel.
+ *
+ * @param uris the morphologies to load
+ * @param options the load options
+ * @return the loaded morphologies in the order of the given URIs. Identical
+ *         URIs share the same Morphology object.
+ * @throw std::runtime_error if any of the morphologies could not be loaded
+ * @sa loadMorphologies(const URIs&, const MorphologyLoadedFunc&,
+ *                      const MorphologyLoadOptions&)
+ * @version 3.0
+ */
+BRION_API Morphologies loadMorphologies(
+    const URIs& uris,
+    const MorphologyLoadOptions& options = MorphologyLoadOptions());
 }
 #endif
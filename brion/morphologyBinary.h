@@ -0,0 +1,317 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brion/types.h>
+#include <servus/serializable.h> // return value
+
+#include <cstring>
+
+namespace brion
+{
+/**
+ * Binary layout of a serialized morphology.
+ *
+ * A serialized morphology is a fixed-size header followed by the point,
+ * section, section type and perimeter arrays. Each array starts at an offset
+ * which is a multiple of MORPHOLOGY_BINARY_ALIGNMENT from the start of the
+ * header, so a reader which mmaps the data (or receives it in a page-aligned
+ * buffer) can point directly into it without copying. The same layout is used
+ * by the keyv morphology cache, the ZeroEQ morphology transport and the
+ * morphologyServer.
+ *
+ * The header records the byte order of the writer. Readers reject data written
+ * with a different byte order, an unknown format version or a wrong checksum.
+ *
+ * @version 3.0
+ */
+struct MorphologyBinaryHeader
+{
+    /** The arrays stored in a serialized morphology, in storage order. */
+    enum Array
+    {
+        ARRAY_POINTS = 0,
+        ARRAY_SECTIONS,
+        ARRAY_SECTION_TYPES,
+        ARRAY_PERIMETERS,
+        ARRAY_ALL //!< @internal must be last
+    };
+
+    /** Optional features of the serialized data. */
+    enum Flags
+    {
+        FLAG_NONE = 0,
+        FLAG_CHECKSUM = 1 << 0, //!< checksum holds the CRC32 of the payload
+        FLAG_LZ4 = 1 << 1       //!< payload is LZ4-compressed (reserved)
+    };
+
+    struct ArrayInfo
+    {
+        uint64_t offset; //!< bytes from the start of the header
+        uint64_t count;  //!< number of elements
+    };
+
+    char magic[8];          //!< "BRIONMOR"
+    uint32_t byteOrder;     //!< MORPHOLOGY_BINARY_BYTE_ORDER of the writer
+    uint32_t formatVersion; //!< MORPHOLOGY_BINARY_VERSION of the writer
+    uint32_t flags;         //!< bitwise combination of Flags
+    uint32_t version;       //!< MorphologyVersion of the source data
+    uint32_t family;        //!< CellFamily of the source data
+    uint32_t checksum;      //!< CRC32 of all bytes after the header
+    uint64_t size;          //!< total size in bytes, including the header
+    ArrayInfo arrays[ARRAY_ALL];
+    uint8_t reserved[24];
+};
+static_assert(sizeof(MorphologyBinaryHeader) == 128,
+              "MorphologyBinaryHeader must be 128 bytes");
+
+/**
+ * Binary layout of a batch of serialized morphologies.
+ *
+ * A batch is a header followed by one entry per morphology and the serialized
+ * morphologies. Each morphology starts at an offset which is a multiple of
+ * MORPHOLOGY_BINARY_ALIGNMENT from the start of the batch, so it can be read
+ * in place like a single serialized morphology. An entry with a zero size
+ * denotes a morphology which could not be loaded. Batches are the reply to
+ * ZEROEQ_GET_MORPHOLOGIES requests.
+ *
+ * @version 3.0
+ */
+struct MorphologyBatchHeader
+{
+    struct Entry
+    {
+        uint64_t offset; //!< bytes from the start of the batch header
+        uint64_t size;   //!< size of the serialized morphology in bytes
+    };
+
+    char magic[8];      //!< "BRIONMBT"
+    uint32_t byteOrder; //!< MORPHOLOGY_BINARY_BYTE_ORDER of the writer
+    uint32_t count;     //!< number of entries following the header
+    uint64_t size;      //!< total size in bytes, including the header
+};
+static_assert(sizeof(MorphologyBatchHeader) == 24,
+              "MorphologyBatchHeader must be 24 bytes");
+
+const char MORPHOLOGY_BINARY_MAGIC[8] = {'B', 'R', 'I', 'O',
+                                         'N', 'M', 'O', 'R'};
+const char MORPHOLOGY_BATCH_MAGIC[8] = {'B', 'R', 'I', 'O',
+                                        'N', 'M', 'B', 'T'};
+const uint32_t MORPHOLOGY_BINARY_VERSION = 1;
+const uint32_t MORPHOLOGY_BINARY_BYTE_ORDER = 0x01020304u;
+const size_t MORPHOLOGY_BINARY_ALIGNMENT = 64;
+
+namespace binary
+{
+/** @return the next multiple of MORPHOLOGY_BINARY_ALIGNMENT of the value. */
+inline uint64_t align(const uint64_t value)
+{
+    return (value + MORPHOLOGY_BINARY_ALIGNMENT - 1) &
+           ~uint64_t(MORPHOLOGY_BINARY_ALIGNMENT - 1);
+}
+
+/** @return the CRC32 (IEEE 802.3) of the given data. */
+inline uint32_t crc32(const void* data, const size_t size)
+{
+    struct Table
+    {
+        Table()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t value = i;
+                for (size_t j = 0; j < 8; ++j)
+                    value = (value & 1) ? 0xEDB88320u ^ (value >> 1)
+                                        : value >> 1;
+                entries[i] = value;
+            }
+        }
+        uint32_t entries[256];
+    };
+    static const Table table;
+
+    const uint8_t* ptr = static_cast<const uint8_t*>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i)
+        crc = table.entries[(crc ^ ptr[i]) & 0xFFu] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+/**
+ * Validate the header of a serialized morphology.
+ *
+ * Checks the magic, byte order, format version and that all arrays lie within
+ * the given size. Does not verify the checksum, see verify().
+ *
+ * @return the header, or nullptr if the data is not a valid serialized
+ *         morphology readable by this implementation.
+ */
+inline const MorphologyBinaryHeader* getHeader(const void* data,
+                                               const size_t size)
+{
+    if (!data || size < sizeof(MorphologyBinaryHeader))
+        return nullptr;
+
+    const auto header = static_cast<const MorphologyBinaryHeader*>(data);
+    if (::memcmp(header->magic, MORPHOLOGY_BINARY_MAGIC,
+                 sizeof(header->magic)) != 0 ||
+        header->byteOrder != MORPHOLOGY_BINARY_BYTE_ORDER ||
+        header->formatVersion != MORPHOLOGY_BINARY_VERSION ||
+        header->size > size ||
+        (header->flags & MorphologyBinaryHeader::FLAG_LZ4))
+    {
+        return nullptr;
+    }
+
+    const size_t elementSizes[] = {sizeof(Vector4f), sizeof(Vector2i),
+                                   sizeof(SectionType), sizeof(float)};
+    for (size_t i = 0; i < MorphologyBinaryHeader::ARRAY_ALL; ++i)
+    {
+        const auto& array = header->arrays[i];
+        if (array.offset % MORPHOLOGY_BINARY_ALIGNMENT != 0 ||
+            array.offset < sizeof(MorphologyBinaryHeader) ||
+            array.offset > header->size ||
+            array.count > (header->size - array.offset) / elementSizes[i])
+        {
+            return nullptr;
+        }
+    }
+    return header;
+}
+
+/** @return true if the checksum of a validated header matches its payload. */
+inline bool verify(const MorphologyBinaryHeader& header)
+{
+    if (!(header.flags & MorphologyBinaryHeader::FLAG_CHECKSUM))
+        return true;
+
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(&header + 1);
+    return crc32(payload, header.size - sizeof(MorphologyBinaryHeader)) ==
+           header.checksum;
+}
+
+/**
+ * @return a pointer to the first element of the given array of a validated
+ *         header. The pointer is suitably aligned for T if the header is.
+ */
+template <typename T>
+const T* getArray(const MorphologyBinaryHeader& header,
+                  const MorphologyBinaryHeader::Array array)
+{
+    return reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(
+                                          &header) +
+                                      header.arrays[array].offset);
+}
+
+/**
+ * Pack serialized morphologies into a batch.
+ *
+ * @param morphologies the serialized morphologies, empty ones denote
+ *        morphologies which could not be loaded.
+ * @return the batch, see MorphologyBatchHeader.
+ */
+inline servus::Serializable::Data packBatch(
+    const std::vector<servus::Serializable::Data>& morphologies)
+{
+    typedef MorphologyBatchHeader::Entry Entry;
+    const size_t count = morphologies.size();
+
+    std::vector<Entry> entries(count);
+    uint64_t offset = sizeof(MorphologyBatchHeader) + count * sizeof(Entry);
+    for (size_t i = 0; i < count; ++i)
+    {
+        offset = align(offset);
+        entries[i].offset = offset;
+        entries[i].size = morphologies[i].ptr ? morphologies[i].size : 0;
+        offset += entries[i].size;
+    }
+
+    MorphologyBatchHeader header;
+    ::memcpy(header.magic, MORPHOLOGY_BATCH_MAGIC, sizeof(header.magic));
+    header.byteOrder = MORPHOLOGY_BINARY_BYTE_ORDER;
+    header.count = uint32_t(count);
+    header.size = offset;
+
+    servus::Serializable::Data data;
+    data.size = header.size;
+    uint8_t* ptr = new uint8_t[data.size];
+    data.ptr.reset(ptr, std::default_delete<uint8_t[]>());
+    ::memset(ptr, 0, data.size); // padding
+    ::memcpy(ptr, &header, sizeof(header));
+    if (count > 0)
+        ::memcpy(ptr + sizeof(header), entries.data(), count * sizeof(Entry));
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (entries[i].size > 0)
+            ::memcpy(ptr + entries[i].offset, morphologies[i].ptr.get(),
+                     entries[i].size);
+    }
+    return data;
+}
+
+/**
+ * Validate a batch of serialized morphologies.
+ *
+ * Checks the magic, byte order and that all entries lie within the given
+ * size, after the header and the entry table. The serialized morphologies
+ * are validated by getHeader().
+ *
+ * @return the header, or nullptr if the data is not a valid batch.
+ */
+inline const MorphologyBatchHeader* getBatchHeader(const void* data,
+                                                   const size_t size)
+{
+    typedef MorphologyBatchHeader::Entry Entry;
+    if (!data || size < sizeof(MorphologyBatchHeader))
+        return nullptr;
+
+    const auto header = static_cast<const MorphologyBatchHeader*>(data);
+    if (::memcmp(header->magic, MORPHOLOGY_BATCH_MAGIC,
+                 sizeof(header->magic)) != 0 ||
+        header->byteOrder != MORPHOLOGY_BINARY_BYTE_ORDER ||
+        header->size > size || header->size < sizeof(MorphologyBatchHeader) ||
+        header->count > (header->size - sizeof(MorphologyBatchHeader)) /
+                            sizeof(Entry))
+    {
+        return nullptr;
+    }
+
+    const uint64_t tableEnd =
+        sizeof(MorphologyBatchHeader) + header->count * sizeof(Entry);
+    const Entry* entries = reinterpret_cast<const Entry*>(header + 1);
+    for (uint32_t i = 0; i < header->count; ++i)
+    {
+        if (entries[i].offset < tableEnd || entries[i].offset > header->size ||
+            entries[i].size > header->size - entries[i].offset)
+        {
+            return nullptr;
+        }
+    }
+    return header;
+}
+
+/** @return the entries of a validated batch header. */
+inline const MorphologyBatchHeader::Entry* getBatchEntries(
+    const MorphologyBatchHeader& header)
+{
+    return reinterpret_cast<const MorphologyBatchHeader::Entry*>(&header + 1);
+}
+}
+}
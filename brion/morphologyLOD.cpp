@@ -0,0 +1,264 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "morphologyLOD.h"
+#include "flatMorphology.h"
+#include "morphology.h"
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <tuple>
+
+namespace brion
+{
+namespace
+{
+const float KEEP_ALWAYS = std::numeric_limits<float>::infinity();
+
+/**
+ * @return the deviation of the point from the segment [a, b]: the maximum of
+ *         its distance to the closest point and of the difference of its
+ *         radius to the radius interpolated at that point.
+ */
+float _getError(const Vector4f& p, const Vector4f& a, const Vector4f& b)
+{
+    const Vector3f ab = (b - a).get_sub_vector<3, 0>();
+    const Vector3f ap = (p - a).get_sub_vector<3, 0>();
+    const float length2 = ab.squared_length();
+    const float t =
+        length2 == 0 ? 0 : std::max(0.f, std::min(1.f, ap.dot(ab) / length2));
+
+    const float distance = (ap - ab * t).length();
+    const float diameter = a[3] + (b[3] - a[3]) * t;
+    return std::max(distance, std::abs(p[3] - diameter) * .5f);
+}
+
+/**
+ * Compute the Douglas-Peucker importance of the points of a section: the
+ * largest tolerance for which the point is kept. A point split off at a given
+ * error is only reached if all enclosing splits were done, so its importance
+ * is bounded by the importance of the enclosing split.
+ */
+void _computeImportance(const Vector4f* points, const size_t size,
+                        float* importance)
+{
+    if (size == 0)
+        return;
+    importance[0] = KEEP_ALWAYS;
+    importance[size - 1] = KEEP_ALWAYS;
+
+    std::vector<std::tuple<size_t, size_t, float>> stack;
+    stack.emplace_back(0, size - 1, KEEP_ALWAYS);
+    while (!stack.empty())
+    {
+        size_t first, last;
+        float bound;
+        std::tie(first, last, bound) = stack.back();
+        stack.pop_back();
+        if (last - first < 2)
+            continue;
+
+        size_t split = first + 1;
+        float maxError = -1;
+        for (size_t i = first + 1; i < last; ++i)
+        {
+            const float error = _getError(points[i], points[first],
+                                          points[last]);
+            if (error > maxError)
+            {
+                maxError = error;
+                split = i;
+            }
+        }
+        const float value = std::min(maxError, bound);
+        importance[split] = value;
+        stack.emplace_back(first, split, value);
+        stack.emplace_back(split, last, value);
+    }
+}
+
+/** Per-section data shared by all levels of detail of a morphology. */
+struct Analysis
+{
+    explicit Analysis(const Morphology& morphology)
+    {
+        const auto& points = morphology.getPoints();
+        const auto& sections = morphology.getSections();
+        const auto& types = morphology.getSectionTypes();
+        const size_t numSections = sections.size();
+
+        ranges.resize(numSections);
+        for (size_t i = 0; i < numSections; ++i)
+        {
+            const size_t begin = sections[i][0];
+            const size_t end = i + 1 < numSections ? sections[i + 1][0]
+                                                   : points.size();
+            if (begin > end || end > points.size())
+                LBTHROW(std::runtime_error(
+                    "Invalid first point of section " + std::to_string(i)));
+            ranges[i] = std::make_pair(begin, end);
+        }
+
+        importance.resize(points.size(), KEEP_ALWAYS);
+        lengths.resize(numSections, 0.f);
+#pragma omp parallel for schedule(dynamic)
+        for (int64_t i = 0; i < int64_t(numSections); ++i)
+        {
+            if (types[i] == SECTION_SOMA)
+                continue;
+            const size_t begin = ranges[i].first;
+            const size_t end = ranges[i].second;
+            _computeImportance(points.data() + begin, end - begin,
+                               importance.data() + begin);
+            for (size_t j = begin + 1; j < end; ++j)
+                lengths[i] +=
+                    (points[j] - points[j - 1]).get_sub_vector<3, 0>().length();
+        }
+
+        uint32_ts childOffsets;
+        uint32_ts children;
+        buildChildren(sections, childOffsets, children);
+
+        orders.resize(numSections, 0);
+        terminal.resize(numSections);
+        uint32_ts stack;
+        for (size_t i = 0; i < numSections; ++i)
+        {
+            terminal[i] = childOffsets[i] == childOffsets[i + 1];
+            if (sections[i][1] != -1)
+                continue;
+            orders[i] = types[i] == SECTION_SOMA ? 0 : 1;
+            stack.push_back(i);
+        }
+        while (!stack.empty())
+        {
+            const uint32_t parent = stack.back();
+            stack.pop_back();
+            for (uint32_t j = childOffsets[parent];
+                 j < childOffsets[parent + 1]; ++j)
+            {
+                const uint32_t child = children[j];
+                orders[child] = orders[parent] + 1;
+                stack.push_back(child);
+            }
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    floats importance; // per point
+    floats lengths;    // per section
+    uint32_ts orders;  // per section
+    std::vector<bool> terminal;
+};
+
+MorphologyPtr _simplify(const Morphology& morphology,
+                        const Analysis& analysis, const MorphologyLOD& lod)
+{
+    const auto& points = morphology.getPoints();
+    const auto& sections = morphology.getSections();
+    const auto& types = morphology.getSectionTypes();
+    const auto& perimeters = morphology.getPerimeters();
+
+    Vector4fs newPoints;
+    Vector2is newSections;
+    SectionTypes newTypes;
+    floats newPerimeters;
+    newPoints.reserve(points.size());
+
+    // Sections are pruned as whole subtrees: the descendants of a section
+    // exceeding the branch order do as well, and only terminal sections are
+    // pruned by length.
+    int32_ts newIndices(sections.size(), -1);
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        const bool soma = types[i] == SECTION_SOMA;
+        if (!soma && lod.maxBranchOrder > 0 &&
+            analysis.orders[i] > lod.maxBranchOrder)
+        {
+            continue;
+        }
+        if (!soma && analysis.terminal[i] &&
+            analysis.lengths[i] < lod.minTerminalLength)
+        {
+            continue;
+        }
+
+        const int32_t parent = sections[i][1];
+        if (parent != -1 && newIndices[parent] == -1)
+        {
+            // parent pruned or not yet emitted
+            if (parent >= int32_t(i))
+                LBTHROW(std::runtime_error(
+                    "Cannot simplify morphology with unsorted sections"));
+            continue;
+        }
+
+        newIndices[i] = newSections.size();
+        newSections.push_back(Vector2i(int32_t(newPoints.size()),
+                                       parent == -1 ? -1 : newIndices[parent]));
+        newTypes.push_back(types[i]);
+        for (size_t j = analysis.ranges[i].first;
+             j < analysis.ranges[i].second; ++j)
+        {
+            if (soma || analysis.importance[j] > lod.tolerance)
+            {
+                newPoints.push_back(points[j]);
+                if (!perimeters.empty())
+                    newPerimeters.push_back(perimeters[j]);
+            }
+        }
+    }
+
+    MorphologyPtr simplified(new Morphology(morphology));
+    simplified->getPoints().swap(newPoints);
+    simplified->getSections().swap(newSections);
+    simplified->getSectionTypes().swap(newTypes);
+    simplified->getPerimeters().swap(newPerimeters);
+    return simplified;
+}
+}
+
+std::string MorphologyLOD::getKey() const
+{
+    // all digits, so different parameters never share a cache key
+    std::ostringstream key;
+    key.precision(std::numeric_limits<float>::max_digits10);
+    key << "lod:" << tolerance << ":" << maxBranchOrder << ":"
+        << minTerminalLength;
+    return key.str();
+}
+
+MorphologyPtr simplify(const Morphology& morphology, const MorphologyLOD& lod)
+{
+    return _simplify(morphology, Analysis(morphology), lod);
+}
+
+Morphologies simplify(const Morphology& morphology, const MorphologyLODs& lods)
+{
+    const Analysis analysis(morphology);
+    Morphologies result;
+    result.reserve(lods.size());
+    for (const auto& lod : lods)
+        result.push_back(_simplify(morphology, analysis, lod));
+    return result;
+}
+}
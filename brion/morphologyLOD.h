@@ -0,0 +1,86 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brion/api.h>
+#include <brion/types.h>
+
+#include <string>
+
+namespace brion
+{
+/**
+ * Parameters of a simplified level of detail of a morphology.
+ *
+ * The points of each section are decimated with the Douglas-Peucker
+ * algorithm. A point is removed if the simplified section passes within
+ * tolerance of its position and its radius differs by at most tolerance from
+ * the interpolated radius. The first and last point of each section and the
+ * soma are always kept.
+ *
+ * @version 3.0
+ */
+struct MorphologyLOD
+{
+    /** Maximum deviation of the simplified sections in micrometers. */
+    float tolerance = 0.f;
+
+    /**
+     * Maximum branch order of the kept sections, 0 to keep all. Sections
+     * connected to the soma have branch order 1.
+     */
+    uint32_t maxBranchOrder = 0;
+
+    /** Minimum length of the kept terminal sections in micrometers. */
+    float minTerminalLength = 0.f;
+
+    /** @return a string identifying this level of detail, e.g. for caching */
+    BRION_API std::string getKey() const;
+};
+typedef std::vector<MorphologyLOD> MorphologyLODs;
+
+/**
+ * Create a simplified copy of a morphology.
+ *
+ * @param morphology the morphology to simplify.
+ * @param lod the level of detail to create.
+ * @return the simplified morphology, with the version and cell family of the
+ *         source.
+ * @throw std::runtime_error if the topology of the morphology is invalid.
+ * @version 3.0
+ */
+BRION_API MorphologyPtr simplify(const Morphology& morphology,
+                                 const MorphologyLOD& lod);
+
+/**
+ * Create simplified copies of a morphology for several levels of detail.
+ *
+ * The section analysis is done once for all levels, so this is faster than
+ * simplifying the morphology for each level separately.
+ *
+ * @param morphology the morphology to simplify.
+ * @param lods the levels of detail to create.
+ * @return one simplified morphology per level of detail, in the same order.
+ * @throw std::runtime_error if the topology of the morphology is invalid.
+ * @version 3.0
+ */
+BRION_API Morphologies simplify(const Morphology& morphology,
+                                const MorphologyLODs& lods);
+}
@@ -17,6 +17,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <brion/morphologyBinary.h>
 #include <lunchbox/debug.h>
 
 namespace brion
@@ -24,99 +25,96 @@ namespace brion
 namespace
 {
 template <typename T>
-size_t _getSerializationSize(const std::vector<T>& vector)
+void _serializeArray(uint8_t* base, const MorphologyBinaryHeader& header,
+                     const MorphologyBinaryHeader::Array index,
+                     const std::vector<T>& src)
 {
-    return sizeof(uint64_t) + vector.size() * sizeof(T);
+    const auto& array = header.arrays[index];
+    if (!src.empty())
+        ::memcpy(base + array.offset, src.data(), sizeof(T) * src.size());
 }
 
 template <typename T>
-void _serializeArray(uint8_t*& dst, const std::vector<T>& src)
+void _deserializeArray(std::vector<T>& dst,
+                       const MorphologyBinaryHeader& header,
+                       const MorphologyBinaryHeader::Array index)
 {
-    const uint64_t arraySize = src.size();
-    *reinterpret_cast<uint64_t*>(dst) = arraySize;
-    dst += sizeof(uint64_t);
-
-    if (arraySize > 0)
-    {
-        memcpy(dst, src.data(), sizeof(T) * src.size());
-        dst += sizeof(T) * src.size();
-    }
+    // copy through memcpy, the source may not be aligned for T
+    dst.resize(header.arrays[index].count);
+    if (!dst.empty())
+        ::memcpy(dst.data(), binary::getArray<uint8_t>(header, index),
+                 sizeof(T) * dst.size());
+}
 }
 
-template <typename T>
-bool _deserializeArray(std::vector<T>& dst, const uint8_t*& src,
-                       const uint8_t* end)
+servus::Serializable::Data inline MorphologyPlugin::_toBinary() const
 {
-    if (src + sizeof(uint64_t) > end)
-        return false;
-    const uint64_t arraySize = *reinterpret_cast<const uint64_t*>(src);
-    src += sizeof(uint64_t);
-
-    if (arraySize == 0)
+    MorphologyBinaryHeader header;
+    ::memset(&header, 0, sizeof(header));
+    ::memcpy(header.magic, MORPHOLOGY_BINARY_MAGIC, sizeof(header.magic));
+    header.byteOrder = MORPHOLOGY_BINARY_BYTE_ORDER;
+    header.formatVersion = MORPHOLOGY_BINARY_VERSION;
+    header.flags = MorphologyBinaryHeader::FLAG_CHECKSUM;
+    header.version = _data.version;
+    header.family = _data.family;
+
+    const size_t sizes[] = {_points.size() * sizeof(Vector4f),
+                            _sections.size() * sizeof(Vector2i),
+                            _sectionTypes.size() * sizeof(SectionType),
+                            _perimeters.size() * sizeof(float)};
+    header.arrays[MorphologyBinaryHeader::ARRAY_POINTS].count = _points.size();
+    header.arrays[MorphologyBinaryHeader::ARRAY_SECTIONS].count =
+        _sections.size();
+    header.arrays[MorphologyBinaryHeader::ARRAY_SECTION_TYPES].count =
+        _sectionTypes.size();
+    header.arrays[MorphologyBinaryHeader::ARRAY_PERIMETERS].count =
+        _perimeters.size();
+
+    uint64_t offset = sizeof(MorphologyBinaryHeader);
+    for (size_t i = 0; i < MorphologyBinaryHeader::ARRAY_ALL; ++i)
     {
-        dst.clear();
-        return true;
+        offset = binary::align(offset);
+        header.arrays[i].offset = offset;
+        offset += sizes[i];
     }
+    header.size = offset;
 
-    if (src + sizeof(T) * arraySize > end)
-        return false;
-    const T* srcPtr = reinterpret_cast<const T*>(src);
-    dst.assign(srcPtr, srcPtr + arraySize);
-    src += sizeof(T) * arraySize;
-    return true;
-}
-}
-
-servus::Serializable::Data inline MorphologyPlugin::_toBinary() const
-{
     servus::Serializable::Data data;
-    data.size = sizeof(MorphologyVersion) + sizeof(CellFamily) +
-                _getSerializationSize(_points) +
-                _getSerializationSize(_sections) +
-                _getSerializationSize(_sectionTypes) +
-                _getSerializationSize(_perimeters);
-
+    data.size = header.size;
     uint8_t* ptr = new uint8_t[data.size];
     data.ptr.reset(ptr, std::default_delete<uint8_t[]>());
-
-    *reinterpret_cast<MorphologyVersion*>(ptr) = _data.version;
-    ptr += sizeof(MorphologyVersion);
-
-    *reinterpret_cast<CellFamily*>(ptr) = _data.family;
-    ptr += sizeof(CellFamily);
-
-    _serializeArray(ptr, _points);
-    _serializeArray(ptr, _sections);
-    _serializeArray(ptr, _sectionTypes);
-    _serializeArray(ptr, _perimeters);
+    ::memset(ptr + sizeof(header), 0, data.size - sizeof(header)); // padding
+
+    _serializeArray(ptr, header, MorphologyBinaryHeader::ARRAY_POINTS,
+                    _points);
+    _serializeArray(ptr, header, MorphologyBinaryHeader::ARRAY_SECTIONS,
+                    _sections);
+    _serializeArray(ptr, header, MorphologyBinaryHeader::ARRAY_SECTION_TYPES,
+                    _sectionTypes);
+    _serializeArray(ptr, header, MorphologyBinaryHeader::ARRAY_PERIMETERS,
+                    _perimeters);
+
+    header.checksum =
+        binary::crc32(ptr + sizeof(header), data.size - sizeof(header));
+    ::memcpy(ptr, &header, sizeof(header));
     return data;
 }
 
 bool inline MorphologyPlugin::_fromBinary(const void* data, const size_t size)
 {
-    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
-    const uint8_t* const end = ptr + size;
-    if (size < sizeof(MorphologyVersion) + sizeof(CellFamily))
+    const MorphologyBinaryHeader* header = binary::getHeader(data, size);
+    if (!header || !binary::verify(*header))
         return false;
 
-    _data.version = *reinterpret_cast<const MorphologyVersion*>(ptr);
-    ptr += sizeof(MorphologyVersion);
-
-    _data.family = *reinterpret_cast<const CellFamily*>(ptr);
-    ptr += sizeof(CellFamily);
-
-    if (_deserializeArray(_points, ptr, end) &&
-        _deserializeArray(_sections, ptr, end) &&
-        _deserializeArray(_sectionTypes, ptr, end) &&
-        _deserializeArray(_perimeters, ptr, end))
-    {
-        return true;
-    }
-
-    _points.clear();
-    _sections.clear();
-    _sectionTypes.clear();
-    _perimeters.clear();
-    return false;
+    _data.version = MorphologyVersion(header->version);
+    _data.family = CellFamily(header->family);
+    _deserializeArray(_points, *header, MorphologyBinaryHeader::ARRAY_POINTS);
+    _deserializeArray(_sections, *header,
+                      MorphologyBinaryHeader::ARRAY_SECTIONS);
+    _deserializeArray(_sectionTypes, *header,
+                      MorphologyBinaryHeader::ARRAY_SECTION_TYPES);
+    _deserializeArray(_perimeters, *header,
+                      MorphologyBinaryHeader::ARRAY_PERIMETERS);
+    return true;
 }
 }
@@ -71,10 +71,23 @@ size_t CompartmentReportCommon::getFrameCount() const
 GIDSet CompartmentReportCommon::_computeIntersection(const GIDSet& all,
                                                      const GIDSet& subset)
 {
+    // Look up each requested GID if the subset is small compared to the
+    // report, otherwise merge both sets. The result is built in order, so
+    // inserting at its end is constant time.
     GIDSet intersection;
-    std::set_intersection(subset.begin(), subset.end(), all.begin(), all.end(),
-                          std::inserter(intersection, intersection.begin()));
-    if (intersection != subset || intersection.empty())
+    if (subset.size() * 32 < all.size())
+    {
+        for (const uint32_t gid : subset)
+            if (all.count(gid))
+                intersection.emplace_hint(intersection.end(), gid);
+    }
+    else
+        std::set_intersection(subset.begin(), subset.end(), all.begin(),
+                              all.end(),
+                              std::inserter(intersection, intersection.end()));
+
+    // the intersection is a subset of subset, same size means same content
+    if (intersection.size() != subset.size() || intersection.empty())
     {
         LBWARN << "Requested " << subset.size() << " GIDs [" << *subset.begin()
                << ":" << *subset.rbegin() << "] are not a subset of the "
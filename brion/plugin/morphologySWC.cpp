@@ -20,14 +20,15 @@
 
 #include "morphologySWC.h"
 
-#include "../detail/skipWhiteSpace.h"
-
-#include <fstream>
-#include <list>
 #include <lunchbox/debug.h>
 #include <lunchbox/log.h>
+#include <lunchbox/memoryMap.h>
 #include <lunchbox/pluginRegisterer.h>
 
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
 namespace brion
 {
 namespace plugin
@@ -61,20 +62,16 @@ struct Sample
     {
     }
 
-    explicit Sample(const char* line)
-        : nextID(-1)
+    Sample(const int type_, const Vector4f& point_, const int parent_)
+        // Unknown section types, custom samples are also regarded as unknown.
+        : valid(type_ >= SWC_SECTION_UNDEFINED && type_ < SWC_SECTION_CUSTOM)
+        , point(point_)
+        , type(SWCSectionType(type_))
+        , parent(parent_)
+        , nextID(-1)
         , siblingID(-1)
         , parentSection(-1)
     {
-        float radius;
-        valid =
-            sscanf(line, "%20d%20f%20f%20f%20f%20d", (int*)&type, &point.x(),
-                   &point.y(), &point.z(), &radius, &parent) == 6;
-        point.w() = radius * 2; // The point array stores diameters.
-
-        if (type >= SWC_SECTION_CUSTOM)
-            valid = false; // Unknown section type, custom samples are also
-                           // Regarded as unknown.
     }
 
     bool valid;
@@ -90,6 +87,67 @@ typedef std::vector<Sample> Samples;
 
 lunchbox::PluginRegisterer<MorphologySWC> registerer;
 
+// Tokenizer for one line of the memory mapped file. The numbers are parsed in
+// place with strtol/strtof, which stop at the first character that does not
+// belong to the number. Blanks are skipped explicitly to never cross the end
+// of the line.
+class LineParser
+{
+public:
+    LineParser(const char* begin, const char* end)
+        : _pos(begin)
+        , _end(end)
+    {
+    }
+
+    bool parse(int& value)
+    {
+        if (!_skipBlanks())
+            return false;
+        char* next;
+        const long result = std::strtol(_pos, &next, 10);
+        if (!_advance(next))
+            return false;
+        value = int(result);
+        return true;
+    }
+
+    bool parse(float& value)
+    {
+        if (!_skipBlanks())
+            return false;
+        char* next;
+        const float result = std::strtof(_pos, &next);
+        if (!_advance(next))
+            return false;
+        value = result;
+        return true;
+    }
+
+    /** @return true if the next character separates two fields. */
+    bool atBlank() const { return _pos < _end && _isBlank(*_pos); }
+
+private:
+    const char* _pos;
+    const char* const _end;
+
+    static bool _isBlank(const char c) { return c == ' ' || c == '\t'; }
+    bool _skipBlanks()
+    {
+        while (_pos < _end && _isBlank(*_pos))
+            ++_pos;
+        return _pos < _end && *_pos != '\r';
+    }
+
+    bool _advance(const char* next)
+    {
+        if (next == _pos || next > _end)
+            return false;
+        _pos = next;
+        return true;
+    }
+};
+
 void _correctSampleType(Sample& sample, const Samples& samples)
 {
     SWCSectionType type = sample.type;
@@ -190,53 +248,73 @@ std::string MorphologySWC::getDescription()
 
 void MorphologySWC::_readSamples(RawSWCInfo& info)
 {
-    std::ifstream file(info.filename.c_str());
-    if (file.fail())
+    const lunchbox::MemoryMap file(info.filename);
+    const char* const data = static_cast<const char*>(file.getAddress());
+    if (!data)
         LBTHROW(std::runtime_error("Error opening morphology file: " +
                                    info.filename));
 
     Samples& samples = info.samples;
-
+    const char* const dataEnd = data + file.getSize();
+    std::string lastLine; // null-terminated copy of an unterminated last line
     size_t lineNumber = 0;
-    file >> detail::SkipWhiteSpace(lineNumber);
-    std::string line;
     size_t totalSamples = 0;
-    while (!std::getline(file, line).fail())
+
+    for (const char* next = data; next < dataEnd;)
     {
+        const char* begin = next;
+        const char* end = static_cast<const char*>(
+            ::memchr(begin, '\n', dataEnd - begin));
+        if (end)
+            next = end + 1;
+        else
+        {
+            lastLine.assign(begin, dataEnd);
+            begin = lastLine.c_str();
+            end = begin + lastLine.size();
+            next = dataEnd;
+        }
         ++lineNumber;
+
+        while (begin < end && ::isspace(static_cast<unsigned char>(*begin)))
+            ++begin;
         // Fix #4: Subsequent non-empty lines each represent a single neuron
         // sample point with seven data items.
-        if (line[0] == '#' || line.empty())
+        if (begin == end || *begin == '#')
             continue;
 
-        char* data;
-        const unsigned int id = strtol(line.data(), &data, 10);
-        if (*data != ' ')
+        LineParser parser(begin, end);
+        int id, type, parent;
+        Vector4f point;
+        float radius;
+        if (!parser.parse(id) || id < 0 || !parser.atBlank() ||
+            !parser.parse(type) || !parser.parse(point.x()) ||
+            !parser.parse(point.y()) || !parser.parse(point.z()) ||
+            !parser.parse(radius) || !parser.parse(parent))
         {
             LBTHROW(std::runtime_error(
                 "Reading swc morphology file: " + info.filename +
                 ", parse error at line " + std::to_string(lineNumber)));
         }
+        point.w() = radius * 2; // The point array stores diameters.
+
         samples.resize(std::max(samples.size(), size_t(id + 1)));
         if (samples[id].valid)
         {
             LBWARN << "Reading swc morphology file: " << info.filename
                    << ", repeated sample id " << id << " at line "
                    << std::to_string(lineNumber) << std::endl;
+            continue;
         }
-        else
+
+        samples[id] = Sample(type, point, parent);
+        ++totalSamples;
+        if (!samples[id].valid)
         {
-            samples[id] = Sample(data);
-            ++totalSamples;
-            if (!samples[id].valid)
-            {
-                LBTHROW(std::runtime_error(
-                    "Reading swc morphology file: " + info.filename +
-                    ", parse error at line " + std::to_string(lineNumber)));
-            }
+            LBTHROW(std::runtime_error(
+                "Reading swc morphology file: " + info.filename +
+                ", parse error at line " + std::to_string(lineNumber)));
         }
-
-        file >> detail::SkipWhiteSpace(lineNumber);
     }
     info.totalValidSamples = totalSamples;
 }
@@ -402,7 +480,9 @@ void MorphologySWC::_buildSampleTree(RawSWCInfo& info)
 
 void MorphologySWC::_buildStructure(RawSWCInfo& info)
 {
-    std::list<size_t> sectionQueue(info.roots.begin(), info.roots.end());
+    // Depth-first traversal using a flat stack of section start samples. The
+    // roots are pushed in reverse order to process the soma first.
+    std::vector<size_t> sectionStack(info.roots.rbegin(), info.roots.rend());
 
     int section = 0;
     // All sections except the soma section and the first order sections
@@ -417,8 +497,8 @@ void MorphologySWC::_buildStructure(RawSWCInfo& info)
     _sectionTypes.reserve(info.numSections);
     Samples& samples = info.samples;
 
-    Sample* sample = &samples[sectionQueue.front()];
-    sectionQueue.pop_front();
+    Sample* sample = &samples[sectionStack.back()];
+    sectionStack.pop_back();
     while (sample)
     {
         _sections.push_back(
@@ -457,7 +537,7 @@ void MorphologySWC::_buildStructure(RawSWCInfo& info)
         if (sample)
         {
             // We reached a bifurcation or a section type change, pushing
-            // the sibling (if any) to the sectionQeueue and continuing
+            // the sibling (if any) to the sectionStack and continuing
             // traversing the current section
             assert(sample->siblingID != -1 ||
                    sample->type != SWCSectionType(_sectionTypes.back()));
@@ -467,14 +547,14 @@ void MorphologySWC::_buildStructure(RawSWCInfo& info)
             // the next iteration.
             sample->parentSection = section;
 
-            // Pushing all siblings into the queue and unlinking them
+            // Pushing all siblings onto the stack and unlinking them
             int siblingID = sample->siblingID;
             sample->siblingID = -1;
             while (siblingID != -1)
             {
-                // We do push_front to continue on the same subtree and
-                // do a depth-first traversal.
-                sectionQueue.push_front(siblingID);
+                // Pushing on top of the stack continues on the same subtree
+                // for a depth-first traversal.
+                sectionStack.push_back(siblingID);
                 Sample* sibling = &samples[siblingID];
                 // Assigning the parent section to the sibling
                 sibling->parentSection = section;
@@ -482,12 +562,12 @@ void MorphologySWC::_buildStructure(RawSWCInfo& info)
                 sibling->siblingID = -1;
             }
         }
-        else if (!sectionQueue.empty())
+        else if (!sectionStack.empty())
         {
             // Reached an end point. Starting the next section from
-            // the sectionQueue if not empty
-            sample = &samples[sectionQueue.front()];
-            sectionQueue.pop_front();
+            // the sectionStack if not empty
+            sample = &samples[sectionStack.back()];
+            sectionStack.pop_back();
         }
         ++section;
     }
@@ -20,13 +20,16 @@
 #include "morphologyZeroEQ.h"
 
 #include "../constants.h"
+#include "../morphologyBinary.h"
 
 #include <lunchbox/pluginRegisterer.h>
 #include <lunchbox/threadPool.h>
 #include <zeroeq/client.h>
 #include <zeroeq/uri.h>
 
+#include <deque>
 #include <mutex>
+#include <unordered_map>
 
 namespace brion
 {
@@ -36,11 +39,42 @@ namespace
 {
 lunchbox::PluginRegisterer<MorphologyZeroEQ> registerer;
 const std::string SERVER_SESSION("morphologyServer");
+const size_t DEFAULT_BATCH_SIZE = 64;
+
+size_t _getBatchSize()
+{
+    const char* size = getenv("BRION_MORPHOLOGY_BATCH_SIZE");
+    if (size)
+    {
+        try
+        {
+            return std::max(size_t(1), size_t(std::stoul(size)));
+        }
+        catch (const std::exception& exc)
+        {
+            LBWARN << "Could not set BRION_MORPHOLOGY_BATCH_SIZE to " << size
+                   << ": " << exc.what() << std::endl;
+        }
+    }
+    return DEFAULT_BATCH_SIZE;
+}
 }
 
-class MorphologyZeroEQ::Client // adds thread-safety to zeroeq::Client
+/**
+ * Adds thread-safety and request coalescing to zeroeq::Client.
+ *
+ * Requested paths are queued and sent once no other request is in flight or
+ * once enough paths for a full batch are queued. Paths queued while waiting
+ * for a reply are thus sent together in one ZEROEQ_GET_MORPHOLOGIES request,
+ * and many requests may be outstanding at the same time. Each reply is
+ * dispatched to the handlers of its request.
+ */
+class MorphologyZeroEQ::Client
 {
 public:
+    /** Called with the serialized morphology, or nullptr on failure. */
+    using Handler = std::function<void(const void*, size_t)>;
+
     Client()
         : _client(getenv(zeroeq::ENV_REP_SESSION.c_str())
                       ? zeroeq::DEFAULT_SESSION
@@ -53,16 +87,20 @@ public:
     {
     }
 
-    bool request(const uint128_t& r, const void* data, size_t size,
-                 const zeroeq::ReplyFunc& func)
+    void request(const std::string& path, const Handler& handler)
     {
         std::lock_guard<std::mutex> lock(_mutex);
-        return _client.request(r, data, size, func);
+        _pending.push_back({path, handler});
+        if (_inFlight == 0 || _pending.size() >= _batchSize)
+            _flush();
     }
 
     bool receive()
     {
         std::lock_guard<std::mutex> lock(_mutex);
+        if (_inFlight == 0)
+            _flush();
+
         // While this is polling, it has shown to be the fastest implementation
         // since the ctor is not blocked for an arbitrary amount of time, and
         // different load threads get an early chance to do work since the
@@ -74,34 +112,131 @@ public:
     void unlock() { _mutex.unlock(); }
 
 private:
+    struct Request
+    {
+        std::string path;
+        Handler handler;
+    };
+    using Requests = std::vector<Request>;
+
     std::mutex _mutex;
     zeroeq::Client _client;
+    std::deque<Request> _pending;
+    size_t _inFlight = 0;
+    size_t _batchSize = _getBatchSize();
+
+    void _flush()
+    {
+        while (!_pending.empty())
+        {
+            const size_t size = std::min(_pending.size(), _batchSize);
+            Requests requests(_pending.begin(), _pending.begin() + size);
+            _pending.erase(_pending.begin(), _pending.begin() + size);
+
+            if (requests.size() == 1)
+                _send(requests.front());
+            else
+                _send(std::move(requests));
+        }
+    }
+
+    void _send(const Request& request)
+    {
+        const Handler handler = request.handler;
+        const auto func = [this, handler](const uint128_t& id,
+                                          const void* data, const size_t size) {
+            --_inFlight;
+            if (id == ZEROEQ_GET_MORPHOLOGY && data && size)
+                handler(data, size);
+            else
+                handler(nullptr, 0);
+        };
+
+        ++_inFlight;
+        if (!_client.request(ZEROEQ_GET_MORPHOLOGY, request.path.data(),
+                             request.path.size(), func))
+        {
+            --_inFlight;
+            handler(nullptr, 0);
+        }
+    }
+
+    void _send(Requests&& requests)
+    {
+        std::string paths;
+        for (const auto& request : requests)
+            paths.append(request.path).push_back('\0');
+
+        auto batch = std::make_shared<Requests>(std::move(requests));
+        const auto func = [this, batch](const uint128_t& id, const void* data,
+                                        const size_t size) {
+            --_inFlight;
+            const MorphologyBatchHeader* header =
+                id == ZEROEQ_GET_MORPHOLOGIES
+                    ? binary::getBatchHeader(data, size)
+                    : nullptr;
+            if (!header || header->count != batch->size())
+            {
+                // Retry with single requests. A reply of another type means
+                // the server does not handle batches, so stop sending them.
+                if (id == ZEROEQ_GET_MORPHOLOGIES)
+                    LBWARN << "Invalid batch reply from morphology server"
+                           << std::endl;
+                else if (_batchSize > 1)
+                {
+                    LBINFO << "Morphology server does not support batch "
+                           << "requests" << std::endl;
+                    _batchSize = 1;
+                }
+                for (const auto& request : *batch)
+                    _send(request);
+                return;
+            }
+
+            const auto entries = binary::getBatchEntries(*header);
+            const uint8_t* ptr = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < batch->size(); ++i)
+            {
+                if (entries[i].size > 0)
+                    (*batch)[i].handler(ptr + entries[i].offset,
+                                        entries[i].size);
+                else
+                    (*batch)[i].handler(nullptr, 0);
+            }
+        };
+
+        ++_inFlight;
+        if (!_client.request(ZEROEQ_GET_MORPHOLOGIES, paths.data(),
+                             paths.size(), func))
+        {
+            --_inFlight;
+            for (const auto& request : *batch)
+                request.handler(nullptr, 0);
+        }
+    }
 };
 
 MorphologyZeroEQ::MorphologyZeroEQ(const MorphologyInitData& initData)
     : MorphologyPlugin(initData)
     , _client(_getClient())
 {
-    ClientPtr client = _client; // keep ref for thread-safety
     const std::string path = initData.getURI().getPath();
-    const auto handler = [&](const uint128_t& id, const void* data,
-                             const size_t size) {
-        if (id == 0)
-            LBWARN << "Server could not load morphology" << std::endl;
+    const auto handler = [this, path](const void* data, const size_t size) {
         if (data && size)
         {
             _client->unlock();
-            fromBinary(data, size);
+            if (!fromBinary(data, size))
+                LBWARN << "Invalid morphology data for " << path << std::endl;
             _client->lock();
         }
+        else
+            LBWARN << "Server could not load morphology " << path << std::endl;
         _client.reset();
     };
 
-    if (!client->request(ZEROEQ_GET_MORPHOLOGY, path.data(), path.size(),
-                         handler))
-    {
-        LBTHROW(std::runtime_error("Failed to request morphology data"));
-    }
+    // keep ref, the handler may complete the request synchronously on failure
+    ClientPtr client = _client;
+    client->request(path, handler);
 }
 
 void MorphologyZeroEQ::load()
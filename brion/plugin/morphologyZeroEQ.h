@@ -37,7 +37,10 @@ namespace plugin
  * $ZEROEQ_SERVER_SESSION) and servers specified in $ZEROEQ_SERVERS.
  *
  * The data is requested in the ctor, loaded asynchronously, and synchronized in
- * any read function. Writing data is not yet implemented, but should be
+ * any read function. Requests of all instances using the same server are
+ * pipelined, and paths requested while another request is in flight are
+ * coalesced into one batch request of at most $BRION_MORPHOLOGY_BATCH_SIZE
+ * (default 64) paths. Writing data is not yet implemented, but should be
  * straight-forward by sending a save request in flush().
  */
 class MorphologyZeroEQ : public MorphologyPlugin
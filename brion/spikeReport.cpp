@@ -109,6 +109,12 @@ SpikeReport::SpikeReport(const URI& uri, const GIDSet& ids)
     _impl->plugin->setFilter(ids);
 }
 
+SpikeReport::SpikeReport(const URI& uri, const CompactGIDSet& ids)
+    : SpikeReport(uri, MODE_READ)
+{
+    _impl->plugin->setFilter(ids);
+}
+
 SpikeReport::~SpikeReport()
 {
     if (_impl)
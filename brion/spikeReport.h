@@ -103,6 +103,15 @@ public:
      */
     BRION_API SpikeReport(const URI& uri, const GIDSet& ids);
 
+    /**
+     * Open a report in read mode with a compact subset selection.
+     *
+     * @param uri the report uri
+     * @param ids The set of gids to be reported, see above.
+     * @version 3.0
+     */
+    BRION_API SpikeReport(const URI& uri, const CompactGIDSet& ids);
+
     /**
      * Release all resources.
      * Any pending read/seek tasks will be interrupted and calling
@@ -21,6 +21,7 @@
 #define SPIKEREPORTPLUGIN_H
 
 #include <brion/api.h>
+#include <brion/compactGIDSet.h>
 #include <brion/enums.h>
 #include <brion/pluginInitData.h>
 #include <brion/spikeReport.h>
@@ -140,9 +141,10 @@ public:
     /** @copydoc brion::SpikeReport::supportsBackwardSeek */
     virtual bool supportsBackwardSeek() const = 0;
 
-    void setFilter(const GIDSet& ids)
+    void setFilter(const GIDSet& ids) { setFilter(CompactGIDSet(ids)); }
+    void setFilter(CompactGIDSet ids)
     {
-        _idsSubset = ids;
+        _idsSubset = std::move(ids);
         if (!_idsSubset.empty())
             _pushBackFunction = &SpikeReportPlugin::_pushBackFiltered;
         else
@@ -161,7 +163,7 @@ protected:
                                                            Spikes&) const;
 
     URI _uri;
-    brion::GIDSet _idsSubset;
+    brion::CompactGIDSet _idsSubset;
     int _accessMode = brion::MODE_READ;
     float _currentTime = 0;
     float _endTime = 0;
@@ -195,7 +197,7 @@ private:
 
     void _pushBackFiltered(const Spike& spike, Spikes& spikes) const
     {
-        if (_idsSubset.find(spike.second) != _idsSubset.end())
+        if (_idsSubset.contains(spike.second))
         {
             spikes.push_back(spike);
         }
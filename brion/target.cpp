@@ -18,13 +18,20 @@
  */
 
 #include "target.h"
+#include "compactGIDSet.h"
 
-#include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
-#include <boost/regex.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <fstream>
+#include <limits>
 #include <lunchbox/log.h>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace boost
 {
@@ -45,10 +52,117 @@ namespace brion
 {
 namespace detail
 {
+namespace
+{
+typedef std::shared_ptr<const uint32_ts> GIDsPtr;
+
+/** @return the text without '#' comments up to and including the newline. */
+std::string stripComments(const std::string& text)
+{
+    std::string result;
+    result.reserve(text.size());
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        const size_t comment = text.find('#', pos);
+        const size_t eol =
+            comment == std::string::npos ? comment : text.find('\n', comment);
+        if (eol == std::string::npos)
+        {
+            result.append(text, pos, std::string::npos);
+            break;
+        }
+        result.append(text, pos, comment - pos);
+        pos = eol + 1;
+    }
+    return result;
+}
+
+bool isTypeChar(const char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isSpace(const char c)
+{
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+/** @return the GID of an "a<gid>" value, or 0 if it is a target name. */
+uint32_t toGID(const std::string& value)
+{
+    if (value.size() < 2 || value.size() > 11 || value[0] != 'a')
+        return 0;
+    uint64_t gid = 0;
+    for (size_t i = 1; i < value.size(); ++i)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(value[i])))
+            return 0;
+        gid = gid * 10 + uint64_t(value[i] - '0');
+    }
+    return gid <= std::numeric_limits<uint32_t>::max() ? uint32_t(gid) : 0;
+}
+
+/** Split on spaces and newlines, skipping empty values. */
+Strings splitValues(const std::string& content)
+{
+    Strings values;
+    size_t pos = 0;
+    while (pos < content.size())
+    {
+        const size_t end = content.find_first_of("\n ", pos);
+        const size_t size =
+            (end == std::string::npos ? content.size() : end) - pos;
+        if (size > 0)
+            values.emplace_back(content, pos, size);
+        pos += size + 1;
+    }
+    return values;
+}
+}
+
+/** A target split into its GIDs and the names of its subtargets. */
+struct CompiledTarget
+{
+    uint32_ts gids; //!< sorted
+    Strings targets;
+};
+
+/** Parsed target file, shared between copies of a brion::Target. */
+struct TargetData
+{
+    typedef std::unordered_map<uint32_t, Strings> NameTable;
+    typedef std::unordered_map<std::string, std::string> ContentTable;
+    typedef std::vector<uint64_t> Context; //!< ids of the resolving targets
+
+    /** Unique for the lifetime of the process, unlike the address. */
+    const uint64_t id = _nextID();
+
+    NameTable targetNames;
+    ContentTable contents; //!< trimmed content of each target
+
+    // lazily built from contents, protected by mutex
+    std::mutex mutex;
+    std::unordered_map<std::string, Strings> values;
+    std::unordered_map<std::string, CompiledTarget> compiled;
+
+    /** Flattened GIDs of each target, valid for the targets it was resolved
+     *  against */
+    std::unordered_map<std::string, std::pair<Context, GIDsPtr>> resolved;
+
+private:
+    static uint64_t _nextID()
+    {
+        static std::atomic<uint64_t> counter(0);
+        return ++counter;
+    }
+};
+
 class Target
 {
 public:
     explicit Target(const std::string& source)
+        : _data(std::make_shared<TargetData>())
     {
         std::ifstream file(source.c_str());
         if (!file.is_open())
@@ -56,42 +170,16 @@ public:
         std::stringstream buffer;
         buffer << file.rdbuf();
 
-        boost::regex commentregx("#.*?\\n");
-        const std::string fileString =
-            boost::regex_replace(buffer.str(), commentregx, "");
-
-        boost::regex regx(
-            "Target (?<type>[a-zA-Z0-9_]+) (?<name>.*?)\\s+"
-            "\\{(?<contents>.*?)\\}");
-        const int subs[] = {1, 2, 3};
-        boost::sregex_token_iterator i(fileString.begin(), fileString.end(),
-                                       regx, subs);
-        for (boost::sregex_token_iterator j; i != j;)
-        {
-            const std::string& typeStr = *i++;
-            const std::string& name = *i++;
-            std::string content = *i++;
-
-            const TargetType type = lexical_cast<TargetType>(typeStr);
-            _targetNames[type].push_back(name);
-            boost::trim(content);
-            if (content.empty())
-                _targetValues[name] = Strings();
-            else
-            {
-                boost::split(_targetValues[name], content,
-                             boost::is_any_of("\n "), boost::token_compress_on);
-            }
-        }
-
-        if (_targetNames.empty())
+        _parse(stripComments(buffer.str()));
+        if (_data->targetNames.empty())
             LBTHROW(std::runtime_error(source + " not a valid target file"));
     }
 
     const Strings& getTargetNames(const TargetType type) const
     {
-        NameTable::const_iterator i = _targetNames.find(type);
-        if (i != _targetNames.end())
+        TargetData::NameTable::const_iterator i =
+            _data->targetNames.find(type);
+        if (i != _data->targetNames.end())
             return i->second;
         static Strings empty;
         return empty;
@@ -99,22 +187,190 @@ public:
 
     bool contains(const std::string& name) const
     {
-        return _targetValues.find(name) != _targetValues.end();
+        return _data->contents.find(name) != _data->contents.end();
     }
 
     const Strings& get(const std::string& name) const
     {
-        ValueTable::const_iterator i = _targetValues.find(name);
-        if (i != _targetValues.end())
+        TargetData::ContentTable::const_iterator i =
+            _data->contents.find(name);
+        if (i == _data->contents.end())
+            throw(std::runtime_error(name + " not a valid target"));
+
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        auto value = _data->values.find(name);
+        if (value == _data->values.end())
+            value = _data->values.emplace(name, splitValues(i->second)).first;
+        return value->second;
+    }
+
+    const CompiledTarget& compile(const std::string& name) const
+    {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        auto i = _data->compiled.find(name);
+        if (i != _data->compiled.end())
             return i->second;
-        throw(std::runtime_error(name + " not a valid target"));
+
+        CompiledTarget target;
+        for (std::string& value : splitValues(_data->contents.at(name)))
+        {
+            const uint32_t gid = toGID(value);
+            if (gid)
+                target.gids.push_back(gid);
+            else
+                target.targets.push_back(std::move(value));
+        }
+        std::sort(target.gids.begin(), target.gids.end());
+        return _data->compiled.emplace(name, std::move(target)).first->second;
     }
 
+    TargetData& getData() const { return *_data; }
 private:
-    typedef std::unordered_map<uint32_t, Strings> NameTable;
-    typedef std::unordered_map<std::string, Strings> ValueTable;
-    NameTable _targetNames;
-    ValueTable _targetValues;
+    std::shared_ptr<TargetData> _data;
+
+    /**
+     * Find all "Target <type> <name> { <content> }" blocks in one pass, with
+     * the semantics of the former regular expression
+     * "Target ([a-zA-Z0-9_]+) (.*?)\s+\{(.*?)\}".
+     */
+    void _parse(const std::string& text)
+    {
+        static const std::string keyword("Target ");
+        size_t pos = 0;
+        while ((pos = text.find(keyword, pos)) != std::string::npos)
+        {
+            const size_t typeStart = pos + keyword.size();
+            size_t typeEnd = typeStart;
+            while (typeEnd < text.size() && isTypeChar(text[typeEnd]))
+                ++typeEnd;
+            if (typeEnd == typeStart || typeEnd == text.size() ||
+                text[typeEnd] != ' ')
+            {
+                ++pos;
+                continue;
+            }
+
+            // the name ends at the first whitespace before an opening brace
+            const size_t nameStart = typeEnd + 1;
+            size_t open = nameStart;
+            size_t nameEnd = open;
+            while ((open = text.find('{', open)) != std::string::npos)
+            {
+                nameEnd = open;
+                while (nameEnd > nameStart && isSpace(text[nameEnd - 1]))
+                    --nameEnd;
+                if (nameEnd < open)
+                    break;
+                ++open;
+            }
+            if (open == std::string::npos)
+                return;
+            const size_t close = text.find('}', open);
+            if (close == std::string::npos)
+                return;
+
+            const std::string name(text, nameStart, nameEnd - nameStart);
+            const TargetType type = lexical_cast<TargetType>(
+                text.substr(typeStart, typeEnd - typeStart));
+            _data->targetNames[type].push_back(name);
+
+            size_t contentStart = open + 1;
+            size_t contentEnd = close;
+            while (contentStart < contentEnd && isSpace(text[contentStart]))
+                ++contentStart;
+            while (contentEnd > contentStart && isSpace(text[contentEnd - 1]))
+                --contentEnd;
+            _data->contents[name] =
+                text.substr(contentStart, contentEnd - contentStart);
+            pos = close + 1;
+        }
+    }
+};
+
+/** Resolves target names to flat GID arrays against a list of targets. */
+class TargetResolver
+{
+public:
+    TargetResolver(const Targets& targets, const std::string& root)
+        : _root(root)
+    {
+        for (const brion::Target& target : targets)
+            _targets.push_back(&target);
+        for (const brion::Target* target : _targets)
+            _context.push_back(_getImpl(*target).getData().id);
+    }
+
+    GIDsPtr resolve(const std::string& name)
+    {
+        const uint32_t gid = toGID(name);
+        if (gid)
+            return std::make_shared<uint32_ts>(1, gid);
+
+        auto i = _resolved.find(name);
+        if (i != _resolved.end())
+            return i->second;
+
+        const brion::Target* owner = nullptr;
+        for (const brion::Target* target : _targets)
+        {
+            if (target->contains(name))
+            {
+                owner = target;
+                break;
+            }
+        }
+        if (!owner)
+            LBTHROW(std::runtime_error("Parse " + _root + " failed: " + name +
+                                       " is not a valid or known target"));
+
+        const Target& impl = _getImpl(*owner);
+        TargetData& data = impl.getData();
+        {
+            std::lock_guard<std::mutex> lock(data.mutex);
+            auto cached = data.resolved.find(name);
+            if (cached != data.resolved.end() &&
+                cached->second.first == _context)
+            {
+                return _resolved[name] = cached->second.second;
+            }
+        }
+
+        if (!_pending.insert(name).second)
+            LBTHROW(std::runtime_error("Parse " + _root + " failed: " + name +
+                                       " contains itself"));
+
+        const CompiledTarget& target = impl.compile(name);
+        GIDsPtr gids;
+        if (target.targets.empty())
+            gids = std::make_shared<uint32_ts>(target.gids);
+        else
+        {
+            std::shared_ptr<uint32_ts> merged(new uint32_ts(target.gids));
+            for (const std::string& subtarget : target.targets)
+            {
+                const GIDsPtr sub = resolve(subtarget);
+                merged->insert(merged->end(), sub->begin(), sub->end());
+            }
+            std::sort(merged->begin(), merged->end());
+            merged->erase(std::unique(merged->begin(), merged->end()),
+                          merged->end());
+            gids = merged;
+        }
+        _pending.erase(name);
+
+        std::lock_guard<std::mutex> lock(data.mutex);
+        data.resolved[name] = std::make_pair(_context, gids);
+        return _resolved[name] = gids;
+    }
+
+private:
+    const std::string& _root;
+    std::vector<const brion::Target*> _targets;
+    TargetData::Context _context;
+    std::unordered_map<std::string, GIDsPtr> _resolved;
+    std::unordered_set<std::string> _pending;
+
+    static const Target& _getImpl(const brion::Target& target);
 };
 }
 
@@ -158,47 +414,32 @@ const Strings& Target::get(const std::string& name) const
     return _impl->get(name);
 }
 
-GIDSet Target::parse(const Targets& targets, const std::string& root)
+namespace
+{
+detail::GIDsPtr _resolve(const Targets& targets, const std::string& root)
 {
     if (root.empty())
         LBTHROW(std::runtime_error("Empty target name"));
+    return detail::TargetResolver(targets, root).resolve(root);
+}
+}
 
-    GIDSet gids;
-    Strings names(1, root);
-    while (!names.empty())
-    {
-        const std::string name = names.back();
-        names.pop_back();
-
-        if (name[0] == 'a') // maybe a GID
-        {
-            try
-            {
-                gids.insert(lexical_cast<uint32_t>(name.substr(1)));
-                continue;
-            }
-            catch (const boost::bad_lexical_cast&)
-            {
-            } // not a GID
-        }
-
-        bool found = false;
-        for (const Target& target : targets)
-        {
-            if (!target.contains(name))
-                continue;
+GIDSet Target::parse(const Targets& targets, const std::string& root)
+{
+    const detail::GIDsPtr gids = _resolve(targets, root);
+    return GIDSet(gids->begin(), gids->end());
+}
 
-            const brion::Strings& values = target.get(name);
-            std::copy(values.begin(), values.end(), std::back_inserter(names));
-            found = true;
-            break;
-        }
-        if (!found)
-            LBTHROW(std::runtime_error("Parse " + root + " failed: " + name +
-                                       " is not a valid or known target"));
-    }
+CompactGIDSet Target::parseCompact(const Targets& targets,
+                                   const std::string& root)
+{
+    return CompactGIDSet(*_resolve(targets, root));
+}
 
-    return gids;
+const detail::Target& detail::TargetResolver::_getImpl(
+    const brion::Target& target)
+{
+    return *target._impl;
 }
 
 std::ostream& operator<<(std::ostream& os, const Target& target)
@@ -28,6 +28,7 @@ namespace brion
 namespace detail
 {
 class Target;
+class TargetResolver;
 }
 
 /** Read access to a Target file.
@@ -83,20 +84,39 @@ public:
      * All given targets are searched for the given name. If found, the named
      * target is recursively resolved to a GID set.
      * Empty targets are valid, i.e., does not throw when an empty target is
-     * found.
+     * found. Resolved targets are flattened into sorted GID arrays which are
+     * cached per name, so parsing the same target again against the same
+     * target files only copies the result.
      *
      * @param targets the targets to parse
      * @param name the target name to parse
      * @return the set of cell identifiers parsed
-     * @throw std::runtime_error if a non-existent (sub)target is given.
+     * @throw std::runtime_error if a non-existent (sub)target is given, or if
+     *        a target contains itself.
      * @version 1.6
      */
     BRION_API static GIDSet parse(const Targets& targets,
                                   const std::string& name);
+
+    /**
+     * Parse a given target into a compact GID set.
+     *
+     * Same as parse(), without building the tree nodes of a GIDSet.
+     *
+     * @param targets the targets to parse
+     * @param name the target name to parse
+     * @return the set of cell identifiers parsed
+     * @throw std::runtime_error if a non-existent (sub)target is given, or if
+     *        a target contains itself.
+     * @version 3.0
+     */
+    BRION_API static CompactGIDSet parseCompact(const Targets& targets,
+                                                const std::string& name);
     //@}
 
 private:
     friend std::ostream& operator<<(std::ostream&, const Target&);
+    friend class detail::TargetResolver;
 
     detail::Target* _impl;
 };
@@ -23,6 +23,7 @@
 #include <brion/enums.h>
 
 #include <boost/multi_array.hpp>
+#include <functional>
 #include <map>
 #include <servus/uri.h>
 #include <set>
@@ -44,11 +45,16 @@ namespace brion
 using namespace enums;
 class BlueConfig;
 class Circuit;
+class CompactGIDSet;
 class CompartmentReport;
 class CompartmentReportPlugin;
 class Mesh;
+struct MeshLoadOptions;
 class Morphology;
 class MorphologyInitData;
+struct MorphologyLoadOptions;
+struct MorphologyLOD;
+class MorphologyPlugin;
 class SpikeReport;
 class SpikeReportPlugin;
 class Synapse;
@@ -88,6 +94,10 @@ typedef std::shared_ptr<Vector4ds> Vector4dsPtr;
 
 using MorphologyPtr = std::shared_ptr<Morphology>;
 using ConstMorphologyPtr = std::shared_ptr<const Morphology>;
+using Morphologies = std::vector<MorphologyPtr>;
+using MorphologyLoadedFunc = std::function<void(size_t, MorphologyPtr)>;
+using MeshPtr = std::shared_ptr<Mesh>;
+using Meshes = std::vector<MeshPtr>;
 
 /** Ordered set of GIDs of neurons. */
 typedef std::set<uint32_t> GIDSet;
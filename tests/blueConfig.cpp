@@ -22,9 +22,12 @@
 #include <brion/brion.h>
 
 #define BOOST_TEST_MODULE BlueConfig
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <fstream>
+
 BOOST_AUTO_TEST_CASE(invalid_open)
 {
     BOOST_CHECK_THROW(brion::BlueConfig("/bla"), std::runtime_error);
@@ -219,3 +222,51 @@ BOOST_AUTO_TEST_CASE(parse_target)
 
     BOOST_CHECK_THROW(config.parseTarget("unexistent"), std::runtime_error);
 }
+
+BOOST_AUTO_TEST_CASE(parse_syntax)
+{
+    const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("%%%%-%%%%-%%%%.BlueConfig");
+    {
+        std::ofstream file(path.string());
+        file << "# Run Commented { Key value } \n"
+                "Run Default # trailing\n{\n"
+                "  CircuitPath /circuit  # trailing\n"
+                "  Dt   0.025 \n"
+                "  Invalid\n"
+                "  CircuitPath /ignored\n}\n"
+                "Report soma { Format Bin }\n"
+                "Unknown section\n{\n Key value\n}\n"
+                "Report empty {}\n";
+    }
+    const brion::BlueConfig config(path.string());
+    const brion::Strings& runs =
+        config.getSectionNames(brion::CONFIGSECTION_RUN);
+    BOOST_REQUIRE_EQUAL(runs.size(), 1);
+    BOOST_CHECK_EQUAL(runs[0], "Default");
+    BOOST_CHECK_EQUAL(config.get(brion::CONFIGSECTION_RUN, "Default",
+                                 "CircuitPath"),
+                      "/circuit");
+    BOOST_CHECK_EQUAL(config.getTimestep(), 0.025f);
+    BOOST_CHECK(config.getSectionNames(brion::CONFIGSECTION_REPORT) ==
+                brion::Strings{"soma"});
+    BOOST_CHECK_EQUAL(config.get(brion::CONFIGSECTION_REPORT, "soma",
+                                 "Format"),
+                      "Bin");
+
+    // Files are parsed again once modified. Both writes may happen within
+    // the same second of modification time, so the test relies on the
+    // different file sizes to detect the rewrite.
+    {
+        std::ofstream file(path.string());
+        file << "Run Modified\n{\n  Dt 0.1\n}\n";
+    }
+    const brion::BlueConfig modified(path.string());
+    BOOST_CHECK(modified.getSectionNames(brion::CONFIGSECTION_RUN) ==
+                brion::Strings{"Modified"});
+    BOOST_CHECK_EQUAL(modified.getTimestep(), 0.1f);
+    BOOST_CHECK_EQUAL(runs[0], "Default");
+
+    boost::filesystem::remove(path);
+}
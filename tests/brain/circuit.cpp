@@ -27,6 +27,10 @@
 #include <boost/test/unit_test.hpp>
 #include <lunchbox/bitOperation.h>
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+
 namespace
 {
 std::string getValue(const brion::NeuronMatrix& data, const size_t idx,
@@ -93,6 +97,52 @@ BOOST_AUTO_TEST_CASE(test_some_attributes)
     BOOST_CHECK_EQUAL(data[1][1], "3");
 }
 
+BOOST_AUTO_TEST_CASE(test_typed_attributes)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= "local/circuits/circuit.mvd2";
+
+    const brion::Circuit circuit(path.string());
+    const brion::NeuronMatrix& data =
+        circuit.get(brion::GIDSet(), brion::NEURON_ALL_ATTRIBUTES);
+    const brion::Vector3fs& positions = circuit.getPositions(brion::GIDSet());
+    const brion::floats& rotations = circuit.getRotations(brion::GIDSet());
+    const brion::size_ts& mtypes = circuit.getMTypes(brion::GIDSet());
+    const brion::size_ts& etypes = circuit.getETypes(brion::GIDSet());
+    const brion::Strings& names = circuit.getMorphologyNames(brion::GIDSet());
+    BOOST_REQUIRE_EQUAL(positions.size(), 10);
+    BOOST_REQUIRE_EQUAL(rotations.size(), 10);
+    BOOST_REQUIRE_EQUAL(mtypes.size(), 10);
+    BOOST_REQUIRE_EQUAL(etypes.size(), 10);
+    BOOST_REQUIRE_EQUAL(names.size(), 10);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+        BOOST_CHECK_EQUAL(names[i],
+                          getValue(data, i, brion::NEURON_MORPHOLOGY_NAME));
+        BOOST_CHECK_EQUAL(std::to_string(mtypes[i]),
+                          getValue(data, i, brion::NEURON_MTYPE));
+        BOOST_CHECK_EQUAL(std::to_string(etypes[i]),
+                          getValue(data, i, brion::NEURON_ETYPE));
+        BOOST_CHECK_CLOSE(positions[i][1],
+                          std::stof(getValue(data, i,
+                                             brion::NEURON_POSITION_Y)),
+                          0.0001f);
+        BOOST_CHECK_CLOSE(rotations[i],
+                          std::stof(getValue(data, i, brion::NEURON_ROTATION)),
+                          0.0001f);
+    }
+    BOOST_CHECK_CLOSE(positions[7][1], 399.305168f, 0.0001f);
+
+    const brion::GIDSet gids{4, 6};
+    const brion::Strings& someNames = circuit.getMorphologyNames(gids);
+    BOOST_REQUIRE_EQUAL(someNames.size(), 2);
+    BOOST_CHECK_EQUAL(someNames[0], "L2PC32_2");
+    BOOST_CHECK_EQUAL(someNames[1], "R-C010600A2");
+    BOOST_CHECK_EQUAL(circuit.getETypes(gids)[1], 3);
+    BOOST_CHECK_THROW(circuit.getPositions({11}), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(test_types)
 {
     boost::filesystem::path path(BBP_TESTDATA);
@@ -144,6 +194,34 @@ BOOST_AUTO_TEST_CASE(brain_circuit_constructor)
     BOOST_CHECK_THROW(brain::Circuit(brion::URI("pluto")), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(brain_circuit_stats)
+{
+    const brain::Circuit circuit((brion::URI(bbp::test::getBlueconfig())));
+    brain::Circuit::Stats stats = circuit.getStats();
+    // a BlueConfig already parsed by this process costs only a file stat
+    BOOST_CHECK_GE(stats.configParse, 0.);
+    BOOST_CHECK_EQUAL(stats.circuitOpen, 0.);
+    BOOST_CHECK_EQUAL(stats.targetParse, 0.);
+    BOOST_CHECK_EQUAL(stats.synapseOpen, 0.);
+
+    // resources are opened and timed on first use
+    circuit.getGIDs("Layer1");
+    circuit.getNumNeurons();
+    stats = circuit.getStats();
+    BOOST_CHECK_GT(stats.circuitOpen, 0.);
+    BOOST_CHECK_GT(stats.targetParse, 0.);
+    BOOST_CHECK_EQUAL(stats.synapseOpen, 0.);
+
+    circuit.getGIDs("Column");
+    circuit.getNumNeurons();
+    BOOST_CHECK_EQUAL(circuit.getStats().circuitOpen, stats.circuitOpen);
+    BOOST_CHECK_EQUAL(circuit.getStats().targetParse, stats.targetParse);
+
+    const brain::Circuit fromConfig(
+        (brion::BlueConfig(bbp::test::getBlueconfig())));
+    BOOST_CHECK_EQUAL(fromConfig.getStats().configParse, 0.);
+}
+
 BOOST_AUTO_TEST_CASE(brain_circuit_target)
 {
     const brain::Circuit circuit((brion::URI(bbp::test::getBlueconfig())));
@@ -188,6 +266,104 @@ BOOST_AUTO_TEST_CASE(brain_circuit_positions)
         0.000001f);
 }
 
+BOOST_AUTO_TEST_CASE(brain_circuit_attribute_cache)
+{
+    const brain::Circuit reference((brion::URI(bbp::test::getBlueconfig())));
+    brain::Circuit circuit((brion::URI(bbp::test::getBlueconfig())));
+    circuit.enableAttributeCache();
+
+    const brion::GIDSet gids{1, 2, 7, 100, 1000};
+    for (size_t i = 0; i < 2; ++i) // first load, then cached
+    {
+        BOOST_CHECK(circuit.getPositions(gids) == reference.getPositions(gids));
+        BOOST_CHECK(circuit.getRotations(gids) == reference.getRotations(gids));
+        BOOST_CHECK(circuit.getMorphologyTypes(gids) ==
+                    reference.getMorphologyTypes(gids));
+        BOOST_CHECK(circuit.getElectrophysiologyTypes(gids) ==
+                    reference.getElectrophysiologyTypes(gids));
+        BOOST_CHECK(circuit.getMorphologyURIs(gids) ==
+                    reference.getMorphologyURIs(gids));
+        BOOST_CHECK(circuit.getTransforms(gids) ==
+                    reference.getTransforms(gids));
+    }
+    BOOST_CHECK(circuit.getPositions(brion::GIDSet()).empty());
+    BOOST_CHECK_THROW(circuit.getPositions({0}), std::runtime_error);
+    BOOST_CHECK_THROW(circuit.getRotations({10000000}), std::runtime_error);
+
+    brain::Circuit preloaded((brion::URI(bbp::test::getBlueconfig())));
+    preloaded.enableAttributeCache(true);
+    BOOST_CHECK(preloaded.getPositions(preloaded.getGIDs()) ==
+                reference.getPositions(reference.getGIDs()));
+}
+
+BOOST_AUTO_TEST_CASE(brain_circuit_compact_gids)
+{
+    brain::Circuit circuit((brion::URI(bbp::test::getBlueconfig())));
+
+    const brion::GIDSet layer = circuit.getGIDs("Layer1");
+    const brion::CompactGIDSet compactLayer = circuit.getCompactGIDs("Layer1");
+    BOOST_CHECK(compactLayer.toGIDSet() == layer);
+    BOOST_CHECK(circuit.getCompactGIDs().toGIDSet() == circuit.getGIDs());
+    BOOST_CHECK_THROW(circuit.getCompactGIDs("!ThisIsAnInvalidTarget!"),
+                      std::runtime_error);
+
+    const brion::GIDSet gids{1, 2, 7, 100, 1000};
+    const brion::CompactGIDSet compact(gids);
+    for (size_t i = 0; i < 2; ++i) // from file, then from the cache
+    {
+        BOOST_CHECK(circuit.getPositions(compact) ==
+                    circuit.getPositions(gids));
+        BOOST_CHECK(circuit.getRotations(compact) ==
+                    circuit.getRotations(gids));
+        BOOST_CHECK(circuit.getTransforms(compact) ==
+                    circuit.getTransforms(gids));
+        BOOST_CHECK(circuit.getMorphologyTypes(compact) ==
+                    circuit.getMorphologyTypes(gids));
+        BOOST_CHECK(circuit.getElectrophysiologyTypes(compact) ==
+                    circuit.getElectrophysiologyTypes(gids));
+        circuit.enableAttributeCache();
+    }
+    BOOST_CHECK(circuit.getPositions(brion::CompactGIDSet()).empty());
+    BOOST_CHECK_THROW(circuit.getPositions(
+                          brion::CompactGIDSet(brion::uint32_ts{10000000})),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(brain_circuit_spatial_queries)
+{
+    const brain::Circuit circuit((brion::URI(bbp::test::getBlueconfig())));
+    const brain::GIDSet& all = circuit.getGIDs();
+    const brain::Vector3fs& positions = circuit.getPositions(all);
+    const brain::Vector3f center = positions[positions.size() / 2];
+
+    brain::GIDSet inBox, inSphere;
+    std::vector<std::pair<float, uint32_t>> distances;
+    const brain::AABBf box(center - brain::Vector3f(100.f),
+                           center + brain::Vector3f(100.f));
+    uint32_t gid = 1;
+    for (const auto& position : positions)
+    {
+        const float distance = (position - center).length();
+        if (box.isIn(position))
+            inBox.insert(gid);
+        if (distance <= 100.f)
+            inSphere.insert(gid);
+        distances.emplace_back(distance, gid++);
+    }
+    std::sort(distances.begin(), distances.end());
+    brain::GIDSet nearest;
+    for (size_t i = 0; i < 10; ++i)
+        nearest.insert(distances[i].second);
+
+    BOOST_CHECK(!inSphere.empty());
+    BOOST_CHECK(circuit.getGIDsInBox(box) == inBox);
+    BOOST_CHECK(circuit.getGIDsInSphere(center, 100.f) == inSphere);
+    BOOST_CHECK(circuit.getNearestGIDs(center, 10) == nearest);
+    BOOST_CHECK(circuit.getNearestGIDs(center, 0).empty());
+    BOOST_CHECK(circuit.getNearestGIDs(center, all.size() + 1) == all);
+    BOOST_CHECK(circuit.getGIDsInSphere(center, -1.f).empty());
+}
+
 namespace
 {
 void _checkMorphology(const brain::neuron::Morphology& morphology,
@@ -360,6 +536,67 @@ BOOST_AUTO_TEST_CASE(partial_mvd3)
         0.00001f));
 }
 
+BOOST_AUTO_TEST_CASE(affine_transforms_mvd3)
+{
+    brion::BlueConfig config(BBP_TEST_BLUECONFIG3);
+    brain::Circuit circuit(config);
+    const brion::GIDSet& gids = circuit.getGIDs();
+
+    const brain::Vector3fs& positions = circuit.getPositions(gids);
+    const brain::Quaternionfs& rotations = circuit.getRotations(gids);
+    const brain::Matrix4fs& transforms = circuit.getTransforms(gids);
+    const brain::Matrix3x4fs& affine = circuit.getAffineTransforms(gids);
+    BOOST_REQUIRE_EQUAL(transforms.size(), gids.size());
+    BOOST_REQUIRE_EQUAL(affine.size(), gids.size());
+
+    for (size_t i = 0; i < gids.size(); ++i)
+    {
+        const brain::Matrix4f expected(rotations[i], positions[i]);
+        BOOST_CHECK(transforms[i].equals(expected, 0.00001f));
+        for (size_t row = 0; row < 3; ++row)
+            for (size_t col = 0; col < 4; ++col)
+                BOOST_CHECK_SMALL(affine[i](row, col) - expected(row, col),
+                                  0.00001f);
+    }
+
+    BOOST_CHECK(circuit.getAffineTransforms(brion::GIDSet()).empty());
+    BOOST_CHECK(circuit.getAffineTransforms(circuit.getCompactGIDs()) ==
+                affine);
+}
+
+BOOST_AUTO_TEST_CASE(sparse_mvd3)
+{
+    brion::BlueConfig config(BBP_TEST_BLUECONFIG3);
+    brain::Circuit circuit(config);
+
+    // runs far enough apart to be read separately
+    const uint32_t numNeurons = uint32_t(circuit.getNumNeurons());
+    const brion::GIDSet gids{1, 2, 3, numNeurons / 2, numNeurons / 2 + 1,
+                             numNeurons - 1, numNeurons};
+    const brain::Vector3fs& all = circuit.getPositions(circuit.getGIDs());
+    const brain::size_ts& allMTypes =
+        circuit.getMorphologyTypes(circuit.getGIDs());
+    const brain::URIs& allNames = circuit.getMorphologyURIs(circuit.getGIDs());
+
+    const brain::Vector3fs& positions = circuit.getPositions(gids);
+    const brain::size_ts& mtypes = circuit.getMorphologyTypes(gids);
+    const brain::URIs& names = circuit.getMorphologyURIs(gids);
+    BOOST_REQUIRE_EQUAL(positions.size(), gids.size());
+    BOOST_REQUIRE_EQUAL(mtypes.size(), gids.size());
+    BOOST_REQUIRE_EQUAL(names.size(), gids.size());
+
+    size_t i = 0;
+    for (const uint32_t gid : gids)
+    {
+        BOOST_CHECK_EQUAL(positions[i], all[gid - 1]);
+        BOOST_CHECK_EQUAL(mtypes[i], allMTypes[gid - 1]);
+        BOOST_CHECK_EQUAL(std::to_string(names[i]),
+                          std::to_string(allNames[gid - 1]));
+        ++i;
+    }
+    BOOST_CHECK(circuit.getPositions(brion::GIDSet()).empty());
+}
+
 BOOST_AUTO_TEST_CASE(morphology_names_mvd3)
 {
     brion::BlueConfig config(BBP_TEST_BLUECONFIG3);
@@ -442,6 +679,59 @@ BOOST_AUTO_TEST_CASE(brain_circuit_random_gids)
 
     BOOST_CHECK_THROW(circuit.getRandomGIDs(-5.f), std::runtime_error);
     BOOST_CHECK_THROW(circuit.getRandomGIDs(1.1f), std::runtime_error);
+
+    BOOST_CHECK_EQUAL(circuit.getRandomGIDs(1.f).size(), 1000);
+    BOOST_CHECK_EQUAL(circuit.getRandomGIDs(0.9f).size(), 900);
+    BOOST_CHECK(circuit.getRandomGIDs(0.f).empty());
+
+    ::setenv("BRAIN_CIRCUIT_SEED", "42", 1);
+    BOOST_CHECK(circuit.getRandomGIDs(0.1f) == circuit.getRandomGIDs(0.1f));
+    BOOST_CHECK(circuit.getStratifiedRandomGIDs(
+                    0.1f, brain::Circuit::Stratification::morphologyType) ==
+                circuit.getStratifiedRandomGIDs(
+                    0.1f, brain::Circuit::Stratification::morphologyType));
+    ::unsetenv("BRAIN_CIRCUIT_SEED");
+}
+
+BOOST_AUTO_TEST_CASE(brain_circuit_stratified_random_gids)
+{
+    const brain::Circuit circuit(brion::URI(BBP_TEST_BLUECONFIG3));
+    const brain::GIDSet& all = circuit.getGIDs();
+    const brain::size_ts& allMTypes = circuit.getMorphologyTypes(all);
+    std::map<size_t, size_t> counts;
+    for (const size_t mtype : allMTypes)
+        ++counts[mtype];
+
+    const brain::GIDSet& gids = circuit.getStratifiedRandomGIDs(
+        0.1f, brain::Circuit::Stratification::morphologyType);
+    std::map<size_t, size_t> sampled;
+    for (const size_t mtype : circuit.getMorphologyTypes(gids))
+        ++sampled[mtype];
+
+    BOOST_CHECK_EQUAL(sampled.size(), counts.size());
+    for (const auto& count : counts)
+        BOOST_CHECK_EQUAL(sampled[count.first],
+                          size_t(std::ceil(count.second * 0.1f)));
+
+    const brain::GIDSet& layer = circuit.getGIDs("Layer1");
+    const brain::GIDSet& layerGIDs = circuit.getStratifiedRandomGIDs(
+        0.5f, brain::Circuit::Stratification::electrophysiologyType,
+        "Layer1");
+    BOOST_CHECK(std::includes(layer.begin(), layer.end(), layerGIDs.begin(),
+                              layerGIDs.end()));
+
+    const brain::GIDSet& targetGIDs =
+        circuit.getStratifiedRandomGIDs(0.5f, brion::Strings{"Layer1"});
+    BOOST_CHECK_EQUAL(targetGIDs.size(), 10);
+    BOOST_CHECK(std::includes(layer.begin(), layer.end(), targetGIDs.begin(),
+                              targetGIDs.end()));
+
+    BOOST_CHECK_THROW(circuit.getStratifiedRandomGIDs(
+                          2.f, brain::Circuit::Stratification::morphologyType),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(circuit.getStratifiedRandomGIDs(
+                          0.5f, brion::Strings{"!ThisIsAnInvalidTarget!"}),
+                      std::runtime_error);
 }
 
 #endif // BRAIN_USE_MVD3
@@ -237,6 +237,18 @@ BOOST_AUTO_TEST_CASE(get_section_distances_to_soma)
     }
 }
 
+BOOST_AUTO_TEST_CASE(get_section_branch_orders)
+{
+    brain::neuron::Morphology morphology(TEST_MORPHOLOGY_URI);
+
+    for (const uint32_t section : {1, 4, 7, 10})
+    {
+        BOOST_CHECK_EQUAL(morphology.getSection(section).getBranchOrder(), 1);
+        for (const auto& child : morphology.getSection(section).getChildren())
+            BOOST_CHECK_EQUAL(child.getBranchOrder(), 2);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(get_soma_geometry)
 {
     brain::neuron::Morphology morphology(TEST_MORPHOLOGY_URI);
@@ -284,6 +296,70 @@ BOOST_AUTO_TEST_CASE(get_section_samples_by_positions)
                       V4f(0, 3, 3, .56), V4f(0, 4, 4, .58), V4f(0, 5, 5, .6)});
 }
 
+BOOST_AUTO_TEST_CASE(get_samples_batch)
+{
+    brain::neuron::Morphology morphology(TEST_MORPHOLOGY_URI);
+
+    const brion::floats positions = {-1.f, 0.f, .1f, .25f, .5f, .99f, 1.f, 2.f};
+    brion::uint32_ts sectionIDs;
+    brion::floats points;
+    for (const uint32_t id : morphology.getSectionIDs(
+             {brain::neuron::SectionType::axon,
+              brain::neuron::SectionType::dendrite,
+              brain::neuron::SectionType::apicalDendrite}))
+    {
+        for (const float position : positions)
+        {
+            sectionIDs.push_back(id);
+            points.push_back(position);
+        }
+    }
+
+    const size_t size = sectionIDs.size();
+    brion::floats x(size), y(size), z(size), diameters(size);
+    morphology.getSamples(sectionIDs, points, x.data(), y.data(), z.data(),
+                          diameters.data());
+
+    for (size_t i = 0; i != size; ++i)
+    {
+        const V4f expected =
+            morphology.getSection(sectionIDs[i]).getSamples({points[i]})[0];
+        BOOST_CHECK_EQUAL(V4f(x[i], y[i], z[i], diameters[i]), expected);
+    }
+
+    // Unsorted and mixed sections against hand-computed samples: section 1
+    // runs from (0, 0, 0) to (0, -5, 5) with non-uniform point spacing,
+    // section 2 from (0, -5, 5) to (-2, -5, 5) and section 4 from (0, 0, 0)
+    // to (5, 0, 5). Positions outside [0, 1] are clamped.
+    const brion::uint32_ts mixedIDs = {4, 2, 1, 1, 2, 4, 1, 1, 2};
+    const brion::floats mixedPoints = {.5f, 1.f, 0.f, .5f, -1.f,
+                                       2.f, 1.f, -1.f, 2.f};
+    const size_t mixedSize = mixedIDs.size();
+    x.resize(mixedSize);
+    y.resize(mixedSize);
+    z.resize(mixedSize);
+    diameters.resize(mixedSize);
+    morphology.getSamples(mixedIDs, mixedPoints, x.data(), y.data(), z.data(),
+                          diameters.data());
+
+    brion::Vector4fs samples;
+    for (size_t i = 0; i != mixedSize; ++i)
+        samples.push_back(V4f(x[i], y[i], z[i], diameters[i]));
+    checkCloseArrays(samples,
+                     {V4f(2.5, 0, 2.5, .55), V4f(-2, -5, 5, .7),
+                      V4f(0, 0, 0, .5), V4f(0, -2.5, 2.5, .55),
+                      V4f(0, -5, 5, .6), V4f(5, 0, 5, .6), V4f(0, -5, 5, .6),
+                      V4f(0, 0, 0, .5), V4f(-2, -5, 5, .7)});
+
+    float dummy;
+    BOOST_CHECK_THROW(morphology.getSamples({1, 2}, {.5f}, &dummy, &dummy,
+                                            &dummy, &dummy),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(morphology.getSamples({0}, {.5f}, &dummy, &dummy,
+                                            &dummy, &dummy),
+                      std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(morphology_hierarchy)
 {
     brain::neuron::Morphology morphology(TEST_MORPHOLOGY_URI);
@@ -302,6 +378,8 @@ BOOST_AUTO_TEST_CASE(morphology_hierarchy)
     checkEqualArrays(getSectionIDs(morphology.getSection(4).getChildren()),
                      {5, 6});
     BOOST_CHECK(morphology.getSection(5).getChildren().empty());
+    BOOST_CHECK_EQUAL(morphology.getSection(1).getNumChildren(), 2);
+    BOOST_CHECK_EQUAL(morphology.getSection(5).getNumChildren(), 0);
 }
 
 BOOST_AUTO_TEST_CASE(transform_with_matrix)
@@ -322,3 +400,136 @@ BOOST_AUTO_TEST_CASE(transform_with_matrix)
                               {V4f(2., .1, .0, .1), V4f(1.9, .0, .0, .1),
                                V4f(2., -.1, .0, .1), V4f(2.1, .0, .0, .1)});
 }
+
+BOOST_AUTO_TEST_CASE(transform_shared_morphology)
+{
+    brain::Matrix4f matrix;
+    matrix.rotate_z(M_PI * 0.5);
+    matrix.setTranslation(V3f(2, 0, 0));
+
+    const brion::ConstMorphologyPtr source(
+        new brion::Morphology(TEST_MORPHOLOGY_URI));
+    const brion::Vector4fs original = source->getPoints();
+
+    brain::neuron::Morphology first(source, matrix);
+    brain::neuron::Morphology second(source, brain::Matrix4f());
+    const brain::neuron::Morphology reference(TEST_MORPHOLOGY_URI, matrix);
+
+    // the source is shared and stays untransformed
+    BOOST_CHECK(source->getPoints() == original);
+    BOOST_CHECK(first.getSections() == source->getSections());
+    BOOST_CHECK_EQUAL(first.getTransformation(), matrix);
+
+    checkCloseArrays(first.getPoints(), reference.getPoints());
+    checkCloseArrays(second.getPoints(), original);
+    BOOST_CHECK_CLOSE(first.getSection(1).getLength(),
+                      reference.getSection(1).getLength(), 1e-5);
+    BOOST_CHECK(source->getPoints() == original);
+}
+
+BOOST_AUTO_TEST_CASE(spatial_queries)
+{
+    brain::neuron::Morphology morphology(TEST_MORPHOLOGY_URI);
+
+    // Section 1 goes from the origin to (0, -5, 5), its segment 7 from
+    // (0, -2.45, 2.45) to (0, -3.2, 3.2) with a maximum diameter of 0.564.
+    const float radius = .564f / 2;
+
+    const auto nearest = morphology.getNearestSegment(V3f(0, -3.8, 1.8));
+    BOOST_CHECK_EQUAL(nearest.section, 1);
+    BOOST_CHECK_EQUAL(nearest.segment, 7);
+    BOOST_CHECK_CLOSE(nearest.distance, std::sqrt(2.f) - radius, 1e-4);
+
+    const auto rayHits =
+        morphology.intersectRay(V3f(10, -2.8, 2.8), V3f(-2, 0, 0));
+    BOOST_REQUIRE_EQUAL(rayHits.size(), 1);
+    BOOST_CHECK_EQUAL(rayHits[0].section, 1);
+    BOOST_CHECK_EQUAL(rayHits[0].segment, 7);
+    BOOST_CHECK_CLOSE(rayHits[0].distance, 10 - radius, 1e-4);
+    BOOST_CHECK(
+        morphology.intersectRay(V3f(10, -2.8, 2.8), V3f(1, 0, 0)).empty());
+
+    const auto boxHits = morphology.intersectBox(
+        brain::AABBf(V3f(-.1, -2.9, 2.7), V3f(.1, -2.7, 2.9)));
+    BOOST_REQUIRE_EQUAL(boxHits.size(), 1);
+    BOOST_CHECK_EQUAL(boxHits[0].section, 1);
+    BOOST_CHECK_EQUAL(boxHits[0].segment, 7);
+    BOOST_CHECK_EQUAL(boxHits[0].distance, 0);
+
+    const auto sphereHits = morphology.intersectSphere(V3f(0, -3.8, 1.8), 1.2);
+    BOOST_REQUIRE_EQUAL(sphereHits.size(), 1);
+    BOOST_CHECK_EQUAL(sphereHits[0].section, 1);
+    BOOST_CHECK_EQUAL(sphereHits[0].segment, 7);
+    BOOST_CHECK(morphology.intersectSphere(V3f(0, -3.8, 1.8), 1.).empty());
+}
+
+BOOST_AUTO_TEST_CASE(segment_index)
+{
+    brain::Matrix4f matrix;
+    matrix.setTranslation(V3f(100, 0, 0));
+    const brion::ConstMorphologyPtr source(
+        new brion::Morphology(TEST_MORPHOLOGY_URI));
+    const brain::neuron::Morphologies morphologies{
+        std::make_shared<brain::neuron::Morphology>(source),
+        std::make_shared<brain::neuron::Morphology>(source, matrix)};
+
+    const brain::neuron::SegmentIndex index(morphologies);
+
+    const auto nearest = index.getNearestSegment(V3f(100, -3.8, 1.8));
+    BOOST_CHECK_EQUAL(nearest.morphology, 1);
+    BOOST_CHECK_EQUAL(nearest.section, 1);
+    BOOST_CHECK_EQUAL(nearest.segment, 7);
+
+    const auto hits = index.intersectRay(V3f(110, -2.8, 2.8), V3f(-1, 0, 0));
+    BOOST_REQUIRE_EQUAL(hits.size(), 2);
+    BOOST_CHECK_EQUAL(hits[0].morphology, 1);
+    BOOST_CHECK_EQUAL(hits[1].morphology, 0);
+    BOOST_CHECK_CLOSE(hits[1].distance - hits[0].distance, 100, 1e-3);
+
+    BOOST_CHECK_EQUAL(index.intersectSphere(V3f(50, 0, 0), 10).size(), 0);
+    BOOST_CHECK_THROW(brain::neuron::SegmentIndex(brain::neuron::Morphologies())
+                          .getNearestSegment(V3f()),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(morphometrics)
+{
+    using brain::neuron::Morphometric;
+
+    brain::Matrix4f matrix;
+    matrix.setTranslation(V3f(100, 0, 0));
+    const brion::ConstMorphologyPtr source(
+        new brion::Morphology(TEST_MORPHOLOGY_URI));
+    const brain::neuron::Morphologies morphologies{
+        std::make_shared<brain::neuron::Morphology>(source),
+        std::make_shared<brain::neuron::Morphology>(source, matrix)};
+
+    const auto columns = brain::neuron::computeMorphometrics(
+        morphologies,
+        {Morphometric::totalLength, Morphometric::sectionCount,
+         Morphometric::bifurcationCount, Morphometric::terminalCount,
+         Morphometric::maxBranchOrder, Morphometric::somaRadius});
+    BOOST_REQUIRE_EQUAL(columns.size(), 6);
+    for (const auto& column : columns)
+    {
+        BOOST_REQUIRE_EQUAL(column.size(), 2);
+        BOOST_CHECK_CLOSE(column[0], column[1], 1e-3);
+    }
+    BOOST_CHECK_CLOSE(columns[0][0], 4 * (5 * std::sqrt(2.f) + 4), 1e-3);
+    BOOST_CHECK_EQUAL(columns[1][0], 12);
+    BOOST_CHECK_EQUAL(columns[2][0], 4);
+    BOOST_CHECK_EQUAL(columns[3][0], 8);
+    BOOST_CHECK_EQUAL(columns[4][0], 2);
+    BOOST_CHECK_CLOSE(columns[5][0], 0.1, 1e-3);
+
+    const auto profiles =
+        brain::neuron::computeShollProfiles(morphologies, 1.f, 10);
+    BOOST_REQUIRE_EQUAL(profiles.size(), 20);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        BOOST_CHECK_EQUAL(profiles[i], i < 7 ? 4 : 0);
+        BOOST_CHECK_EQUAL(profiles[i], profiles[10 + i]);
+    }
+    BOOST_CHECK_THROW(brain::neuron::computeShollProfiles(morphologies, 0, 1),
+                      std::runtime_error);
+}
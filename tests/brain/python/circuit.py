@@ -30,6 +30,14 @@ class TestCircuitOpen(unittest.TestCase):
     def test_open(self):
         circuit = brain.Circuit(brain.test.circuit_config)
 
+    def test_stats(self):
+        circuit = brain.Circuit(brain.test.circuit_config)
+        stats = circuit.stats()
+        assert(stats["config_parse"] >= 0)
+        assert(stats["circuit_open"] == 0)
+        circuit.num_neurons()
+        assert(circuit.stats()["circuit_open"] > 0)
+
 class TestCircuit(unittest.TestCase):
     def setUp(self):
         self.circuit = brain.Circuit(brain.test.circuit_config)
@@ -46,6 +54,33 @@ class TestCircuit(unittest.TestCase):
         assert(len(self.circuit.random_gids(0.1)) == 100)
         assert(len(self.circuit.random_gids(0.1, 'Column')) == 100)
 
+        Stratification = brain.Circuit.Stratification
+        gids = self.circuit.stratified_random_gids(
+            0.1, Stratification.morphology_type)
+        assert(len(gids) >= 100)
+        assert(all(gids[:-1] < gids[1:]))
+        gids = self.circuit.stratified_random_gids(
+            0.5, Stratification.electrophysiology_type, 'Layer1')
+        assert(set(gids) <= set(self.circuit.gids('Layer1')))
+        gids = self.circuit.stratified_random_gids(0.1, ['Column'])
+        assert(len(gids) == 100)
+
+    def test_spatial_queries(self):
+        gids = self.circuit.gids()
+        positions = self.circuit.positions(gids)
+        center = positions[len(gids) // 2]
+        distances = numpy.linalg.norm(positions - center, axis=1)
+
+        low = center - 100
+        high = center + 100
+        expected = gids[numpy.all((positions >= low) & (positions <= high),
+                                  axis=1)]
+        assert(numpy.all(self.circuit.gids_in_box(low, high) == expected))
+        expected = gids[distances <= 100]
+        assert(numpy.all(self.circuit.gids_in_sphere(center, 100) == expected))
+        expected = numpy.sort(gids[numpy.argsort(distances)[:10]])
+        assert(numpy.all(self.circuit.nearest_gids(center, 10) == expected))
+
     def test_iteration_order(self):
 
         def get(functor, *args):
@@ -85,6 +120,18 @@ class TestCircuit(unittest.TestCase):
         assert(positions.shape == (1000, 3))
         assert(rotations.shape == (1000, 4))
 
+        affine = self.circuit.affine_transforms(gids)
+        assert(affine.shape == (1000, 3, 4))
+        assert(numpy.allclose(affine, transforms[:, :3, :], atol=1e-5))
+
+    def test_attribute_cache(self):
+        gids = [1, 7, 100, 1000]
+        positions = self.circuit.positions(gids)
+        uris = self.circuit.morphology_uris(gids)
+        self.circuit.enable_attribute_cache(preload=True)
+        assert((self.circuit.positions(gids) == positions).all())
+        assert(self.circuit.morphology_uris(gids) == uris)
+
     def test_load_morphology(self):
         morphologies = self.circuit.load_morphologies(
             [1, 100, 1000], brain.Circuit.Coordinates.local)
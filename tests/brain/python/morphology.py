@@ -116,6 +116,19 @@ class TestMorphologyFunctions(unittest.TestCase):
         assert(numpy.isclose(soma.mean_radius(), 0.1))
         assert(soma.centroid() == (0, 0, 0))
 
+    def test_morphometrics(self):
+        Metric = brain.neuron.Morphometric
+        morphologies = [self.morphology, Morphology(morphology_path)]
+        columns = brain.neuron.compute_morphometrics(
+            morphologies, [Metric.section_count, Metric.terminal_count])
+        assert(len(columns) == 2)
+        assert(list(columns[0]) == [12, 12])
+        assert(list(columns[1]) == [8, 8])
+
+        profiles = brain.neuron.compute_sholl_profiles(morphologies, 1, 10)
+        assert(profiles.shape == (2, 10))
+        assert(list(profiles[0]) == [4] * 7 + [0] * 3)
+
 class TestMorphologyMemoryManagement(unittest.TestCase):
 
     def setUp(self):
@@ -152,6 +165,8 @@ class TestSectionFunctions(unittest.TestCase):
         assert(self.section.type() == brain.neuron.SectionType.axon)
         assert(numpy.isclose(self.section.children()[0].distance_to_soma(),
                              self.section.length()))
+        assert(self.section.branch_order() == 1)
+        assert(self.section.children()[0].branch_order() == 2)
 
     def test_samples(self):
         distances = self.section.sample_distances_to_soma()
@@ -165,8 +180,10 @@ class TestSectionFunctions(unittest.TestCase):
         assert(self.section.parent() == None)
         children = self.section.children()
         assert(len(children) == 2)
+        assert(self.section.num_children() == 2)
         for child in children:
             assert(child.parent() == self.section)
+            assert(child.num_children() == 0)
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,95 @@
+/* Copyright (c) 2017, EPFL/Blue Brain Project
+ *                          Stefan.Eilemann@epfl.ch
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brion/brion.h>
+
+#define BOOST_TEST_MODULE CompactGIDSet
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+brion::GIDSet _toGIDSet(const brion::uint32_ts& gids)
+{
+    return brion::GIDSet(gids.begin(), gids.end());
+}
+}
+
+BOOST_AUTO_TEST_CASE(construct)
+{
+    const brion::CompactGIDSet empty;
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK_EQUAL(empty.size(), 0);
+    BOOST_CHECK(!empty.contains(1));
+
+    const brion::CompactGIDSet unsorted(brion::uint32_ts{7, 3, 5, 3, 1, 7});
+    const brion::uint32_ts expected{1, 3, 5, 7};
+    BOOST_CHECK_EQUAL_COLLECTIONS(unsorted.begin(), unsorted.end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(unsorted[2], 5);
+    BOOST_CHECK(unsorted.contains(3));
+    BOOST_CHECK(!unsorted.contains(4));
+    BOOST_CHECK(!unsorted.contains(8));
+
+    const brion::GIDSet gids{1, 3, 5, 7};
+    const brion::CompactGIDSet compact(gids);
+    BOOST_CHECK(compact == unsorted);
+    BOOST_CHECK(compact.toGIDSet() == gids);
+}
+
+BOOST_AUTO_TEST_CASE(set_algebra)
+{
+    const brion::uint32_ts odd{1, 3, 5, 7, 9, 11};
+    const brion::uint32_ts low{1, 2, 3, 4, 5};
+    const brion::CompactGIDSet a(odd);
+    const brion::CompactGIDSet b(low);
+
+    const brion::uint32_ts both{1, 3, 5};
+    const brion::uint32_ts either{1, 2, 3, 4, 5, 7, 9, 11};
+    const brion::uint32_ts onlyA{7, 9, 11};
+    BOOST_CHECK(a.intersect(b).getGIDs() == both);
+    BOOST_CHECK(b.intersect(a).getGIDs() == both);
+    BOOST_CHECK(a.unite(b).getGIDs() == either);
+    BOOST_CHECK(a.subtract(b).getGIDs() == onlyA);
+    BOOST_CHECK(a.intersect(brion::CompactGIDSet()).empty());
+    BOOST_CHECK(a.unite(brion::CompactGIDSet()) == a);
+    BOOST_CHECK(a.subtract(brion::CompactGIDSet()) == a);
+}
+
+BOOST_AUTO_TEST_CASE(skewed_intersection)
+{
+    // small sets are intersected by galloping through the large one
+    brion::uint32_ts large(100000);
+    for (size_t i = 0; i < large.size(); ++i)
+        large[i] = uint32_t(i * 3 + 1);
+    const brion::uint32_ts small{1, 2, 4, 3000, 3001, 150001, 299998, 300000};
+
+    brion::uint32_ts expected;
+    std::set_intersection(small.begin(), small.end(), large.begin(),
+                          large.end(), std::back_inserter(expected));
+    BOOST_CHECK_EQUAL(expected.size(), 5);
+
+    const brion::CompactGIDSet a(large);
+    const brion::CompactGIDSet b(small);
+    BOOST_CHECK(a.intersect(b).getGIDs() == expected);
+    BOOST_CHECK(b.intersect(a).getGIDs() == expected);
+    BOOST_CHECK(a.intersect(b).toGIDSet() == _toGIDSet(expected));
+}
@@ -22,9 +22,16 @@
 #include <brion/brion.h>
 
 #define BOOST_TEST_MODULE Mesh
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <string>
+
 BOOST_AUTO_TEST_CASE(test_invalid_open)
 {
     BOOST_CHECK_THROW(brion::Mesh("/bla"), std::runtime_error);
@@ -216,6 +223,54 @@ BOOST_AUTO_TEST_CASE(test_read_binary_v2)
     }
 }
 
+template <typename T>
+void checkView(const brion::ConstSpan<T>& view, const std::vector<T>& vector)
+{
+    BOOST_REQUIRE_EQUAL(view.size(), vector.size());
+    BOOST_CHECK(std::equal(view.begin(), view.end(), vector.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(test_read_binary_views)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= "local/meshes/08.05.09/high/TXT/R-C010306G-v2.bin";
+
+    brion::ConstSpan<brion::Vector3f> vertices;
+    {
+        const brion::Mesh mesh(path.string());
+        vertices = mesh.getVertices();
+        checkView(vertices, *mesh.readVertices());
+        checkView(mesh.getVertexSections(), *mesh.readVertexSections());
+        checkView(mesh.getVertexDistances(), *mesh.readVertexDistances());
+        checkView(mesh.getTriangles(), *mesh.readTriangles());
+        checkView(mesh.getTriStrip(), *mesh.readTriStrip());
+        BOOST_CHECK(mesh.getNormals().empty());
+    }
+
+    // views stay valid after the mesh is closed
+    const brion::Mesh mesh(path.string());
+    checkView(vertices, *mesh.readVertices());
+}
+
+BOOST_AUTO_TEST_CASE(test_load_meshes)
+{
+    boost::filesystem::path path1(BBP_TESTDATA);
+    path1 /= "local/meshes/08.05.09/high/TXT/R-C010306G.bin";
+    boost::filesystem::path path2(BBP_TESTDATA);
+    path2 /= "local/meshes/08.05.09/high/TXT/R-C010306G-v2.bin";
+
+    const brion::Meshes meshes = brion::loadMeshes(
+        {path1.string(), path2.string(), path1.string()});
+    BOOST_REQUIRE_EQUAL(meshes.size(), 3);
+    BOOST_CHECK_EQUAL(meshes[0], meshes[2]);
+    BOOST_CHECK_EQUAL(meshes[0]->getNumVertices(), 38618);
+    BOOST_CHECK_EQUAL(meshes[1]->getNumVertices(), 105394);
+    checkView(meshes[1]->getTriangles(), *meshes[1]->readTriangles());
+
+    BOOST_CHECK_THROW(brion::loadMeshes({path1.string(), "bla"}),
+                      std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(test_write_binary_v2)
 {
     boost::filesystem::path path(BBP_TESTDATA);
@@ -253,3 +308,170 @@ BOOST_AUTO_TEST_CASE(test_write_binary_v2)
     BOOST_CHECK(*triangles == *triangles2);
     BOOST_CHECK(*tristrip == *tristrip2);
 }
+
+BOOST_AUTO_TEST_CASE(test_stream_binary)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= "local/meshes/08.05.09/high/TXT/R-C010306G-v2.bin";
+    const brion::Mesh mesh(path.string());
+
+    const brion::Vector3fsPtr vertices = mesh.readVertices();
+    const brion::uint16_tsPtr vSections = mesh.readVertexSections();
+    const brion::floatsPtr vDistances = mesh.readVertexDistances();
+    const brion::uint32_tsPtr triangles = mesh.readTriangles();
+    const brion::uint32_tsPtr tristrip = mesh.readTriStrip();
+
+    {
+        // small blocks and odd chunks to exercise spooling
+        brion::MeshWriter writer("testmesh_stream.bin", true,
+                                 brion::MESH_VERSION_2, 4096);
+        const size_t chunk = 1000;
+        for (size_t i = 0; i < vertices->size(); i += chunk)
+        {
+            const size_t size = std::min(chunk, vertices->size() - i);
+            writer.addVertices(vertices->data() + i, size);
+            writer.addVertexSections(vSections->data() + i, size);
+            writer.addVertexDistances(vDistances->data() + i, size);
+        }
+        for (size_t i = 0; i < triangles->size(); i += chunk)
+            writer.addTriangles(triangles->data() + i,
+                                std::min(chunk, triangles->size() - i));
+        writer.addTriStrip(*tristrip);
+        BOOST_CHECK_EQUAL(writer.getNumVertices(), vertices->size());
+        BOOST_CHECK_EQUAL(writer.getNumTriangleIndices(), triangles->size());
+        writer.flush();
+        BOOST_CHECK_THROW(writer.addVertices(*vertices), std::runtime_error);
+    }
+
+    const brion::Mesh written("testmesh_stream.bin");
+    BOOST_CHECK_EQUAL(written.getVersion(), brion::MESH_VERSION_2);
+    BOOST_CHECK(*written.readVertices() == *vertices);
+    BOOST_CHECK(*written.readVertexSections() == *vSections);
+    BOOST_CHECK(*written.readVertexDistances() == *vDistances);
+    BOOST_CHECK(*written.readTriangles() == *triangles);
+    BOOST_CHECK(*written.readTriStrip() == *tristrip);
+}
+
+BOOST_AUTO_TEST_CASE(test_stream_binary_invalid)
+{
+    const brion::Vector3fs vertices(3);
+    {
+        // missing vertex attributes are filled with zeros
+        brion::MeshWriter writer("testmesh_stream.bin", true);
+        writer.addVertices(vertices);
+        writer.addTriangles({0, 1, 2});
+    }
+    const brion::Mesh written("testmesh_stream.bin");
+    BOOST_CHECK(*written.readVertexSections() == brion::uint16_ts(3, 0));
+    BOOST_CHECK_EQUAL(written.getNumTriangles(), 1);
+
+    BOOST_CHECK_THROW(brion::MeshWriter("testmesh_stream.bin"),
+                      std::runtime_error);
+
+    brion::MeshWriter outOfRange("testmesh_stream.bin", true);
+    outOfRange.addVertices(vertices);
+    outOfRange.addTriangles({0, 1, 3});
+    BOOST_CHECK_THROW(outOfRange.flush(), std::runtime_error);
+
+    brion::MeshWriter incomplete("testmesh_stream.bin", true);
+    incomplete.addVertices(vertices);
+    incomplete.addTriangles({0, 1});
+    BOOST_CHECK_THROW(incomplete.flush(), std::runtime_error);
+
+    brion::MeshWriter tooMany("testmesh_stream.bin", true);
+    tooMany.addVertices(vertices);
+    tooMany.addVertexDistances(brion::floats(4));
+    BOOST_CHECK_THROW(tooMany.flush(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_write_binary_v3)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= "local/meshes/08.05.09/high/TXT/R-C010306G-v2.bin";
+    const brion::Mesh mesh(path.string());
+
+    const brion::Vector3fsPtr vertices = mesh.readVertices();
+    const brion::uint16_tsPtr vSections = mesh.readVertexSections();
+    const brion::floatsPtr vDistances = mesh.readVertexDistances();
+    const brion::uint32_tsPtr triangles = mesh.readTriangles();
+    const brion::uint32_tsPtr tristrip = mesh.readTriStrip();
+
+    {
+        brion::Mesh a("testmesh_v3.bin", brion::MESHFORMAT_BINARY, true,
+                      brion::MESH_VERSION_3);
+        a.writeVertices(*vertices);
+        a.writeVertexSections(*vSections);
+        a.writeVertexDistances(*vDistances);
+        a.writeTriangles(*triangles);
+        a.writeTriStrip(*tristrip);
+    }
+    BOOST_CHECK_LT(boost::filesystem::file_size("testmesh_v3.bin"),
+                   boost::filesystem::file_size(path) / 2);
+
+    const brion::Mesh compressed("testmesh_v3.bin");
+    BOOST_CHECK_EQUAL(compressed.getVersion(), brion::MESH_VERSION_3);
+    BOOST_CHECK_EQUAL(compressed.getNumVertices(), vertices->size());
+    BOOST_CHECK_EQUAL(compressed.getNumTriangles(), triangles->size() / 3);
+    BOOST_CHECK_EQUAL(compressed.getTriStripLength(), tristrip->size());
+
+    // indices and sections are lossless
+    BOOST_CHECK(*compressed.readVertexSections() == *vSections);
+    BOOST_CHECK(*compressed.readTriangles() == *triangles);
+    BOOST_CHECK(*compressed.readTriStrip() == *tristrip);
+    BOOST_CHECK(compressed.getTriangles().size() == triangles->size());
+
+    // positions and distances are within half a quantization step
+    brion::Vector3f min = (*vertices)[0];
+    brion::Vector3f max = min;
+    for (const brion::Vector3f& vertex : *vertices)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            min[i] = std::min(min[i], vertex[i]);
+            max[i] = std::max(max[i], vertex[i]);
+        }
+    }
+    const brion::Vector3fsPtr vertices2 = compressed.readVertices();
+    BOOST_REQUIRE_EQUAL(vertices2->size(), vertices->size());
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const float tolerance = (max[i] - min[i]) / 65535.f * 0.51f;
+        float error = 0.f;
+        for (size_t j = 0; j < vertices->size(); ++j)
+            error = std::max(error,
+                             std::abs((*vertices2)[j][i] - (*vertices)[j][i]));
+        BOOST_CHECK_LE(error, tolerance);
+    }
+
+    const auto range =
+        std::minmax_element(vDistances->begin(), vDistances->end());
+    const float tolerance = (*range.second - *range.first) / 65535.f * 0.51f;
+    const brion::floatsPtr vDistances2 = compressed.readVertexDistances();
+    BOOST_REQUIRE_EQUAL(vDistances2->size(), vDistances->size());
+    float error = 0.f;
+    for (size_t i = 0; i < vDistances->size(); ++i)
+        error = std::max(error, std::abs((*vDistances2)[i] - (*vDistances)[i]));
+    BOOST_CHECK_LE(error, tolerance);
+
+    // array sizes that would wrap the offsets are rejected, not mapped
+    {
+        std::ifstream in("testmesh_v3.bin", std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+        const uint64_t sectionBytes = ~uint64_t(0) - 64;
+        // MeshCompressedHeader::sectionBytes
+        data.replace(56, sizeof(sectionBytes),
+                     reinterpret_cast<const char*>(&sectionBytes),
+                     sizeof(sectionBytes));
+        std::ofstream("testmesh_v3_corrupt.bin", std::ios::binary) << data;
+    }
+    BOOST_CHECK_THROW(brion::Mesh("testmesh_v3_corrupt.bin"),
+                      std::runtime_error);
+
+    BOOST_CHECK_THROW(brion::Mesh("testmesh_v3.h5", brion::MESHFORMAT_HDF5,
+                                  true, brion::MESH_VERSION_3),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(brion::MeshWriter("testmesh_v3.bin", true,
+                                        brion::MESH_VERSION_3),
+                      std::runtime_error);
+}
@@ -32,7 +32,13 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdarg>
+#include <cstring>
+#include <fstream>
+#include <thread>
 
 // typedef for brevity
 typedef brion::Vector4f V4f;
@@ -178,6 +184,97 @@ BOOST_AUTO_TEST_CASE(move_morphology)
     _checkH5V2(morphology);
 }
 
+BOOST_AUTO_TEST_CASE(serialize_morphology)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= "local/morphologies/14.07.10_repaired/v2/C010398B-P2.h5";
+
+    const brion::Morphology morphology{brion::URI(path.string())};
+    const servus::Serializable::Data data = morphology.toBinary();
+
+    const brion::MorphologyBinaryHeader* header =
+        brion::binary::getHeader(data.ptr.get(), data.size);
+    BOOST_REQUIRE(header);
+    BOOST_CHECK(brion::binary::verify(*header));
+    BOOST_CHECK_EQUAL(header->size, data.size);
+    for (const auto& array : header->arrays)
+        BOOST_CHECK_EQUAL(array.offset % brion::MORPHOLOGY_BINARY_ALIGNMENT,
+                          0);
+
+    const brion::Vector4f* points = brion::binary::getArray<brion::Vector4f>(
+        *header, brion::MorphologyBinaryHeader::ARRAY_POINTS);
+    BOOST_CHECK_EQUAL(header->arrays[0].count, morphology.getPoints().size());
+    BOOST_CHECK_EQUAL(points[42], morphology.getPoints()[42]);
+
+    const brion::Morphology copy(data.ptr.get(), data.size);
+    _checkH5V2(copy);
+
+    // corrupt payload is rejected by the checksum
+    std::vector<uint8_t> corrupt(
+        static_cast<const uint8_t*>(data.ptr.get()),
+        static_cast<const uint8_t*>(data.ptr.get()) + data.size);
+    corrupt.back() ^= 0xFF;
+    BOOST_CHECK_THROW(brion::Morphology(corrupt.data(), corrupt.size()),
+                      std::runtime_error);
+
+    // truncated data is rejected by the header
+    BOOST_CHECK_THROW(brion::Morphology(data.ptr.get(), data.size / 2),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(serialize_morphology_batch)
+{
+    boost::filesystem::path path(BRION_TESTDATA);
+    path /= "swc/end_points.swc";
+
+    const brion::Morphology morphology{brion::URI(path.string())};
+    const servus::Serializable::Data data = morphology.toBinary();
+    const servus::Serializable::Data batch =
+        brion::binary::packBatch({data, servus::Serializable::Data(), data});
+
+    const brion::MorphologyBatchHeader* header =
+        brion::binary::getBatchHeader(batch.ptr.get(), batch.size);
+    BOOST_REQUIRE(header);
+    BOOST_CHECK_EQUAL(header->size, batch.size);
+    BOOST_REQUIRE_EQUAL(header->count, 3);
+
+    const auto entries = brion::binary::getBatchEntries(*header);
+    BOOST_CHECK_EQUAL(entries[1].size, 0);
+    for (const size_t i : {0, 2})
+    {
+        BOOST_CHECK_EQUAL(entries[i].offset %
+                              brion::MORPHOLOGY_BINARY_ALIGNMENT,
+                          0);
+        BOOST_REQUIRE_EQUAL(entries[i].size, data.size);
+
+        const uint8_t* ptr =
+            static_cast<const uint8_t*>(batch.ptr.get()) + entries[i].offset;
+        const brion::Morphology copy(ptr, entries[i].size);
+        BOOST_CHECK(copy.getPoints() == morphology.getPoints());
+        BOOST_CHECK(copy.getSections() == morphology.getSections());
+    }
+
+    BOOST_CHECK(!brion::binary::getBatchHeader(batch.ptr.get(),
+                                               batch.size - 1));
+    BOOST_CHECK(!brion::binary::getBatchHeader(data.ptr.get(), data.size));
+
+    // a size smaller than the header must not wrap the entry count check
+    const uint8_t* begin = static_cast<const uint8_t*>(batch.ptr.get());
+    std::vector<uint8_t> lying(begin, begin + batch.size);
+    auto lyingHeader = reinterpret_cast<brion::MorphologyBatchHeader*>(
+        lying.data());
+    lyingHeader->size = sizeof(brion::MorphologyBatchHeader) - 1;
+    BOOST_CHECK(!brion::binary::getBatchHeader(lying.data(), lying.size()));
+
+    // entries must not point into the header or the entry table
+    lyingHeader->size = batch.size;
+    BOOST_CHECK(brion::binary::getBatchHeader(lying.data(), lying.size()));
+    auto lyingEntries = reinterpret_cast<brion::MorphologyBatchHeader::Entry*>(
+        lyingHeader + 1);
+    lyingEntries[0].offset = 0;
+    BOOST_CHECK(!brion::binary::getBatchHeader(lying.data(), lying.size()));
+}
+
 #ifdef BRION_USE_ZEROEQ
 BOOST_AUTO_TEST_CASE(zeroeq_read)
 {
@@ -206,6 +303,90 @@ BOOST_AUTO_TEST_CASE(zeroeq_read)
 
     _checkH5V2(morphology);
 }
+
+BOOST_AUTO_TEST_CASE(zeroeq_read_pipelined)
+{
+    const auto serialize = [](const std::string& path) {
+        try
+        {
+            return brion::Morphology{brion::URI(path)}.toBinary();
+        }
+        catch (const std::runtime_error&)
+        {
+            return servus::Serializable::Data();
+        }
+    };
+
+    std::atomic<size_t> numPaths{0};
+    std::atomic<size_t> numBatches{0};
+    zeroeq::Server server(zeroeq::NULL_SESSION);
+    server.handle(brion::ZEROEQ_GET_MORPHOLOGY,
+                  [&](const void* data, const size_t size) {
+                      const std::string path((const char*)data, size);
+                      ++numPaths;
+                      const auto value = serialize(path);
+                      if (!value.ptr)
+                          return zeroeq::ReplyData();
+                      return zeroeq::ReplyData(brion::ZEROEQ_GET_MORPHOLOGY,
+                                               value);
+                  });
+    server.handle(brion::ZEROEQ_GET_MORPHOLOGIES,
+                  [&](const void* data, const size_t size) {
+                      ++numBatches;
+                      std::vector<servus::Serializable::Data> values;
+                      const char* path = (const char*)data;
+                      for (; path < (const char*)data + size;
+                           path += ::strlen(path) + 1)
+                      {
+                          ++numPaths;
+                          values.push_back(serialize(path));
+                      }
+                      return zeroeq::ReplyData(
+                          brion::ZEROEQ_GET_MORPHOLOGIES,
+                          brion::binary::packBatch(values));
+                  });
+
+    std::atomic<bool> running{true};
+    std::thread thread([&] {
+        while (running)
+            server.receive(100);
+    });
+
+    const std::string prefix =
+        std::string("zeroeq://") + server.getURI().getHost() + ":" +
+        std::to_string(int(server.getURI().getPort()));
+    const std::vector<std::string> names{"Neuron.swc", "bifurcations.swc",
+                                         "end_points.swc", "fork_points.swc",
+                                         "soma.swc", "not_found.swc"};
+    std::vector<std::unique_ptr<brion::Morphology>> morphologies;
+    for (const auto& name : names)
+    {
+        boost::filesystem::path path(BRION_TESTDATA);
+        path /= "swc/" + name;
+        morphologies.emplace_back(
+            new brion::Morphology(brion::URI(prefix + path.string())));
+    }
+
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        boost::filesystem::path path(BRION_TESTDATA);
+        path /= "swc/" + names[i];
+        if (names[i] == "not_found.swc")
+        {
+            BOOST_CHECK_THROW(morphologies[i]->getPoints(), std::runtime_error);
+            continue;
+        }
+        const brion::Morphology reference{brion::URI(path.string())};
+        BOOST_CHECK(morphologies[i]->getPoints() == reference.getPoints());
+        BOOST_CHECK(morphologies[i]->getSections() == reference.getSections());
+    }
+    BOOST_CHECK_EQUAL(numPaths.load(), names.size());
+    // paths queued behind the first request are sent as one batch
+    BOOST_CHECK_GT(numBatches.load(), 0);
+
+    running = false;
+    thread.join();
+}
 #endif
 
 BOOST_AUTO_TEST_CASE(swc_invalid_open)
@@ -382,6 +563,33 @@ BOOST_AUTO_TEST_CASE(swc_single_section_unordered)
     checkEqualArrays(source.getSectionTypes(), 2, SOMA, AXON);
 }
 
+BOOST_AUTO_TEST_CASE(swc_line_formats)
+{
+    // single_section.swc with comments, leading white space, tab separators,
+    // CRLF line endings and an unterminated last line
+    const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("%%%%-%%%%-%%%%.swc");
+    {
+        std::ofstream file(path.string(), std::ios::binary);
+        file << "# comment\r\n"
+                "\r\n"
+                "  # indented comment\r\n"
+                "1 1 0 0 0 10 -1\r\n"
+                "\t2\t2\t0\t0\t1\t2\t1\r\n"
+                "  3 2 0 0 2 2 2\r\n"
+                "4  2 \t0 0 3 2 3 \r\n"
+                "5 2 0 0 4 2 4";
+    }
+
+    const brion::Morphology source{brion::URI(path.string())};
+    checkEqualArrays(source.getPoints(), 5, V4f(0, 0, 0, 20), V4f(0, 0, 1, 4),
+                     V4f(0, 0, 2, 4), V4f(0, 0, 3, 4), V4f(0, 0, 4, 4));
+    checkEqualArrays(source.getSections(), 2, V2i(0, -1), V2i(1, 0));
+    checkEqualArrays(source.getSectionTypes(), 2, SOMA, AXON);
+    boost::filesystem::remove(path);
+}
+
 BOOST_AUTO_TEST_CASE(swc_single_section_missing_segment)
 {
     boost::filesystem::path path(BRION_TESTDATA);
@@ -489,6 +697,102 @@ BOOST_AUTO_TEST_CASE(swc_fork_points)
                      AXON, AXON, AXON);
 }
 
+BOOST_AUTO_TEST_CASE(flat_morphology)
+{
+    boost::filesystem::path path(BRION_TESTDATA);
+    path /= "swc/end_points.swc";
+
+    const brion::Morphology source{brion::URI(path.string())};
+    const brion::FlatMorphology flat(source);
+
+    const auto& points = source.getPoints();
+    BOOST_REQUIRE_EQUAL(flat.getNumPoints(), points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(V4f(flat.getX()[i], flat.getY()[i], flat.getZ()[i],
+                              flat.getDiameters()[i]),
+                          points[i]);
+    }
+
+    const auto& sections = source.getSections();
+    BOOST_REQUIRE_EQUAL(flat.getNumSections(), sections.size());
+    BOOST_REQUIRE_EQUAL(flat.getSectionOffsets().size(), sections.size() + 1);
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(flat.getSectionOffsets()[i], sections[i][0]);
+        BOOST_CHECK_EQUAL(flat.getParents()[i], sections[i][1]);
+        BOOST_CHECK_EQUAL(flat.getSectionTypes()[i],
+                          source.getSectionTypes()[i]);
+    }
+    BOOST_CHECK_EQUAL(flat.getSectionOffsets()[sections.size()],
+                      points.size());
+
+    const brion::uint32_ts offsets = {0, 3, 3, 3, 5, 5, 5};
+    const brion::uint32_ts children = {1, 2, 3, 4, 5};
+    BOOST_CHECK_EQUAL_COLLECTIONS(flat.getChildOffsets().begin(),
+                                  flat.getChildOffsets().end(),
+                                  offsets.begin(), offsets.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(flat.getChildIndices().begin(),
+                                  flat.getChildIndices().end(),
+                                  children.begin(), children.end());
+    BOOST_CHECK_EQUAL(flat.getChildren(3).size(), 2);
+    BOOST_CHECK_EQUAL(flat.getChildren(3)[1], 5);
+    BOOST_CHECK(flat.getChildren(5).empty());
+}
+
+BOOST_AUTO_TEST_CASE(swc_simplify)
+{
+    boost::filesystem::path path(BRION_TESTDATA);
+    path /= "swc/Neuron.swc";
+
+    const brion::Morphology source{brion::URI(path.string())};
+    brion::MorphologyLODs lods(3);
+    lods[1].tolerance = .5f;
+    lods[2].tolerance = 2.f;
+    const brion::Morphologies levels = brion::simplify(source, lods);
+    BOOST_REQUIRE_EQUAL(levels.size(), 3);
+
+    const auto& sections = source.getSections();
+    size_t previous = source.getPoints().size();
+    for (const auto& level : levels)
+    {
+        BOOST_CHECK_LE(level->getPoints().size(), previous);
+        previous = level->getPoints().size();
+
+        // all sections are kept with their end points
+        BOOST_REQUIRE_EQUAL(level->getSections().size(), sections.size());
+        BOOST_CHECK(level->getSectionTypes() == source.getSectionTypes());
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(level->getSections()[i][1], sections[i][1]);
+            BOOST_CHECK_EQUAL(level->getPoints()[level->getSections()[i][0]],
+                              source.getPoints()[sections[i][0]]);
+        }
+    }
+    BOOST_CHECK_LT(levels[2]->getPoints().size(),
+                   source.getPoints().size() / 2);
+
+    brion::MorphologyLOD pruned;
+    pruned.maxBranchOrder = 1;
+    const brion::MorphologyPtr firstOrder = brion::simplify(source, pruned);
+    BOOST_CHECK_LT(firstOrder->getSections().size(), sections.size());
+    for (const auto& section : firstOrder->getSections())
+    {
+        if (section[1] != -1)
+            BOOST_CHECK_EQUAL(
+                firstOrder->getSectionTypes()[section[1]],
+                brion::SECTION_SOMA);
+    }
+    BOOST_CHECK_NE(pruned.getKey(), brion::MorphologyLOD().getKey());
+
+    // parameters differing beyond the default stream precision
+    brion::MorphologyLOD coarse;
+    coarse.tolerance = 1.f;
+    brion::MorphologyLOD close = coarse;
+    close.tolerance = std::nextafter(coarse.tolerance, 2.f);
+    BOOST_CHECK_NE(close.getKey(), coarse.getKey());
+}
+
 BOOST_AUTO_TEST_CASE(swc_neuron)
 {
     boost::filesystem::path path(BRION_TESTDATA);
@@ -499,3 +803,48 @@ BOOST_AUTO_TEST_CASE(swc_neuron)
     BOOST_CHECK_EQUAL(neuron.getCellFamily(), brion::FAMILY_NEURON);
     BOOST_CHECK(neuron.getPerimeters().empty());
 }
+
+BOOST_AUTO_TEST_CASE(swc_load_morphologies)
+{
+    brion::URIs uris;
+    for (const auto& name : {"Neuron.swc", "soma.swc", "bifurcations.swc"})
+    {
+        boost::filesystem::path path(BRION_TESTDATA);
+        path /= std::string("swc/") + name;
+        uris.push_back(brion::URI(path.string()));
+    }
+    uris.push_back(uris[0]);
+
+    brion::MorphologyLoadOptions options;
+    options.maxThreads = 2;
+    const brion::Morphologies morphologies =
+        brion::loadMorphologies(uris, options);
+    BOOST_REQUIRE_EQUAL(morphologies.size(), uris.size());
+    BOOST_CHECK_EQUAL(morphologies[0], morphologies[3]);
+    for (size_t i = 0; i < uris.size(); ++i)
+    {
+        const brion::Morphology reference(uris[i]);
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            morphologies[i]->getPoints().begin(),
+            morphologies[i]->getPoints().end(), reference.getPoints().begin(),
+            reference.getPoints().end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(morphologies[i]->getSections().begin(),
+                                      morphologies[i]->getSections().end(),
+                                      reference.getSections().begin(),
+                                      reference.getSections().end());
+    }
+
+    std::vector<size_t> indices;
+    brion::loadMorphologies(uris, [&](const size_t index,
+                                      brion::MorphologyPtr morphology) {
+        BOOST_CHECK_EQUAL(morphology->getPoints().size(),
+                          morphologies[index]->getPoints().size());
+        indices.push_back(index);
+    });
+    std::sort(indices.begin(), indices.end());
+    BOOST_CHECK_EQUAL(indices.size(), uris.size());
+    BOOST_CHECK(std::unique(indices.begin(), indices.end()) == indices.end());
+
+    uris.push_back(brion::URI("not_found.swc"));
+    BOOST_CHECK_THROW(brion::loadMorphologies(uris), std::runtime_error);
+}
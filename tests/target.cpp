@@ -26,6 +26,8 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <fstream>
+
 BOOST_AUTO_TEST_CASE(invalid_open)
 {
     BOOST_CHECK_THROW(brion::Target("blub"), std::runtime_error);
@@ -91,3 +93,57 @@ BOOST_AUTO_TEST_CASE(parseBroken)
 
     BOOST_CHECK_EQUAL(column.size(), 1000);
 }
+
+BOOST_AUTO_TEST_CASE(parseNested)
+{
+    {
+        std::ofstream file("nested.target");
+        file << "# comment { Target Cell Commented { a1 } \n"
+                "Target Cell Column\n{\n  Layer1 Layer2 a9 # trailing\n}\n"
+                "Target Cell Layer1 { a3 a1 a2 a1 }\n"
+                "Target Cell Layer2\n{\n a5 a4\n Layer1\n}\n"
+                "Target Cell Cycle { Cycle2 }\n"
+                "Target Cell Cycle2 { a1 Cycle }\n";
+    }
+    const brion::Target target("nested.target");
+    BOOST_CHECK(!target.contains("Commented"));
+    BOOST_CHECK_EQUAL(target.getTargetNames(brion::TARGET_CELL).size(), 5);
+    BOOST_CHECK_EQUAL(target.get("Layer2").size(), 3);
+
+    const brion::Targets targets(1, target);
+    const brion::GIDSet expected{1, 2, 3, 4, 5, 9};
+    for (size_t i = 0; i < 2; ++i) // resolved, then cached
+    {
+        const brion::GIDSet& column = brion::Target::parse(targets, "Column");
+        BOOST_CHECK_EQUAL_COLLECTIONS(column.begin(), column.end(),
+                                      expected.begin(), expected.end());
+    }
+    BOOST_CHECK_THROW(brion::Target::parse(targets, "Cycle"),
+                      std::runtime_error);
+
+    // the first target file defining a subtarget takes precedence
+    {
+        std::ofstream file("override.target");
+        file << "Target Cell Layer1 { a42 }\n";
+    }
+    const brion::Targets overridden{brion::Target("override.target"), target};
+    const brion::GIDSet& column = brion::Target::parse(overridden, "Column");
+    const brion::GIDSet expected2{4, 5, 9, 42};
+    BOOST_CHECK_EQUAL_COLLECTIONS(column.begin(), column.end(),
+                                  expected2.begin(), expected2.end());
+
+    // resolutions cached against a destroyed target file are not reused for
+    // another one, even if it is allocated at the same address
+    for (size_t i = 0; i < 8; ++i)
+    {
+        {
+            std::ofstream file("override.target");
+            file << "Target Cell Layer1 { a" << 100 + i << " }\n";
+        }
+        const brion::Targets reloaded{brion::Target("override.target"),
+                                      target};
+        const brion::GIDSet& gids = brion::Target::parse(reloaded, "Column");
+        BOOST_CHECK_EQUAL(gids.count(100 + i), 1);
+        BOOST_CHECK_EQUAL(gids.size(), 4);
+    }
+}